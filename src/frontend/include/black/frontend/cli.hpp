@@ -82,6 +82,9 @@ namespace black::frontend
     // disable the PRUNE rule
     inline bool semi_decision = false;
 
+    // use the time-indexed encoding for first-order symbols
+    inline bool timed_encoding = false;
+
     // past removing before executing the SAT-encoding (disabled by default)
     inline bool remove_past = false;
 
@@ -97,12 +100,21 @@ namespace black::frontend
     // the input trace to be checked
     inline std::string trace;
 
+    // directory or index file of the traces to check in a batch
+    inline std::optional<std::string> traces;
+
     // the expected result when doing trace checking
     inline std::optional<std::string> expected_result;
 
     // initial state for the evaluation of the formula in trace checking mode
     inline std::optional<size_t> initial_state;
 
+    // whether we are in monitoring mode
+    inline bool monitoring = false;
+
+    // number of states to wait for before each verdict in monitoring mode
+    inline std::optional<size_t> lookahead;
+
     // verbose output
     inline bool verbose = false;
 
@@ -115,6 +127,12 @@ namespace black::frontend
     // compute the unsat core
     inline bool unsat_core = false;
 
+    // factor of the bound for the checks of the unsat core extraction
+    inline std::optional<size_t> unsat_core_bound;
+
+    // directory where to dump the SMT-LIB queries made by the solver
+    inline std::optional<std::string> dump_smtlib;
+
     // debug options
     inline std::string debug;
   }
@@ -145,7 +145,12 @@ namespace black::frontend
       option("-m", "--model").set(cli::print_model)
         % "print the model of the formula, if any",
       option("-c", "--unsat-core").set(cli::unsat_core)
-        % "for unsatisfiable formulas, compute the minimum unsat core",
+        % "for unsatisfiable formulas, compute a minimal unsat core",
+      (option("--unsat-core-bound") 
+        & clipp::integer("factor", cli::unsat_core_bound))
+        % "bound the checks of the unsat core extraction to the given "
+          "multiple of the bound needed to refute the whole formula, "
+          "trading the minimality of the core for speed",
       (option("-d", "--default-sort")
         & value("sort", cli::default_sort))
         % "select the default-sort for first-order variables.\n"
@@ -155,6 +160,10 @@ namespace black::frontend
         % "disable termination checks for unsatisfiable formulas, speeding up "
           "the execution for satisfiable ones.\n"
           "Note: the use of `next(x)` terms in formulas implies this option.",
+      option("--timed-encoding").set(cli::timed_encoding)
+        % "encode first-order variables, functions and relations as single "
+          "uninterpreted functions of the time step instead of making fresh "
+          "symbols at each step",
       (option("-o", "--output-format") 
         & value(is_output_format, "fmt", cli::output_format))
         % "Output format.\n"
@@ -165,6 +174,9 @@ namespace black::frontend
         % "Timeout (in seconds)",
       (option("-f", "--formula") & value("formula", cli::formula))
         % "LTL formula to solve",
+      (option("--dump-smtlib") & value("dir", cli::dump_smtlib))
+        % "write the queries made at each bound to an incremental SMT-LIB "
+          "script in the given directory",
       option("--debug") & value("debug", cli::debug),
       value("file", cli::filename).required(false)
           % "input formula file name.\n"
@@ -172,9 +184,12 @@ namespace black::frontend
     ) |
     "trace checking mode: " % (
       command("check").set(cli::trace_checking), 
-      (required("-t","--trace") & value("trace", cli::trace))
+      (option("-t","--trace") & value("trace", cli::trace))
         % "trace file to check against the formula.\n"
           "If '-', reads from standard input.",
+      (option("--traces") & value("dir", cli::traces))
+        % "directory of trace files, or file listing one trace file per "
+          "line, to check in parallel against the formula",
       (option("-e", "--expected") & value("result", cli::expected_result))
         % "expected result (useful in testing)",
       (option("-i", "--initial-state") & value("state", cli::initial_state))
@@ -192,6 +207,21 @@ namespace black::frontend
         % "formula against which to check the trace",
       value("file", cli::filename).required(false)
         % "formula file against which to check the trace"
+    ) |
+    "monitoring mode: " % (
+      command("monitor").set(cli::monitoring), 
+      (option("-t","--trace") & value("trace", cli::trace))
+        % "file with the states to monitor, one JSON object per line.\n"
+          "Default: standard input",
+      (option("-l", "--lookahead") & value("states", cli::lookahead))
+        % "number of states to wait for before giving the verdict for a "
+          "state. Default: 0",
+      option("--finite").set(cli::finite)
+        % "treat the end of the input as the end of the trace",
+      (option("-f", "--formula") & value("formula", cli::formula))
+        % "formula to monitor",
+      value("file", cli::filename).required(false)
+        % "file of the formula to monitor"
     ) | command("--sat-backends").set(show_backends) 
           % "print the list of available SAT backends"
       | command("-v", "--version").set(version)
@@ -24,6 +24,7 @@
 #include <black/frontend/cli.hpp>
 #include <black/frontend/solve.hpp>
 #include <black/frontend/tracecheck.hpp>
+#include <black/frontend/monitor.hpp>
 
 using namespace black::frontend;
 
@@ -33,6 +34,9 @@ int main(int argc, char **argv)
   
   if(cli::trace_checking)
     return trace_check();
+
+  if(cli::monitoring)
+    return monitor();
   
   return solve();
 }
@@ -0,0 +1,185 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2021 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/frontend/monitor.hpp>
+#include <black/frontend/io.hpp>
+#include <black/frontend/support.hpp>
+
+#include <black/logic/logic.hpp>
+#include <black/logic/parser.hpp>
+#include <black/solver/tracecheck.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <optional>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace black::frontend 
+{
+  static bool failed = false;
+
+  static void print_verdict(size_t t, tribool verdict) {
+    if(verdict == false)
+      failed = true;
+
+    io::println(
+      "{}: {}", t, 
+      verdict == true ? "TRUE" : verdict == false ? "FALSE" : "UNKNOWN"
+    );
+    std::fflush(stdout);
+  }
+
+  //
+  // Reads the states one per line, as JSON objects in the same format of the
+  // states of the models given by `black solve -o json`. Values can also be
+  // plain JSON booleans. Undefined and missing propositions are taken to
+  // hold, as in trace checking mode.
+  //
+  static int monitor(
+    std::optional<std::string> const&path,
+    std::istream &file,
+    std::optional<std::string> const&tracepath,
+    std::istream &tracefile
+  ) {
+    black::alphabet sigma;
+    
+    std::optional<formula> f = 
+      black::parse_formula(sigma, file, formula_syntax_error_handler(path));
+
+    black_assert(f.has_value());
+
+    if(formula_features(*f) & feature_t::first_order) {
+      command_line_error("first-order formulas cannot be monitored");
+      quit(status_code::command_line_error);
+    }
+
+    black::monitor mon{*f, cli::lookahead.value_or(0)};
+
+    std::unordered_map<std::string, size_t> indexes;
+    for(proposition p : mon.propositions()) {
+      black_assert(p.name().to<std::string>().has_value());
+      indexes.insert({*p.name().to<std::string>(), indexes.size()});
+    }
+
+    std::string name = tracepath ? *tracepath : "<stdin>";
+    std::vector<bool> state(indexes.size());
+    size_t lines = 0;
+    size_t t = 0;
+    std::string line;
+    while(std::getline(tracefile, line)) {
+      lines++;
+      if(line.find_first_not_of(" \t\r") == std::string::npos)
+        continue;
+
+      std::fill(state.begin(), state.end(), true);
+      try {
+        json jstate = json::parse(line);
+        if(!jstate.is_object())
+          io::fatal(
+            status_code::syntax_error, "{}:{}: expected a JSON object", 
+            name, lines
+          );
+
+        for(auto it = jstate.begin(); it != jstate.end(); ++it) {
+          bool value = true;
+          if(it.value().is_boolean())
+            value = it.value().get<bool>();
+          else {
+            std::string v = it.value().get<std::string>();
+            if(v != "undef" && v != "true" && v != "false")
+              io::fatal(
+                status_code::syntax_error, 
+                "{}:{}: invalid proposition value", name, lines
+              );
+            value = v != "false";
+          }
+
+          if(auto index = indexes.find(it.key()); index != indexes.end())
+            state[index->second] = value;
+        }
+      } catch (json::exception& ex) {
+        io::fatal(
+          status_code::syntax_error, "{}:{}: {}", name, lines, ex.what()
+        );
+      }
+
+      std::optional<tribool> verdict = mon.push(state);
+      if(verdict)
+        print_verdict(t++, *verdict);
+    }
+
+    for(tribool verdict : mon.finish(cli::finite))
+      print_verdict(t++, verdict);
+
+    if(failed)
+      quit(status_code::failed_check);
+
+    return 0;
+  }
+
+  int monitor() {
+    if(!cli::filename && !cli::formula) {
+      command_line_error("please specify a filename or the --formula option");
+      quit(status_code::command_line_error);
+    }
+
+    if(cli::filename && cli::formula) {
+      command_line_error(
+        "please specify only either a filename or the --formula option"
+      );
+      quit(status_code::command_line_error);
+    }
+
+    bool from_stdin = cli::trace.empty() || cli::trace == "-";
+    if(cli::filename == "-" && from_stdin) {
+      command_line_error(
+        "cannot read from stdin both the formula file and the trace"
+      );
+      quit(status_code::command_line_error);
+    }
+
+    std::optional<std::ifstream> tracefile;
+    std::optional<std::string> tracepath;
+    if(!from_stdin) {
+      tracefile = open_file(cli::trace);
+      tracepath = cli::trace;
+    }
+    std::istream &trace = tracefile ? *tracefile : std::cin;
+
+    if(cli::formula) {
+      std::istringstream str{*cli::formula};
+      return monitor(std::nullopt, str, tracepath, trace);
+    }
+
+    if(cli::filename == "-")
+      return monitor(std::nullopt, std::cin, tracepath, trace);
+
+    std::ifstream file = open_file(*cli::filename);
+    return monitor(cli::filename, file, tracepath, trace);
+  }
+}
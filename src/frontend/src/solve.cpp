@@ -33,13 +33,17 @@
 #include <black/logic/parser.hpp>
 #include <black/logic/prettyprint.hpp>
 #include <black/logic/past_remover.hpp>
+#include <black/logic/cnf.hpp>
 #include <black/solver/solver.hpp>
 #include <black/solver/core.hpp>
 #include <black/sat/solver.hpp>
 
+#include <filesystem>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
+#include <variant>
 
 namespace black::frontend {
 
@@ -51,6 +55,13 @@ namespace black::frontend {
 
   void trace(black::solver::trace_t data);
 
+  std::ofstream open_dump_file(std::optional<std::string> const&path);
+
+  void dump_smtlib(
+    smtlib2_script &script, black::solver::trace_t data, 
+    std::optional<formula> &empty
+  );
+
   int solve() {
     if(!cli::filename && !cli::formula) {
       command_line_error("please specify a filename or the --formula option");
@@ -175,9 +186,23 @@ namespace black::frontend {
     black::solver slv;
 
     slv.set_sat_backend(backend);
+    slv.set_timed_encoding(cli::timed_encoding);
+
+    std::ofstream dump_file;
+    std::optional<smtlib2_script> dump;
+    std::optional<formula> dumped_empty;
+    if(cli::dump_smtlib) {
+      dump_file = open_dump_file(path);
+      dump.emplace(dump_file);
+    }
 
-    if(!cli::debug.empty())
-      slv.set_tracer(&trace);
+    if(!cli::debug.empty() || dump)
+      slv.set_tracer([&](black::solver::trace_t data) {
+        if(!cli::debug.empty())
+          trace(data);
+        if(dump)
+          dump_smtlib(*dump, data, dumped_empty);
+      });
 
     if (cli::remove_past)
       f = black::remove_past(*f);
@@ -201,7 +226,10 @@ namespace black::frontend {
 
     std::optional<formula> muc;
     if(res == false && cli::unsat_core) {
-      muc = unsat_core(xi, *f, cli::finite);
+      muc = unsat_core(
+        xi, *f, cli::finite, std::thread::hardware_concurrency(),
+        cli::unsat_core_bound
+      );
     }
 
     output(res, slv, *f, muc);
@@ -214,14 +242,10 @@ namespace black::frontend {
   {
     using namespace black;
 
-    for_each_child(f, overloaded {
-      [&](formula child) { 
-        child.match(
-          [&](proposition p) { props.insert(p); },
-          [&](otherwise) { relevant_props(child, props); }
-        );
-      },
-      [](otherwise) { black_unreachable(); } // LCOV_EXCL_LINE
+    fold<std::monostate>(f, [&](formula child, auto const&) { 
+      if(auto p = child.to<proposition>(); p)
+        props.insert(*p);
+      return std::monostate{};
     });
   }
 
@@ -244,6 +268,10 @@ namespace black::frontend {
         print_uc_replacements(left, last_index);
         print_uc_replacements(right, last_index);
       },
+      [&](nary, auto operands) {
+        for(formula op : operands)
+          print_uc_replacements(op, last_index);
+      },
       [](otherwise) { black_unreachable(); } // LCOV_EXCL_LINE
     );
   }
@@ -437,7 +465,10 @@ namespace black::frontend {
 
       black_assert(data.xi);
 
-      file << to_smtlib2(std::get<formula>(data.data), *data.xi) << "\n";
+      print_smtlib2(
+        file, std::get<formula>(data.data), *data.xi, print_sharing::let
+      );
+      file << "\n";
     }
 
     if(cli::debug != "trace-full")
@@ -474,4 +505,64 @@ namespace black::frontend {
     }
   }
 
+  //
+  // The script is named after the input file, and it is created in the
+  // directory given to --dump-smtlib, creating the latter if needed
+  //
+  std::ofstream open_dump_file(std::optional<std::string> const&path) {
+    std::filesystem::path dir = *cli::dump_smtlib;
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if(error)
+      io::fatal(status_code::filesystem_error,
+        "Unable to create directory `{}`: {}", dir.string(), error.message()
+      );
+
+    std::string name = path ? 
+      std::filesystem::path{*path}.stem().string() : "black";
+
+    return open_out_file((dir / (name + ".smt2")).string());
+  }
+
+  //
+  // Mirrors in `script` what the solver does with its backend: the conjuncts
+  // of each k-unraveling are asserted and checked, EMPTY and LOOP are checked
+  // together as an assumption, and the negated PRUNE is asserted and checked.
+  //
+  void dump_smtlib(
+    smtlib2_script &script, black::solver::trace_t data, 
+    std::optional<formula> &empty
+  ) {
+    if(data.type == black::solver::trace_t::stage) {
+      script.comment("k = " + to_string(std::get<size_t>(data.data)));
+      return;
+    }
+
+    black_assert(data.xi);
+    formula f = std::get<formula>(data.data);
+
+    switch(data.type) {
+      case black::solver::trace_t::stage:
+      case black::solver::trace_t::nnf:
+        break;
+      case black::solver::trace_t::unrav:
+        for(formula c : black_internal::cnf::conjuncts(f))
+          script.assert_formula(c, *data.xi);
+        script.check_sat();
+        break;
+      case black::solver::trace_t::empty:
+        empty = f;
+        break;
+      case black::solver::trace_t::loop:
+        black_assert(empty.has_value());
+        script.check_sat_assuming(*empty || f, *data.xi);
+        break;
+      case black::solver::trace_t::prune:
+        script.assert_formula(!f, *data.xi);
+        script.check_sat();
+        break;
+    }
+  }
+
 }
@@ -30,12 +30,17 @@
 #include <black/logic/prettyprint.hpp>
 #include <black/logic/past_remover.hpp>
 #include <black/solver/solver.hpp>
-#include <black/support/tribool.hpp>
+#include <black/solver/tracecheck.hpp>
 
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <optional>
+#include <thread>
+#include <unordered_map>
 
 #include <nlohmann/json.hpp>
 
@@ -43,267 +48,32 @@ using json = nlohmann::json;
 
 namespace black::frontend 
 {
-  using state_t = std::map<std::string, black::tribool>;
-
   struct trace_t {
     std::optional<std::string> result;
-    size_t loop = 0;
-    std::vector<state_t> states;
+    std::optional<black::trace> model;
     std::optional<formula> muc;
   };
 
-  static bool check(trace_t, formula, size_t);
-
-  static
-  std::optional<state_t> state_at(trace_t trace, size_t t) {
-    if(t < trace.loop)
-      return trace.states[t];
-    
-    size_t period = trace.states.size() - trace.loop;
-
-    if(period)
-      return trace.states[((t - trace.loop) % period) + trace.loop];
-    
-    black_assert(t >= trace.states.size());
-    return {};
-  }
-
-  static
-  bool check_proposition(trace_t trace, proposition a, size_t t) {
-    black_assert(a.name().to<std::string>().has_value());
-    std::string p = *a.name().to<std::string>();
-
-    std::optional<state_t> state = state_at(trace, t);
-    
-    // all the states at the end of a non-looping model are
-    // full of don't cares so we return true (we may choose false as well)
-    if(!state.has_value())
-      return true;
-      
-    auto it = state->find(p);
-    if(it == state->end())
-      return true;
-    
-    black::tribool value = it->second;
-    if(value == true || value == black::tribool::undef)
-      return true;
-
-    return false;
-  }
-
-  static
-  std::optional<size_t>
-  find_one(trace_t trace, formula f, size_t begin, size_t end) {
-    for(size_t i = begin; i < end; ++i) {
-      if(check(trace, f, i))
-        return i;
-    }
-    return {};
-  }
-
-  static
-  std::optional<size_t>
-  find_one_reverse(trace_t trace, formula f, size_t begin, size_t end) {
-    for(ssize_t i = (ssize_t)begin; i >= (ssize_t)end; --i) {
-      if(check(trace, f, (size_t)i))
-        return i;
-    }
-    return {};
-  }
-
-  static
-  bool check_for_all(trace_t trace, formula f, size_t begin, size_t end) {
-    for(size_t i = begin; i < end; ++i) {
-      if(!check(trace, f, i))
-        return false;
-    }
-    return true;
-  }
-
-  static
-  size_t depth(formula f) {
-    return f.match(
-      [](boolean) -> size_t { return 1; },
-      [](proposition) -> size_t { return 1; },
-      [](atom) -> size_t { black_unreachable(); }, // LCOV_EXCL_LINE
-      [](quantifier) -> size_t { black_unreachable(); }, // LCOV_EXCL_LINE
-      [](equality) -> size_t { black_unreachable(); }, // LCOV_EXCL_LINE
-      [](comparison) -> size_t { black_unreachable(); }, // LCOV_EXCL_LINE
-      [](yesterday, formula op) { return 1 + depth(op); },
-      [](w_yesterday, formula op) { return 1 + depth(op); },
-      [](once, formula op) { return 1 + depth(op); },
-      [](historically, formula op) { return 1 + depth(op); },
-      [](since, formula l, formula r) {
-        return 1 + std::max(depth(l), depth(r));
-      },
-      [](triggered, formula l, formula r) {
-        return 1 + std::max(depth(l), depth(r));
-      },
-      [](unary, formula op) {
-        return depth(op);
-      },
-      [](binary, formula l, formula r) {
-        return std::max(depth(l), depth(r));
-      }
-    );
-  }
-
-  static
-  bool check_until(trace_t trace, until u, size_t t) {
-    formula l = u.left();
-    formula r = u.right();
-
-    size_t period = trace.states.size() - trace.loop;
-    size_t d = depth(u);
-    black_assert(d >= 1);
-
-    size_t end = std::max(t, trace.states.size()) + period + (period * d);
-
-    // search for 'r'
-    std::optional<size_t> rindex = find_one(trace, r, t, end);
-    
-    if(!rindex.has_value())
-      return false; // we didn't find 'r', the formula is false
-
-    // check 'l' in all positions until 'r'
-    return check_for_all(trace, l, t, *rindex);
-  }
-
   static
-  bool check_since(trace_t trace, since s, size_t t) {
-    formula l = s.left();
-    formula r = s.right();
-    
-    // search for 'r'
-    std::optional<size_t> rindex = find_one_reverse(trace, r, t, 0);
-
-    if(!rindex.has_value())
-      return false; // we didn't find 'r', the formula is false
-
-    // check 'l' in all positions until 'r'
-    return check_for_all(trace, l, *rindex + 1, t + 1);
-  }
-
-  static
-  bool state_exists(trace_t trace, size_t t) {
-    return !cli::finite || t < trace.states.size();
-  }
-
-  struct check_lookup {
-    formula f;
-    size_t t;
-
-    friend bool operator==(check_lookup const&, check_lookup const&) = default;
-  };
-
-  } namespace std {
-
-    template<>
-    struct hash<black::frontend::check_lookup> {
-      size_t operator()(black::frontend::check_lookup l) const {
-        using namespace black_internal;
-        using namespace black;
-        size_t h1 = std::hash<formula>{}(l.f);
-        size_t h2 = std::hash<size_t>{}(l.t);
-
-        return hash_combine(h1, h2);
-      }
-    };
-
-  } namespace black::frontend {
-
-  static
-  bool check(trace_t trace, formula f, size_t t) 
-  {
-    static std::unordered_map<check_lookup, bool> memo;
-    if(auto it = memo.find({f, t}); it != memo.end())
-      return it->second;
-
-    bool result = f.match(
-      [](boolean b) {
-        return b.value();
-      },
-      [&](proposition a) {
-        return check_proposition(trace, a, t);
-      },
-      [&](atom) -> bool { black_unreachable(); }, // LCOV_EXCL_LINE
-      [&](quantifier) -> bool { black_unreachable(); }, // LCOV_EXCL_LINE
-      [&](equality) -> bool { black_unreachable(); }, // LCOV_EXCL_LINE
-      [&](comparison) -> bool { black_unreachable(); }, // LCOV_EXCL_LINE
-      [&](tomorrow, formula op) {
-        return state_exists(trace, t + 1) && check(trace, op, t + 1);
-      },
-      [&](w_tomorrow, formula op) {
-        return !state_exists(trace, t + 1) || check(trace, op, t + 1);
-      },
-      [&](yesterday, formula op) {
-        return t > 0 && check(trace, op, t - 1);
-      },
-      [&](w_yesterday, formula op) {
-        return t == 0 || check(trace, op, t - 1);
-      },
-      [&](until u) {
-        return check_until(trace, u, t);
-      },
-      [&](since s) {
-        return check_since(trace, s, t);
-      },
-      [&](negation, formula op) {
-        return !check(trace, op, t);
-      },
-      [&](conjunction, formula l, formula r) {
-        return check(trace, l, t) && check(trace, r, t);
-      },
-      [&](disjunction, formula l, formula r) {
-        return check(trace, l, t) || check(trace, r, t);
-      },
-      [&](implication, formula l, formula r) {
-        return !check(trace, l, t) || check(trace, r, t);
-      },
-      [&](iff, formula l, formula r) {
-        return check(trace, l, t) == check(trace, r, t);
-      },
-      [&](eventually, formula op) {
-        return check(trace, U(op.sigma()->top(), op), t);
-      },
-      [&](always, formula op) {
-        return check(trace, !F(!op), t);
-      },
-      [&](w_until, formula l, formula r) {
-        return check(trace, G(l) || U(l, r), t);
-      },
-      [&](release, formula l, formula r) {
-        return check(trace, !U(!l, !r), t);
-      },
-      [&](s_release, formula l, formula r) {
-        return check(trace, !W(!l, !r), t);
-      },
-      [&](once, formula op) {
-        return check(trace, S(op.sigma()->top(), op), t);
-      },
-      [&](historically, formula op) {
-        return check(trace, !O(!op), t);
-      },
-      [&](triggered, formula l, formula r) {
-        return check(trace, !S(!l, !r), t);
-      }
-    );
-
-    if(cli::verbose)
-      io::println("{} at t = {} is {}", to_string(f), t, result);
-
-    memo.insert({{f,t}, result});
-
-    return result;
-  }
-
-  static
-  int check(trace_t trace, formula f) {
+  int check(trace_checker const& checker, black::trace const& trace) {
     size_t initial_state = 0;
     if(cli::initial_state)
       initial_state = *cli::initial_state;
 
-    bool result = check(trace, f, initial_state);
+    if(cli::finite && initial_state >= trace.size())
+      io::fatal(
+        status_code::command_line_error, 
+        "the initial state is past the end of the trace"
+      );
+
+    auto report = [&](formula f, bool value) {
+      io::println("{} at t = {} is {}", to_string(f), initial_state, value);
+    };
+
+    bool result = cli::verbose ? 
+      checker.check(trace, initial_state, report) :
+      checker.check(trace, initial_state);
+    
     if(result)
       io::println("TRUE");
     else {
@@ -314,11 +84,16 @@ namespace black::frontend
     return 0;
   }
 
+  //
+  // Errors are reported to `error`, after which parsing stops and nothing is
+  // returned, so that a batch of traces can go on after a malformed one.
+  //
   static 
-  trace_t
+  std::optional<trace_t>
   parse_trace(
-    alphabet &sigma, 
-    std::optional<std::string> const&tracepath, std::istream &file
+    alphabet &sigma, std::unordered_map<std::string, size_t> const& indexes,
+    std::optional<std::string> const&tracepath, std::istream &file,
+    std::function<void(std::string)> const&error
   ) {
     std::string path = tracepath ? *tracepath : "<stdin>";
     json j;
@@ -334,79 +109,104 @@ namespace black::frontend
         std::string smuc = jmuc.get<std::string>();
         trace.muc =
           black::parse_formula(
-            sigma, smuc, [&](auto error) {
-              io::fatal(
-                status_code::syntax_error, "{}: malformed 'muc' field: {}", 
-                path, error
+            sigma, smuc, [&](auto msg) {
+              error(
+                fmt::format("{}: malformed 'muc' field: {}", path, msg)
               );
             }
           );
-        black_assert(trace.muc.has_value());
+        if(!trace.muc)
+          return {};
       }
 
       json model = j["model"];
       if(model.is_null())
         return trace;
 
-      if(!cli::finite)
-        trace.loop = model["loop"];
-      else
-        trace.loop = model["size"];
-
-      if(cli::finite && !model["loop"].is_null())
-        io::fatal(
-          status_code::syntax_error, 
-          "expected a finite model, but a \"loop\" field is present"
-        );
+      if(cli::finite && !model["loop"].is_null()) {
+        error(fmt::format(
+          "{}: expected a finite model, but a \"loop\" field is present",
+          path
+        ));
+        return {};
+      }
       
-      if(model["states"].size() == 0)
-        io::fatal(status_code::syntax_error, "{}: empty model", path);
+      size_t size = model["states"].size();
+      if(size == 0) {
+        error(fmt::format("{}: empty model", path));
+        return {};
+      }
 
-      for(json jstate : model["states"]) {
-        std::map<std::string, black::tribool> state;
+      if(model["size"] != size) {
+        error(fmt::format(
+          "{}: \"size\" field and effective model size disagree", path
+        ));
+        return {};
+      }
 
-        for(auto it = jstate.begin(); it != jstate.end(); ++it) {
-          black::tribool value = black::tribool::undef;
-          if(it.value().get<std::string>() == "undef")
-            value = black::tribool::undef;
-          else if(it.value().get<std::string>() == "true")
-            value = true;
-          else if(it.value().get<std::string>() == "false")
-            value = false;
-          else {
-            io::fatal(
-              status_code::syntax_error, 
-              "{}: invalid proposition value",
-              path
-            );
-          }
+      std::optional<size_t> loop;
+      if(!cli::finite)
+        loop = model["loop"].get<size_t>();
 
-          state.insert({it.key(), value});
-        }
-        trace.states.push_back(state);
+      if(loop > size) {
+        error(fmt::format(
+          "{}: \"loop\" field greater than model size", path
+        ));
+        return {};
       }
 
-      if(model["size"] != trace.states.size()) {
-        io::fatal(
-          status_code::syntax_error, 
-          "{}: \"size\" field and effective model size disagree",
-          path
-        );
-      }
+      // undefined and missing propositions are taken to hold
+      trace.model.emplace(indexes.size(), size, loop);
+      size_t t = 0;
+      for(json jstate : model["states"]) {
+        for(auto it = jstate.begin(); it != jstate.end(); ++it) {
+          std::string value = it.value().get<std::string>();
+          if(value != "undef" && value != "true" && value != "false") {
+            error(fmt::format("{}: invalid proposition value", path));
+            return {};
+          }
 
-      if(trace.loop > trace.states.size()) {
-        io::fatal(
-          status_code::syntax_error, 
-          "{}: \"loop\" field greater than model size",
-          path
-        );
+          auto index = indexes.find(it.key());
+          if(value == "false" && index != indexes.end())
+            trace.model->set(index->second, t, false);
+        }
+        t++;
       }
 
       return trace;
 
     } catch (json::exception& ex) {
-      io::fatal(status_code::syntax_error, "{}:{}", path, ex.what());
+      error(fmt::format("{}:{}", path, ex.what()));
+      return {};
+    }
+  }
+
+  //
+  // The trace checker works only on propositional formulas, so the checker
+  // is missing for first-order ones, and the trace is then only used for its
+  // "result" and "muc" fields.
+  //
+  static 
+  std::optional<trace_checker> compile(
+    formula f, std::unordered_map<std::string, size_t> &indexes
+  ) {
+    if(formula_features(f) & feature_t::first_order)
+      return {};
+
+    std::optional<trace_checker> checker{std::in_place, f};
+    for(proposition p : checker->propositions()) {
+      black_assert(p.name().to<std::string>().has_value());
+      indexes.insert({*p.name().to<std::string>(), indexes.size()});
     }
+    return checker;
+  }
+
+  static bool is_sat_core(alphabet &sigma, formula muc) {
+    scope xi{sigma};
+    xi.set_default_sort(sigma.named_sort("default"));
+    
+    black::solver slv;
+    return slv.solve(xi, muc, cli::finite) != false;
   }
 
   static
@@ -423,38 +223,198 @@ namespace black::frontend
 
     black_assert(f.has_value());
 
-    trace_t trace = parse_trace(sigma, tracepath, tracefile);
+    std::unordered_map<std::string, size_t> indexes;
+    std::optional<trace_checker> checker = compile(*f, indexes);
+
+    std::optional<trace_t> trace = 
+      parse_trace(sigma, indexes, tracepath, tracefile, [](auto error) {
+        io::fatal(status_code::syntax_error, "{}", error);
+      });
+    black_assert(trace.has_value());
 
     if(cli::expected_result) {
-      if(trace.result != *cli::expected_result) {
+      if(trace->result != *cli::expected_result) {
         io::println("MISMATCH");
         quit(status_code::failed_check);
       }
 
-      if(trace.result == *cli::expected_result)
+      if(trace->result == *cli::expected_result)
         io::println("MATCH");
     }
 
-    if(trace.muc.has_value()) {
+    if(trace->muc.has_value() && is_sat_core(sigma, *trace->muc)) {
+      io::println("SAT CORE");
+      quit(status_code::failed_check);
+    }
+    
+    if(!checker || !trace->model)
+      quit(status_code::success);
+
+    return check(*checker, *trace->model);
+  }
+
+  //
+  // Batch checking with --traces. The formula is parsed and compiled only
+  // once, and the traces are spread over worker threads, each one taking the
+  // next unchecked trace in turn. A malformed trace does not stop the batch
+  // but is reported as an error in its row of the final table.
+  //
+  struct batch_result_t {
+    std::string verdict;
+    std::string error;
+    size_t states = 0;
+  };
+
+  static 
+  batch_result_t check_batched(
+    alphabet &sigma, std::optional<trace_checker> const& checker,
+    std::unordered_map<std::string, size_t> const& indexes,
+    std::string const& path
+  ) {
+    std::ifstream file{path, std::ios::in};
+    if(!file)
+      return {
+        "ERROR", 
+        fmt::format(
+          "Unable to open file `{}`: {}", path, system_error_string(errno)
+        )
+      };
+
+    std::string error;
+    std::optional<trace_t> trace = 
+      parse_trace(sigma, indexes, path, file, [&](auto msg) {
+        error = msg;
+      });
+    if(!trace)
+      return {"ERROR", error};
+
+    if(cli::expected_result && trace->result != *cli::expected_result)
+      return {"MISMATCH", ""};
+    
+    if(trace->muc.has_value() && is_sat_core(sigma, *trace->muc))
+      return {"SAT CORE", ""};
+
+    if(!checker || !trace->model)
+      return {"SKIPPED", ""};
+
+    size_t size = trace->model->size();
+    size_t initial_state = cli::initial_state.value_or(0);
+    if(cli::finite && initial_state >= size)
+      return {
+        "ERROR", 
+        fmt::format("{}: the initial state is past the end of the trace", path)
+      };
+
+    if(checker->check(*trace->model, initial_state))
+      return {"TRUE", "", size};
+    return {"FALSE", "", size};
+  }
+
+  //
+  // The traces are either all the regular files in the given directory, or
+  // the ones listed in the given index file, one per line, with relative
+  // paths taken relative to the directory of the index.
+  //
+  static std::vector<std::string> trace_files(std::string const& traces) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+
+    std::error_code error;
+    if(fs::is_directory(traces, error)) {
+      fs::directory_iterator it{traces, error}, end;
+      for(; !error && it != end; it.increment(error))
+        if(it->is_regular_file())
+          files.push_back(it->path().string());
+
+      if(error)
+        io::fatal(status_code::filesystem_error,
+          "Unable to read directory `{}`: {}", traces, error.message()
+        );
+
+      std::sort(files.begin(), files.end());
+      return files;
+    }
+
+    std::ifstream index = open_file(traces);
+    fs::path base = fs::path{traces}.parent_path();
 
-      scope xi{sigma};
-      xi.set_default_sort(sigma.named_sort("default"));
+    std::string line;
+    while(std::getline(index, line)) {
+      line.erase(0, line.find_first_not_of(" \t\r"));
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      if(line.empty())
+        continue;
       
-      black::solver slv;
-      if(slv.solve(xi, *trace.muc, cli::finite) != false) {
-        io::println("SAT CORE");
-        quit(status_code::failed_check);
-      }
+      fs::path path{line};
+      files.push_back(path.is_absolute() ? line : (base / path).string());
     }
+
+    return files;
+  }
+
+  static
+  int batch_check(std::optional<std::string> const&path, std::istream &file)
+  {
+    black::alphabet sigma;
     
-    uint8_t features = formula_features(*f);
-    if(features & feature_t::first_order)
-      quit(status_code::success);
+    std::optional<formula> f = 
+      black::parse_formula(sigma, file, formula_syntax_error_handler(path));
 
-    if(trace.states.size() == 0)
-      quit(status_code::success);
+    black_assert(f.has_value());
+
+    std::unordered_map<std::string, size_t> indexes;
+    std::optional<trace_checker> checker = compile(*f, indexes);
+
+    std::vector<std::string> files = trace_files(*cli::traces);
+    std::vector<batch_result_t> results(files.size());
+
+    size_t threads = std::clamp<size_t>(
+      std::thread::hardware_concurrency(), 1, std::max<size_t>(files.size(), 1)
+    );
+    if(threads > 1)
+      sigma.make_concurrent();
+
+    auto start = std::chrono::steady_clock::now();
+    
+    std::atomic<size_t> next = 0;
+    auto work = [&]() {
+      for(size_t i = next++; i < files.size(); i = next++)
+        results[i] = check_batched(sigma, checker, indexes, files[i]);
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; ++t)
+      workers.emplace_back(work);
+    work();
+    for(auto &w : workers)
+      w.join();
+
+    std::chrono::duration<double> elapsed = 
+      std::chrono::steady_clock::now() - start;
+
+    size_t states = 0;
+    size_t failed = 0;
+    for(size_t i = 0; i < files.size(); ++i) {
+      batch_result_t const& r = results[i];
+      io::println("{:<9} {}", r.verdict, r.error.empty() ? files[i] : r.error);
+
+      states += r.states;
+      if(r.verdict != "TRUE" && r.verdict != "SKIPPED")
+        failed++;
+    }
+
+    double seconds = std::max(elapsed.count(), 1e-9);
+    io::println(
+      "{} traces ({} failed), {} states, {:.3f}s, {} threads, "
+      "{:.1f} traces/s, {:.0f} states/s",
+      files.size(), failed, states, elapsed.count(), threads,
+      files.size() / seconds, states / seconds
+    );
+
+    if(failed > 0)
+      quit(status_code::failed_check);
 
-    return check(trace, *f);
+    return 0;
   }
 
   int trace_check() {
@@ -470,6 +430,31 @@ namespace black::frontend
       quit(status_code::command_line_error);
     }
 
+    if(cli::trace.empty() && !cli::traces) {
+      command_line_error("please specify the --trace or --traces option");
+      quit(status_code::command_line_error);
+    }
+
+    if(!cli::trace.empty() && cli::traces) {
+      command_line_error(
+        "please specify only either the --trace or the --traces option"
+      );
+      quit(status_code::command_line_error);
+    }
+
+    if(cli::traces) {
+      if(cli::formula) {
+        std::istringstream str{*cli::formula};
+        return batch_check(std::nullopt, str);
+      }
+
+      if(cli::filename == "-")
+        return batch_check(std::nullopt, std::cin);
+
+      std::ifstream file = open_file(*cli::filename);
+      return batch_check(cli::filename, file);
+    }
+
     if(cli::filename == "-" && cli::trace == "-") {
       command_line_error(
         "cannot read from stdin both the formula file and the trace file"
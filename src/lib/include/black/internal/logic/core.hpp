@@ -28,7 +28,10 @@
 #include <black/support/identifier.hpp>
 #include <black/support/bitset.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 #include <numeric>
 #include <ranges>
 #include <bitset>
@@ -152,9 +155,30 @@ namespace black_internal::logic {
   struct hierarchy_node {
     syntax_element type;
 
-    bool operator==(hierarchy_node const&) const = default;
+    // The index of the node in the table of its alphabet, used to resolve
+    // compact handles (see `compact` in `generation.hpp`), and to tell the
+    // memory region where the node has been created (see
+    // `alphabet::open_region()`). Zero for nodes not yet owned by an alphabet.
+    uint32_t index = 0;
+
+    // A summary of the subtree rooted at the node, completed by the alphabet
+    // when the node is created (children always exist before their parents),
+    // and not part of the node's identity. `elements` is a bitmask of the
+    // `syntax_element`s appearing in the subtree, `size` is the number of
+    // nodes of the subtree seen as a tree (saturated), and `depth` its height.
+    // See `has_any_element_of()`, `tree_size()` and `tree_depth()`. Together
+    // with the fields above, this takes 24 bytes.
+    uint64_t elements = uint64_t{1} << static_cast<uint8_t>(type);
+    uint32_t size = 1;
+    uint32_t depth = 1;
+
+    bool operator==(hierarchy_node const& other) const {
+      return type == other.type;
+    }
   };
 
+  static_assert(sizeof(hierarchy_node) <= 24);
+
   //
   // This is an opaque type used as a return type for the `unique_id()` member
   // function of the hierarchy types. Useful to compare for identity, hash, or
@@ -1483,25 +1507,133 @@ namespace black_internal::logic {
   }
 
   //
-  // A good application for `for_each_child`. This function tells whether a
-  // hierarchy object `h` contains any element among those given as arguments.
-  // For example, if `f` is a formula, `has_any_element_of(f,
-  // syntax_element::boolean, syntax_element::iff)` tells whether there is any
-  // boolean constant in the formula or any double implication.
+  // This function tells whether a hierarchy object `h` contains any element
+  // among those given as arguments. For example, if `f` is a formula,
+  // `has_any_element_of(f, syntax_element::boolean, syntax_element::iff)`
+  // tells whether there is any boolean constant in the formula or any double
+  // implication. The answer comes in constant time from the summary stored in
+  // the node (see `hierarchy_node`).
   //
+  template<typename ...Args>
+    requires (std::is_constructible_v<syntax_element, Args> && ...)
+  constexpr uint64_t syntax_element_mask(Args ...args) {
+    static_assert(syntax_element_max_size <= 64);
+    return ((uint64_t{1} << static_cast<uint8_t>(syntax_element{args})) | ... 
+            | uint64_t{0});
+  }
+
   template<hierarchy H, typename ...Args>
     requires (std::is_constructible_v<syntax_element, Args> && ...)
   bool has_any_element_of(H h, Args ...args) {
-    if(((h.node()->type == args) || ...))
-      return true;
-    
-    bool has = false;
-    for_each_child(h, [&](auto child) {
-      if(has_any_element_of(child, args...))
-        has = true;
-    });
+    return (h.node()->elements & syntax_element_mask(args...)) != 0;
+  }
+
+  //
+  // Size and depth of the tree rooted at `h`, also in constant time. Shared
+  // subterms are counted as many times as they appear, and the size saturates
+  // at the maximum value of `uint32_t`.
+  //
+  template<hierarchy H>
+  size_t tree_size(H h) {
+    return h.node()->size;
+  }
+
+  template<hierarchy H>
+  size_t tree_depth(H h) {
+    return h.node()->depth;
+  }
+
+  //
+  // Generic bottom-up traversal of a hierarchy object, to write passes that
+  // compute something on each node from the results on its children, e.g.
+  // rewritings. `fold<R>(h, f)` calls `f(node, result)` once for each distinct
+  // node of `h` that belongs to the same hierarchy (e.g. all the subformulas
+  // of a formula, but not the terms of its atoms), where `node` is the
+  // hierarchy object (e.g. a `formula`) and `result(child)` returns a const
+  // reference to the value of type `R` returned by `f` on `child`. Children
+  // are always visited before their parents, and from left to right, which
+  // matters only if `f` has side effects.
+  //
+  // The traversal uses an explicit stack, so it does not overflow on deep
+  // objects such as long conjunction chains or nested temporal operators, and
+  // results are memoized by node, so subterms shared in many places are
+  // visited only once and the cost is linear in the size of the DAG instead
+  // of the tree. Note that children are the direct ones, so `left()` and
+  // `right()` of a conjunction rather than its `operands()`.
+  //
+  // `result()` can also be called on objects that are not children of the
+  // current node, e.g. to recurse on something built on the fly. Those are
+  // folded on the spot sharing the same memoization table.
+  //
+  // The `fold_t` class can be used directly to share the table across
+  // multiple calls on different objects.
+  //
+  template<typename F>
+  void for_each_direct_child(hierarchy auto h, F f) {
+    h.match(
+      [&](auto s) {
+        std::apply([&](auto ...fields) {
+          for_each_child_aux<0, decltype(s)::storage>(f, fields...);
+        }, as_tuple(s));
+      }
+    );
+  }
+
+  template<hierarchy_type H, typename R>
+  class fold_t 
+  {
+  public:
+    using object_t = hierarchy_type_of_t<H>;
+
+    template<typename F>
+    R const& operator()(object_t root, F &f) {
+      if(auto it = _memo.find(root.node()); it != _memo.end())
+        return it->second;
+
+      auto result = [&](object_t child) -> R const& {
+        return (*this)(child, f);
+      };
+
+      std::vector<std::pair<object_t, bool>> stack = {{root, false}};
+      while(!stack.empty()) {
+        auto [h, expanded] = stack.back();
+        if(_memo.find(h.node()) != _memo.end()) {
+          stack.pop_back();
+          continue;
+        }
+
+        if(!expanded) {
+          stack.back().second = true;
+          size_t top = stack.size();
+          for_each_direct_child(h, [&](auto child) {
+            if constexpr(decltype(child)::hierarchy == H) {
+              if(_memo.find(child.node()) == _memo.end())
+                stack.push_back({object_t{child}, false});
+            }
+          });
+          // the last child pushed is the first to be popped
+          std::reverse(stack.begin() + long(top), stack.end());
+          continue;
+        }
+
+        stack.pop_back();
+        R r = f(h, result);
+        _memo.insert({h.node(), std::move(r)});
+      }
+
+      return _memo.find(root.node())->second;
+    }
+
+    size_t size() const { return _memo.size(); }
+
+  private:
+    std::unordered_map<hierarchy_node const *, R> _memo;
+  };
 
-    return has;
+  template<typename R, hierarchy H, typename F>
+  R fold(H h, F f) {
+    fold_t<H::hierarchy, R> folder;
+    return folder(hierarchy_type_of_t<H::hierarchy>{h}, f);
   }
 }
 
@@ -617,6 +617,16 @@ namespace black_internal::logic
   // declared here and implemented in `logic.cpp`, together with
   // `alphabet_impl`.
   //
+  //
+  // Approximate memory usage of the nodes of a given storage kind, as returned
+  // by `alphabet::memory_usage()`.
+  //
+  struct storage_usage {
+    storage_type storage;
+    size_t nodes = 0; // number of live nodes
+    size_t bytes = 0; // bytes used by nodes, free slots, and hash tables
+  };
+
   #define declare_leaf_storage_kind(Base, Storage) \
     , public alphabet_ctor_base<syntax_element::Storage, alphabet_base>
   #define declare_leaf_hierarchy_element(Base, Storage, Element) \
@@ -637,6 +647,55 @@ namespace black_internal::logic
     alphabet_base &operator=(alphabet_base const&) = delete;
     alphabet_base &operator=(alphabet_base &&);
 
+    //
+    // By default, an alphabet can only be used by a single thread at a time.
+    // After `make_concurrent()`, elements can be created concurrently by
+    // multiple threads, at the cost of some locking. The switch is one-way
+    // and the call itself must happen before the alphabet is shared.
+    //
+    void make_concurrent();
+    bool is_concurrent() const;
+
+    //
+    // Nodes are normally kept alive until the alphabet is destroyed. To bound
+    // memory usage in long-running processes, a region can be opened before
+    // creating a batch of related formulas (e.g. for a single call to
+    // `solver::solve()`), and released afterwards passing the formulas,
+    // terms, etc. that must survive (also inside vectors, tuples, etc.). All
+    // the nodes created since the region was opened and not reachable from
+    // those roots are freed, and their handles become dangling. Hence,
+    // scopes, solvers, and any other object holding them must have been
+    // destroyed before. Labels are followed as well (see `trace_nodes()` in
+    // `identifier.hpp`), and if a label of a type that cannot be followed is
+    // reachable, nothing is freed. Regions can be nested, releasing a region
+    // also releases the ones opened after it, and each region can be released
+    // only once. The surviving nodes then belong to the enclosing region, and
+    // the id of the released one is reused by the next call to
+    // `open_region()`. Neither `open_region()` nor `release()` can be called
+    // concurrently with any other use of the alphabet.
+    //
+    using region = uint32_t;
+
+    region open_region();
+
+    template<typename ...Roots>
+    void release(region r, Roots const& ...roots) {
+      node_list nodes;
+      (trace_nodes(roots, nodes), ...);
+      release_nodes(r, std::move(nodes));
+    }
+
+    //
+    // Memory usage of the alphabet, one entry for each storage kind.
+    //
+    std::vector<storage_usage> memory_usage() const;
+
+    //
+    // Returns the node with the given index, used by `compact<H>::get()`.
+    // This is for internal use but has to be public.
+    //
+    hierarchy_node const *node_at(uint32_t index) const;
+
     #define declare_leaf_storage_kind(Base, Storage) \
       template<typename ...Args> \
       class Storage Storage(Args ...args) { \
@@ -671,6 +730,8 @@ namespace black_internal::logic
 
     #include <black/internal/logic/hierarchy.hpp>
 
+    void release_nodes(region r, node_list roots);
+
     struct alphabet_impl;
     
     alphabet_impl *impl();
@@ -679,6 +740,51 @@ namespace black_internal::logic
     std::unique_ptr<alphabet_impl> _impl;
   };
 
+  //
+  // A compact handle to a hierarchy object, e.g. `compact<formula>`, made of
+  // the 32-bit index of its node in the alphabet's table instead of the two
+  // pointers held by the object itself. The alphabet is not stored, and has
+  // to be given back by the context to get the object with `get()`. Compact
+  // handles are meant as keys and values of big tables and hash maps of
+  // objects coming from a single alphabet (e.g. caches of formula
+  // transformations), where they take a quarter of the space, and equality
+  // and hashing do not need to follow any pointer. They are valid as long as
+  // the referred object is (see `alphabet::release()`).
+  //
+  template<hierarchy H>
+  class compact 
+  {
+  public:
+    compact() = default;
+
+    template<hierarchy U>
+      requires std::is_convertible_v<U, H>
+    compact(U h) : _index{h.node()->index} { 
+      black_assert(_index != 0);
+    }
+
+    H get(alphabet_base *sigma) const {
+      black_assert(_index != 0);
+      return H{sigma, sigma->node_at(_index)};
+    }
+
+    uint32_t index() const { return _index; }
+
+    bool operator==(compact const&) const = default;
+
+  private:
+    uint32_t _index = 0;
+  };
+
+  } namespace std {
+    template<black_internal::logic::hierarchy H>
+    struct hash<black_internal::logic::compact<H>> {
+      size_t operator()(black_internal::logic::compact<H> const& c) const {
+        return std::hash<uint32_t>{}(c.index());
+      }
+    };
+  } namespace black_internal::logic {
+
   //
   // Here we start to account for the other elements of the interface of
   // hierarchy types. See especially the comments for the `index_of_field` trait
@@ -836,6 +942,9 @@ namespace black {
   using black_internal::logic::storage_kind;
   using black_internal::logic::hierarchy_element;
   using black_internal::logic::syntax_element;
+  using black_internal::logic::storage_type;
+  using black_internal::logic::storage_usage;
+  using black_internal::logic::compact;
   using black_internal::logic::alphabet;
   using black_internal::logic::otherwise;
 
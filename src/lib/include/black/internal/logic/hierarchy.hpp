@@ -433,6 +433,12 @@ declare_hierarchy(formula)
     declare_hierarchy_element(formula, binary, triggered)
   end_storage_kind(formula, binary)
 
+  declare_storage_kind(formula, nary)
+    declare_children(formula, nary, formula, operands)
+    declare_hierarchy_element(formula, nary, big_conjunction)
+    declare_hierarchy_element(formula, nary, big_disjunction)
+  end_storage_kind(formula, nary)
+
 end_hierarchy(formula)
 
 declare_simple_hierarchy(sort)
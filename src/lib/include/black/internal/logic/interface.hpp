@@ -418,6 +418,41 @@ namespace black_internal::logic {
     return acc;
   }
 
+  //
+  // This variant builds long conjunctions and disjunctions as a single n-ary
+  // node (`big_conjunction` or `big_disjunction`), which is much cheaper to
+  // allocate, hash and traverse than a left-deep chain of binary nodes. Two
+  // operands still give a binary `conjunction`/`disjunction`. Note that the
+  // n-ary form is *not* canonical: the parser, `operator&&` and `big_and()`
+  // build binary chains, which differ from the n-ary node with the same
+  // operands, even if they print the same. Hence, this is meant only for
+  // internal formulas that never reach the user, such as the encoder's
+  // k-unravelings (see `flat_and()` in `encoding.hpp`).
+  //
+  template<
+    syntax_element Binary, syntax_element Nary, 
+    std::ranges::range Range, typename F,
+    typename T = std::ranges::range_value_t<Range>
+  >
+  formula fold_nary_op(Range const& r, formula id, F&& f)
+  {
+    std::vector<formula> ops;
+    for(auto x : r) {
+      formula elem = std::forward<F>(f)(x);
+      if(elem != id)
+        ops.push_back(elem);
+    }
+
+    if(ops.empty())
+      return id;
+    if(ops.size() == 1)
+      return ops[0];
+    if(ops.size() == 2)
+      return element_type_of_t<Binary>(ops[0], ops[1]);
+
+    return element_type_of_t<Nary>(ops);
+  }
+
   //
   // The following are instances of `fold_op`, useful functions to create long
   // conjunctions/disjunctions/sums/products by putting together the results of
@@ -584,6 +619,18 @@ namespace black_internal::logic {
     return associative_op_view<multiplication>{c};
   }
 
+  //
+  // For uniformity, n-ary conjunctions and disjunctions expose their operands
+  // with the same function, which in this case just returns the children.
+  //
+  inline auto operands(big_conjunction c) { 
+    return c.operands();
+  }
+  
+  inline auto operands(big_disjunction c) { 
+    return c.operands();
+  }
+
   //
   // Using operands() instead of left() and right() is essential to handle big
   // specifications, because going recursively for hundreds of elements can lead
@@ -683,11 +730,48 @@ namespace black_internal::logic {
             replace(right, patterns, replacements)
           );
       },
+      [&](nary n, auto operands) {
+        std::vector<formula> newops;
+        for(auto op : operands)
+          newops.push_back(replace(op, patterns, replacements));
+        return nary(n.node_type(), newops);
+      },
       [&](otherwise) {
         return src;
       }
     );
   }
+
+  //
+  // Constant-time queries about the temporal operators appearing in formulas
+  // and terms, based on `has_any_element_of()`.
+  //
+  template<hierarchy H>
+  bool has_future_operators(H h) {
+    return has_any_element_of(h,
+      syntax_element::tomorrow, syntax_element::w_tomorrow,
+      syntax_element::always, syntax_element::eventually,
+      syntax_element::until, syntax_element::release,
+      syntax_element::w_until, syntax_element::s_release
+    );
+  }
+
+  template<hierarchy H>
+  bool has_past_operators(H h) {
+    return has_any_element_of(h,
+      syntax_element::yesterday, syntax_element::w_yesterday,
+      syntax_element::once, syntax_element::historically,
+      syntax_element::since, syntax_element::triggered
+    );
+  }
+
+  template<hierarchy H>
+  bool has_next_terms(H h) {
+    return has_any_element_of(h,
+      syntax_element::next, syntax_element::wnext,
+      syntax_element::prev, syntax_element::wprev
+    );
+  }
 }
 
 #endif // BLACK_LOGIC_SUGAR_HPP_
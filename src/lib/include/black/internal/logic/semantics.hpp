@@ -24,6 +24,7 @@
 #ifndef BLACK_LOGIC_SEMANTICS_HPP
 #define BLACK_LOGIC_SEMANTICS_HPP
 
+#include <any>
 #include <memory>
 #include <vector>
 
@@ -60,6 +61,13 @@ namespace black_internal::logic {
     std::vector<variable> _elements;
   };
 
+  // the elements of a domain are kept alive by the sort declarations using it
+  using black_internal::trace_nodes;
+  inline void trace_nodes(domain const& d, node_list &out) {
+    for(variable x : d.elements())
+      out.push_back(x.node());
+  }
+
   // this `using` is forward declared in `fragments.hpp`.
   // using domain_ref = std::unique_ptr<domain>;
 
@@ -30,6 +30,7 @@
 #include <vector>
 #include <initializer_list>
 #include <memory>
+#include <span>
 
 namespace black_internal::cnf
 {
@@ -61,10 +62,24 @@ namespace black_internal::cnf
   logic::formula 
   remove_booleans(logic::formula f);
 
+  //
+  // Splits a formula into its conjuncts, looking through nested binary and
+  // n-ary conjunctions at any depth, in left-to-right order and without
+  // repetitions. The solver submits them to the backend as a single batch.
+  // Internal use, exposed here for testing.
+  //
+  BLACK_EXPORT
+  std::vector<logic::formula> conjuncts(logic::formula f);
+
   // Tseitin conversion to CNF
   BLACK_EXPORT
   cnf to_cnf(logic::formula f);
 
+  // Conversion of the conjunction of the given formulas, sharing the
+  // definitions of their common subformulas
+  BLACK_EXPORT
+  cnf to_cnf(std::span<logic::formula const> fs);
+
   // Conversion of literals, clauses and cnfs to formulas
   BLACK_EXPORT
   logic::formula to_formula(literal lit);
@@ -29,8 +29,14 @@
 
 #include <cassert>
 #include <cctype>
+#include <cstdio>
 
+#include <deque>
+#include <functional>
+#include <istream>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -56,14 +62,16 @@ namespace black_internal::lexer_details
       punctuation
     };
 
-    // Type of non-logical tokens. Only parens, for now.
+    // Type of non-logical tokens.
     enum class punctuation : uint8_t {
       // non-logical tokens
       left_paren,
       right_paren,
       comma,
       dot,
-      colon
+      colon,
+      let,
+      in
     };
 
     using equality_t = 
@@ -73,7 +81,7 @@ namespace black_internal::lexer_details
     explicit token(bool b)        : _data{b} { }
     explicit token(int64_t c)     : _data{c} { }
     explicit token(double d)      : _data{d} { }
-    explicit token(std::string s) : _data{std::move(s)} { }
+    explicit token(std::string_view s) : _data{s} { }
     explicit token(logic::quantifier::type k)  : _data{k} { }
     explicit token(equality_t t)                              : _data{t} { }
     explicit token(logic::comparison::type t)  : _data{t} { }
@@ -107,7 +115,7 @@ namespace black_internal::lexer_details
       bool,                      // booleans
       int64_t,                   // integers
       double,                    // reals
-      std::string,               // identifiers
+      std::string_view,          // identifiers
       logic::quantifier::type,  // exists/forall
       equality_t,                              // =, !=, equal(), distinct()
       logic::comparison::type,  // <, >, <=, >= 
@@ -123,13 +131,22 @@ namespace black_internal::lexer_details
   std::string to_string(token::punctuation p);
   std::string to_string(token const &tok);
 
+  //
+  // The lexer works on a contiguous buffer, either given by the caller (e.g.
+  // a memory-mapped file), which must outlive the lexer and its tokens, or
+  // read at once from a stream. Identifiers are returned as views on the
+  // buffer, so they are copied only when interned in the alphabet.
+  //
   class BLACK_EXPORT lexer
   {
   public:
     using error_handler = std::function<void(std::string)>;
 
-    explicit lexer(std::istream &stream, error_handler error) 
-      : _stream(stream), _error{error} {}  
+    lexer(std::istream &stream, error_handler error);
+    lexer(std::string_view buffer, error_handler error);
+
+    lexer(lexer const&) = delete;
+    lexer &operator=(lexer const&) = delete;
     
     std::optional<token> get() { return _token = _lex(); }
     std::optional<token> peek() const { return _token; }
@@ -139,13 +156,22 @@ namespace black_internal::lexer_details
     static bool is_keyword(std::string_view s);
 
   private:
-    static std::pair<std::string_view, token> _keywords[35];
+    static std::pair<std::string_view, token> _keywords[37];
+    int _peek() const { 
+      return _begin < _end ? static_cast<unsigned char>(*_begin) : EOF;
+    }
+
     std::optional<token> _lex();
+    std::optional<token> _digits();
+    std::optional<token> _symbol();
     std::optional<token> _identifier();
     std::optional<token> _raw_identifier();
 
     std::optional<token> _token = std::nullopt;
-    std::istream &_stream;
+    std::string _buffer;
+    char const *_begin;
+    char const *_end;
+    std::deque<std::string> _unescaped;
     error_handler _error;
   };
 
@@ -32,6 +32,7 @@
 #include <ostream>
 #include <functional>
 #include <memory>
+#include <string_view>
 
 namespace black_internal
 {
@@ -44,6 +45,11 @@ namespace black_internal
     using error_handler = std::function<void(std::string)>;
 
     parser(logic::alphabet &sigma, std::istream &stream, error_handler error);
+
+    // `buffer` must outlive the parser
+    parser(
+      logic::alphabet &sigma, std::string_view buffer, error_handler error
+    );
     
     ~parser();
 
@@ -58,7 +64,7 @@ namespace black_internal
   BLACK_EXPORT
   std::optional<logic::formula>
   parse_formula(
-    logic::alphabet &sigma, std::string const&s, parser::error_handler error
+    logic::alphabet &sigma, std::string_view s, parser::error_handler error
   );
 
   BLACK_EXPORT
@@ -69,7 +75,7 @@ namespace black_internal
 
   BLACK_EXPORT
   inline std::optional<logic::formula>
-  parse_formula(logic::alphabet &sigma, std::string const&s) {
+  parse_formula(logic::alphabet &sigma, std::string_view s) {
     return parse_formula(sigma, s, [](auto){});
   }
 
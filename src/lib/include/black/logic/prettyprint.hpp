@@ -27,13 +27,43 @@
 #include <black/support/common.hpp>
 #include <black/logic/logic.hpp>
 
+#include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
 
 namespace black_internal::logic
 {
   
   BLACK_EXPORT
   std::string to_string(formula f);
+
+  //
+  // How `to_string()` prints the subformulas and subterms that occur more
+  // than once in a formula. With `print_sharing::let`, each of them is bound
+  // to a fresh name by a `let name = value in ...` binding and printed only
+  // once, so the output is linear in the size of the DAG of the formula
+  // rather than of its tree. The parser reads such bindings back.
+  //
+  enum class print_sharing : uint8_t {
+    expand,
+    let
+  };
+
+  BLACK_EXPORT
+  std::string to_string(formula f, print_sharing sharing);
+
+  //
+  // Streaming versions of `to_string()`, writing the output directly to 
+  // `out` without building it in memory first.
+  //
+  BLACK_EXPORT
+  void print(
+    std::ostream &out, formula f, print_sharing sharing = print_sharing::expand
+  );
+
+  BLACK_EXPORT
+  void print(std::ostream &out, term t);
   
   BLACK_EXPORT
   std::string to_string(term t);
@@ -50,9 +80,58 @@ namespace black_internal::logic
   BLACK_EXPORT
   std::string to_string(sort s);
 
+  //
+  // SMT-LIB 2 script asserting `f`, with the symbols it declared in `xi`.
+  // With `print_sharing::let`, shared subformulas and subterms of each
+  // assertion are bound with SMT-LIB `let`s instead of being repeated.
+  //
+  BLACK_EXPORT
+  std::string to_smtlib2(
+    formula f, scope const& xi, print_sharing sharing = print_sharing::expand
+  );
+
   BLACK_EXPORT
-  std::string to_smtlib2(formula f, scope const& xi);
+  void print_smtlib2(
+    std::ostream &out, formula f, scope const& xi, 
+    print_sharing sharing = print_sharing::expand
+  );
+
+  //
+  // Incremental SMT-LIB 2 script, written to `out` one command at a time.
+  // Each symbol is declared just before the first command that uses it, with
+  // the sort given by the scope passed along, so the script can follow a
+  // scope that keeps growing while the script is written, as the one of the
+  // solver does while the encoding is unrolled.
+  //
+  class BLACK_EXPORT smtlib2_script
+  {
+  public:
+    explicit smtlib2_script(
+      std::ostream &out, print_sharing sharing = print_sharing::let
+    );
+    ~smtlib2_script();
+
+    smtlib2_script(smtlib2_script const&) = delete;
+    smtlib2_script &operator=(smtlib2_script const&) = delete;
+
+    void comment(std::string_view text);
+    void assert_formula(formula f, scope const& xi);
+    void check_sat();
+
+    // `(check-sat-assuming)` accepts only literals, so any other assumption 
+    // is named by a fresh proposition inside a `(push)`/`(pop)` pair
+    void check_sat_assuming(formula f, scope const& xi);
+
+  private:
+    struct _script_t;
+    std::unique_ptr<_script_t> _data;
+  };
+
+}
 
+namespace black {
+  using black_internal::logic::print_sharing;
+  using black_internal::logic::smtlib2_script;
 }
 
 #endif // BLACK_LOGIC_PRETTY_PRINT_HPP
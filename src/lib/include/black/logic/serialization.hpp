@@ -0,0 +1,101 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BLACK_LOGIC_SERIALIZATION_HPP
+#define BLACK_LOGIC_SERIALIZATION_HPP
+
+#include <black/support/common.hpp>
+#include <black/logic/logic.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+//
+// Binary serialization of formulas.
+//
+// The format stores each node reachable from the given formulas only once, in
+// an order where children come before their parents, so the sharing of
+// subterms in the alphabet is preserved both in the file and when reading it
+// back. Identifiers and the names of the syntax elements are collected in a
+// string table. All the data is made of 32-bit little-endian words, so a file
+// can be memory-mapped and read in a single linear pass (see
+// `load_formulas()`).
+//
+// Labels of propositions, variables, relations, functions and sorts can be
+// strings, integers, formulas, and the `(string_view, formula)` pairs used by
+// `remove_past()`. Formulas with other labels, or with sort declarations
+// carrying a domain, cannot be serialized.
+//
+namespace black_internal::serialization
+{
+  using error_handler = std::function<void(std::string)>;
+
+  //
+  // Writes the formulas to `out`, which should be opened in binary mode.
+  // Returns `false` and calls `error` if some of them cannot be serialized,
+  // in which case nothing is written.
+  //
+  BLACK_EXPORT
+  bool serialize(
+    std::ostream &out, std::vector<logic::formula> const& formulas,
+    error_handler error
+  );
+
+  BLACK_EXPORT
+  bool serialize(std::ostream &out, logic::formula f, error_handler error);
+
+  //
+  // Reads back in `sigma` the formulas serialized in `data`, in the same
+  // order. Returns `std::nullopt` and calls `error` if the data is malformed.
+  //
+  BLACK_EXPORT
+  std::optional<std::vector<logic::formula>>
+  deserialize(
+    logic::alphabet &sigma, std::span<std::byte const> data,
+    error_handler error
+  );
+
+  //
+  // Same as above, but reading the file at the given path, which is
+  // memory-mapped where supported.
+  //
+  BLACK_EXPORT
+  std::optional<std::vector<logic::formula>>
+  load_formulas(
+    logic::alphabet &sigma, std::string const& path, error_handler error
+  );
+}
+
+// Names exported to the user
+namespace black {
+  using black_internal::serialization::serialize;
+  using black_internal::serialization::deserialize;
+  using black_internal::serialization::load_formulas;
+}
+
+#endif // BLACK_LOGIC_SERIALIZATION_HPP
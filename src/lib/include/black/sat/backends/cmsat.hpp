@@ -34,6 +34,7 @@ namespace black_internal::cmsat
 
     virtual void new_vars(size_t n) override;
     virtual void assert_clause(dimacs::clause f) override;
+    virtual void assert_clauses(std::span<dimacs::clause const> cs) override;
     virtual tribool is_sat() override;
     virtual tribool 
       is_sat_with(std::vector<dimacs::literal> const& assumptions) override;
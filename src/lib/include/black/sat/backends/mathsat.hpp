@@ -47,6 +47,7 @@ namespace black_internal::mathsat
     virtual tribool value(equality a) const override;
     virtual tribool value(comparison a) const override;
     virtual void clear() override;
+    virtual void reset(scope const& xi) override;
     virtual void interrupt() override;
     virtual std::optional<std::string> license() const override;
 
@@ -37,13 +37,18 @@ namespace black_internal::z3
     ~z3() override;
 
     virtual void assert_formula(formula f) override;
+    virtual void assert_formulas(std::span<formula const> fs) override;
     virtual tribool is_sat() override;
     virtual tribool is_sat_with(formula assumption) override;
+    virtual tribool 
+    is_sat_assuming(std::span<formula const> assumptions) override;
+    virtual std::vector<formula> unsat_assumptions() const override;
     virtual tribool value(proposition a) const override;
     virtual tribool value(atom a) const override;
     virtual tribool value(equality a) const override;
     virtual tribool value(comparison a) const override;
     virtual void clear() override;
+    virtual void reset(scope const& xi) override;
     virtual void interrupt() override;
     virtual std::optional<std::string> license() const override;
 
@@ -30,6 +30,7 @@
 #include <black/logic/cnf.hpp>
 
 #include <istream>
+#include <span>
 #include <string>
 #include <cstdint>
 
@@ -60,6 +61,8 @@ namespace black_internal::dimacs
 
     // sat::solver interface
     virtual void assert_formula(logic::formula f) override;
+
+    virtual void assert_formulas(std::span<logic::formula const> fs) override;
     
     virtual tribool is_sat_with(logic::formula assumption) override;
     
@@ -79,6 +82,12 @@ namespace black_internal::dimacs
     // assert a new clause
     virtual void assert_clause(clause c) = 0;
 
+    // assert a batch of clauses
+    virtual void assert_clauses(std::span<clause const> cs) {
+      for(clause const& c : cs)
+        assert_clause(c);
+    }
+
     // solve the instance
     virtual tribool is_sat() override = 0;
 
@@ -91,6 +100,9 @@ namespace black_internal::dimacs
     // clears the state of the solver
     virtual void clear() override = 0;
 
+    // DIMACS solvers do not depend on the scope, so this is just clear()
+    virtual void reset(scope const& xi) override;
+
     // interrupts the last call to is_sat() or is_sat_with(), 
     // if supported by the backend
     virtual void interrupt() override = 0;
@@ -31,6 +31,7 @@
 #include <memory>
 #include <type_traits>
 #include <string_view>
+#include <span>
 #include <vector>
 
 namespace black::sat 
@@ -52,9 +53,17 @@ namespace black::sat
     static std::vector<std::string_view> backends();
     static bool backend_exists(std::string_view name);
     static bool backend_has_feature(std::string_view name, feature f);
+    
+    //
+    // Backend instances are pooled per thread: get_solver() reuses, if
+    // available, an instance previously given back by the same thread through
+    // recycle(), resetting it and binding it to the new scope. This saves the
+    // construction of a new solver context for each of many short queries.
+    //
     static std::unique_ptr<solver> get_solver(
       std::string_view name, scope const& xi
     );
+    static void recycle(std::unique_ptr<solver> s);
 
     // solver is a polymorphic, non-copyable type
     solver(const solver &) = delete;
@@ -65,12 +74,29 @@ namespace black::sat
     // assert a formula, adding it to the current context
     virtual void assert_formula(formula f) = 0;
 
+    // assert a batch of formulas at once. Backends override this when they
+    // have something faster than asserting the formulas one by one.
+    virtual void assert_formulas(std::span<formula const> fs) {
+      for(formula f : fs)
+        assert_formula(f);
+    }
+
     // tell if the current set of assertions is satisfiable
     virtual tribool is_sat() = 0;
     
     // tell if the current set of assertions is satisfiable, 
     // under the given assumption
     virtual tribool is_sat_with(formula assumption) = 0;
+
+    // tell if the current set of assertions is satisfiable, under all the 
+    // given assumptions at once. Backends override this when they can tell
+    // which assumptions have been used to refute the assertions (see below).
+    virtual tribool is_sat_assuming(std::span<formula const> assumptions);
+
+    // after a call to is_sat_assuming() that returned false, gets a subset of
+    // the assumptions that is enough to make the assertions unsatisfiable.
+    // The default implementation just returns all of them.
+    virtual std::vector<formula> unsat_assumptions() const;
     
     // gets the value of a proposition from the solver.
     // The result is tribool::undef if the variable has not been decided
@@ -99,12 +125,27 @@ namespace black::sat
     // clear the current context completely
     virtual void clear() = 0;
 
-    // interrupts the current call to is_sat() or is_sat_with(),
-    // if supported by the backend
+    // clear the current context completely and bind the solver to a new
+    // scope, as if it had been just constructed with `xi`
+    virtual void reset(scope const& xi) = 0;
+
+    // interrupts the current call to is_sat(), is_sat_with() or
+    // is_sat_assuming(), if supported by the backend. If no call is running,
+    // the backend may cancel the next one instead.
     virtual void interrupt() = 0;
 
     // License note for whatever third-party software lies under the hood
     virtual std::optional<std::string> license() const = 0;
+
+  private:
+    // name of the backend this instance has been created for
+    std::string_view _backend;
+
+    // how many times this instance has been handed out by get_solver()
+    size_t _uses = 0;
+
+    // assumptions of the last call to the default is_sat_assuming()
+    std::vector<formula> _assumptions;
   };
 
   namespace internal {
@@ -27,14 +27,32 @@
 #include <black/logic/logic.hpp>
 #include <black/support/common.hpp>
 
+#include <optional>
 #include <string>
 
 namespace black_internal::core {
   
   using namespace black;
 
+  //
+  // Computes a minimal unsatisfiable core of `f`, where the subformulas not
+  // needed for unsatisfiability are replaced by `core_placeholder_t` 
+  // propositions. The checks are spread over the given number of threads. 
+  // With more than one, the alphabet of `f` is switched to concurrent mode
+  // (see `alphabet::make_concurrent()`), and the result may differ from run
+  // to run, since it depends on which checks finish first.
+  //
+  // If `bound_factor` is given, the checks made to drop each subformula look
+  // only up to that many times the bound needed to refute `f`, and the 
+  // subformulas that cannot be dropped within it are kept. This may speed up
+  // the extraction a lot, but the result is then minimal only among the
+  // cores refuted within that bound.
+  //
   BLACK_EXPORT
-  formula unsat_core(scope const& xi, formula f, bool finite);
+  formula unsat_core(
+    scope const& xi, formula f, bool finite, size_t threads = 1,
+    std::optional<size_t> bound_factor = std::nullopt
+  );
 
   struct core_placeholder_t {
     size_t n;
@@ -49,6 +67,11 @@ namespace black_internal::core {
   inline std::string to_string(core_placeholder_t p) {
     return std::to_string(p.n);
   }
+
+  // see `alphabet::release()`
+  inline void trace_nodes(core_placeholder_t const& p, node_list &out) {
+    out.push_back(p.f.node());
+  }
 }
 
 namespace black {
@@ -113,6 +113,17 @@ namespace black_internal::solver {
       // Retrieve the current SAT backend
       std::string sat_backend() const;
 
+      // Choose how non-rigid first-order symbols are encoded at each step.
+      // By default a fresh symbol is made for each of them at each step.
+      // With the time-indexed encoding, each of them becomes a single 
+      // uninterpreted function with the time step as an additional 
+      // argument, e.g. `x(k)` and `f(k, t)`, which keeps the number of 
+      // declarations seen by the backend independent from the bound.
+      void set_timed_encoding(bool timed);
+
+      // Tells whether the time-indexed encoding is selected
+      bool timed_encoding() const;
+
       // Data type sent to the debug trace routine
       struct trace_t {
         enum type_t {
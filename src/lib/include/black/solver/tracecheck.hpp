@@ -0,0 +1,164 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BLACK_SOLVER_TRACECHECK_HPP
+#define BLACK_SOLVER_TRACECHECK_HPP
+
+#include <black/support/common.hpp>
+#include <black/logic/logic.hpp>
+#include <black/support/tribool.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+//
+// Checking of propositional LTL+Past formulas over a given trace.
+//
+// The propositions of the formula are numbered by the `trace_checker`, and a
+// `trace` stores the values of each of them over all the states as a packed
+// bitset, 64 states per word. The formula is compiled once into a sequence of
+// operations on such bitsets, where each subformula is evaluated over all the
+// states at once, after its children. Boolean and next/yesterday operators
+// are plain word-level operations, while until and since use the carry chain
+// of an addition to propagate their values across a word. Checking a
+// formula `f` over a trace of `n` states thus takes O(|f| * n / 64) time.
+// The same evaluation is used by `monitor` over the last states of a trace
+// that is given one state at a time.
+//
+namespace black_internal::tracecheck
+{
+  using namespace black;
+
+  //
+  // A finite trace, or an infinite one where the states from `loop()`
+  // onwards repeat forever. Propositions are identified by the indexes given
+  // by `trace_checker::propositions()`, and initially hold in all states.
+  //
+  class BLACK_EXPORT trace 
+  {
+  public:
+    trace(size_t propositions, size_t size, std::optional<size_t> loop);
+
+    size_t size() const { return _size; }
+    std::optional<size_t> loop() const { return _loop; }
+
+    bool value(size_t proposition, size_t t) const;
+    void set(size_t proposition, size_t t, bool value);
+
+  private:
+    friend class trace_checker;
+
+    size_t _size;
+    std::optional<size_t> _loop;
+    
+    // the values of each proposition over time, 64 states per word
+    std::vector<std::vector<uint64_t>> _values;
+  };
+
+  class BLACK_EXPORT trace_checker 
+  {
+  public:
+    //
+    // Compiles `f`, which has to be a propositional LTL+Past formula.
+    //
+    explicit trace_checker(formula f);
+    ~trace_checker();
+
+    trace_checker(trace_checker const&) = delete;
+    trace_checker &operator=(trace_checker const&) = delete;
+    trace_checker(trace_checker &&);
+    trace_checker &operator=(trace_checker &&);
+
+    // the propositions of the formula, in the order of their indexes
+    std::vector<proposition> const& propositions() const;
+
+    //
+    // Tells whether the formula holds at state `t` of the trace, which must
+    // exist if the trace is finite. If given, `report` is called with the
+    // value at `t` of each subformula, children first. Calls on the same
+    // checker from different threads are safe.
+    //
+    bool check(
+      trace const& tr, size_t t = 0,
+      std::function<void(formula, bool)> const& report = {}
+    ) const;
+
+  private:
+    friend class monitor;
+
+    struct _checker_t;
+    std::unique_ptr<_checker_t> _data;
+  };
+
+  //
+  // Online checking of a formula over a trace given one state at a time, 
+  // where the verdict for each state is given once the following 
+  // `lookahead` states have arrived. Only those states are stored, together
+  // with the values of each subformula at the state before them, so the
+  // memory used does not grow with the trace. The verdict is `undef` if it
+  // still depends on the states yet to come.
+  //
+  class BLACK_EXPORT monitor
+  {
+  public:
+    monitor(formula f, size_t lookahead);
+    ~monitor();
+
+    monitor(monitor const&) = delete;
+    monitor &operator=(monitor const&) = delete;
+    monitor(monitor &&);
+    monitor &operator=(monitor &&);
+
+    // the propositions of the formula, in the order of their indexes
+    std::vector<proposition> const& propositions() const;
+
+    //
+    // Adds the next state, where `state[i]` is the value of the i-th 
+    // proposition, and returns the verdict for the state `lookahead` states
+    // before, if any.
+    //
+    std::optional<tribool> push(std::vector<bool> const& state);
+
+    //
+    // Ends the trace and returns the verdicts for the states still waiting
+    // for one. If `finite`, the trace ends with the last state pushed,
+    // otherwise it goes on with unknown states.
+    //
+    std::vector<tribool> finish(bool finite);
+
+  private:
+    struct _monitor_t;
+    std::unique_ptr<_monitor_t> _data;
+  };
+}
+
+namespace black {
+  using black_internal::tracecheck::trace;
+  using black_internal::tracecheck::trace_checker;
+  using black_internal::tracecheck::monitor;
+}
+
+#endif // BLACK_SOLVER_TRACECHECK_HPP
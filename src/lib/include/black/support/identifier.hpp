@@ -27,7 +27,13 @@
 #include <black/support/assert.hpp>
 #include <black/support/to_string.hpp>
 
-#include <any>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
 #include <tuple>
 #include <optional>
 #include <vector>
@@ -59,6 +65,91 @@ namespace black_internal {
   };
 }
 
+namespace black_internal::logic {
+  struct hierarchy_node;
+}
+
+namespace black_internal {
+  //
+  // Identifiers can wrap hierarchy types, as in the `std::tuple{f, k}` labels
+  // of the propositions made by the encoder. The alphabet's garbage collector
+  // (see `alphabet::release()`) has to know which nodes are referenced in this
+  // way, so identifiers remember how to enumerate them. The following
+  // functions find the nodes referenced by a value, looking into tuples,
+  // pairs, vectors, optionals and shared pointers. Other types can take part
+  // by providing a `trace_nodes()` overload found by ADL (see e.g.
+  // `core_placeholder_t`). Values of any other type, except numbers, enums
+  // and strings, might reference nodes in unknown ways, so they are reported
+  // with a null pointer, and the garbage collector then keeps everything.
+  //
+  template<typename T>
+  concept node_handle = requires(T t) {
+    { t.node() } -> std::convertible_to<logic::hierarchy_node const*>;
+  };
+
+  using node_list = std::vector<logic::hierarchy_node const*>;
+
+  inline void trace_nodes(logic::hierarchy_node const *node, node_list &out) {
+    out.push_back(node);
+  }
+
+  template<typename T>
+  void trace_nodes(std::optional<T> const&, node_list &);
+  template<typename T>
+  void trace_nodes(std::vector<T> const&, node_list &);
+  template<typename T, typename U>
+  void trace_nodes(std::pair<T, U> const&, node_list &);
+  template<typename ...T>
+  void trace_nodes(std::tuple<T...> const&, node_list &);
+  template<typename T>
+  void trace_nodes(std::shared_ptr<T> const&, node_list &);
+
+  template<typename T>
+  void trace_nodes(T const&, node_list &out) { 
+    if constexpr(
+      !std::is_arithmetic_v<T> && !std::is_enum_v<T> &&
+      !std::is_convertible_v<T const&, std::string_view>
+    )
+      out.push_back(nullptr);
+  }
+
+  template<node_handle T>
+  void trace_nodes(T const& v, node_list &out) {
+    out.push_back(v.node());
+  }
+
+  template<typename T>
+  void trace_nodes(std::optional<T> const& v, node_list &out) {
+    if(v)
+      trace_nodes(*v, out);
+  }
+
+  template<typename T>
+  void trace_nodes(std::vector<T> const& v, node_list &out) {
+    for(auto const& x : v)
+      trace_nodes(x, out);
+  }
+
+  template<typename T, typename U>
+  void trace_nodes(std::pair<T, U> const& p, node_list &out) {
+    trace_nodes(p.first, out);
+    trace_nodes(p.second, out);
+  }
+
+  template<typename ...T>
+  void trace_nodes(std::tuple<T...> const& t, node_list &out) {
+    std::apply([&](auto const& ...v) {
+      (trace_nodes(v, out), ...);
+    }, t);
+  }
+
+  template<typename T>
+  void trace_nodes(std::shared_ptr<T> const& p, node_list &out) {
+    if(p)
+      trace_nodes(*p, out);
+  }
+}
+
 namespace black_internal::identifier_details
 {
   template<typename T>
@@ -77,40 +168,85 @@ namespace black_internal::identifier_details
   template<typename T>
   inline constexpr bool is_tuple_v = is_tuple<T>::value;
 
+
+  //
+  // Hash functions for labels. Tuples and pairs are hashed element-wise
+  // since the standard library does not provide `std::hash` for them.
+  //
+  template<typename T>
+  size_t hash_label(T const& v) {
+    return std::hash<T>{}(v);
+  }
+
+  template<typename ...T>
+  size_t hash_label(std::tuple<T...> const& t) {
+    return std::apply([](auto const& ...v) {
+      size_t h = 0;
+      ((h = hash_combine(h, std::hash<std::remove_cvref_t<decltype(v)>>{}(v))), ...);
+      return h;
+    }, t);
+  }
+
+  template<typename T, typename U>
+  size_t hash_label(std::pair<T, U> const& p) {
+    size_t h1 = std::hash<T>{}(p.first);
+    size_t h2 = std::hash<U>{}(p.second);
+    return hash_combine(h1, h2);
+  }
+
   //
   // Type-erased hashable, comparable and printable value
   //
+  // Identifiers are hashed and compared all the time when the alphabet
+  // interns propositions, variables, etc., so the hash is computed once at
+  // construction, and comparisons of different identifiers usually stop
+  // there. Labels are stored inline if they are small enough and nothrow
+  // movable, which covers strings and the small tuples of handles and
+  // integers made by the encoder, and on the heap otherwise. The operations
+  // on the stored value are collected in a static table for each label type.
+  //
   class identifier
   {
   public:
     identifier() = default;
-    identifier(identifier const&) = default;
-    identifier(identifier&&) = default;
+
+    identifier(identifier const& other) 
+      : _ops{other._ops}, _hash{other._hash} 
+    {
+      if(_ops)
+        _ops->copy(_buffer, other._buffer);
+    }
+
+    identifier(identifier&& other) noexcept 
+      : _ops{other._ops}, _hash{other._hash} 
+    {
+      if(_ops)
+        _ops->move(_buffer, other._buffer);
+      other._ops = nullptr;
+    }
+
+    ~identifier() { 
+      reset(); 
+    }
 
     template<typename T>
       requires (
         !std::is_same_v<std::remove_cvref_t<T>, identifier> &&
         !is_tuple_v<std::remove_cvref_t<T>>
       )
-    identifier(T&& value)
-      : _any(std::forward<T>(value)),
-        _hash(make_hasher(value)),
-        _cmp(make_cmp(value)),
-        _printer(make_printer(value)) { }
+    identifier(T&& value) {
+      emplace<std::remove_cvref_t<T>>(std::forward<T>(value));
+    }
 
     template<typename ...T>
-    identifier(std::tuple<T...> const& t) 
-      : _any(t),
-        _hash(make_tuple_hasher(t)),
-        _cmp(make_cmp(t)),
-        _printer(make_printer(t)) { }
+    identifier(std::tuple<T...> const& t) {
+      emplace<std::tuple<T...>>(t);
+    }
 
     template<typename T, typename U>
-    identifier(std::pair<T, U> const& t) 
-      : _any(t),
-        _hash(make_pair_hasher(t)),
-        _cmp(make_cmp(t)),
-        _printer(make_printer(t)) { }
+    identifier(std::pair<T, U> const& p) {
+      emplace<std::pair<T, U>>(p);
+    }
 
     identifier(std::string_view view) 
       : identifier{std::string{view}} { }
@@ -119,15 +255,35 @@ namespace black_internal::identifier_details
       : identifier{std::string{c_str}} { }
 
     size_t hash() const {
-      black_assert(_any.has_value());
-      return _hash(_any);
+      black_assert(_ops != nullptr);
+      return _hash;
     }
 
-    identifier &operator=(identifier const&) = default;
-    identifier &operator=(identifier&&) = default;
+    identifier &operator=(identifier const& other) {
+      if(this != &other)
+        *this = identifier{other};
+      return *this;
+    }
+
+    identifier &operator=(identifier&& other) noexcept {
+      if(this == &other)
+        return *this;
+
+      reset();
+      _ops = other._ops;
+      _hash = other._hash;
+      if(_ops)
+        _ops->move(_buffer, other._buffer);
+      other._ops = nullptr;
+
+      return *this;
+    }
 
     bool operator==(identifier const&other) const {
-      return _cmp(_any, other);
+      black_assert(_ops != nullptr);
+      return _hash == other._hash && other._ops != nullptr &&
+             _ops->type == other._ops->type &&
+             _ops->equal(_buffer, other._buffer);
     }
 
     template<typename T>
@@ -139,107 +295,137 @@ namespace black_internal::identifier_details
 
     template<typename T>
     bool is() const {
-      return std::any_cast<T>(&_any) != nullptr;
+      return get<T>() != nullptr;
     }
 
     template<typename T>
     std::optional<T> to() const & {
-      if(T const*ptr = std::any_cast<T>(&_any); ptr)
+      if(T const*ptr = get<T>(); ptr)
         return std::optional<T>{*ptr};
       return std::nullopt;
     }
 
     template<typename T>
     std::optional<T> to() && {
-      if(T const*ptr = std::any_cast<T>(&_any); ptr)
+      if(T *ptr = get<T>(); ptr)
         return std::optional<T>{std::move(*ptr)};
       return std::nullopt;
     }
 
     template<typename T>
-    T const* get() const & { return std::any_cast<T>(&_any); }
+    T const* get() const & { 
+      if(!_ops || _ops->type != typeid(T))
+        return nullptr;
+      return value<T>(_buffer);
+    }
 
     template<typename T>
-    T *get() & { return std::any_cast<T>(&_any); }
+    T *get() & { 
+      return const_cast<T *>(std::as_const(*this).get<T>());
+    }
 
-    std::any const&any() const { return _any; }
+    // appends to `out` the nodes referenced by the label, if any
+    void nodes(node_list &out) const {
+      if(_ops)
+        _ops->trace(_buffer, out);
+    }
 
     friend std::string to_string(identifier const&id) {
-      return id._printer(id._any);
+      black_assert(id._ops != nullptr);
+      return id._ops->print(id._buffer);
     }
 
   private:
-    using hasher_t = size_t (*)(std::any const&);
-    using comparator_t = bool (*)(std::any const&, identifier const&);
-    using printer_t = std::string (*)(std::any const&);
-
-    std::any _any;
-    hasher_t _hash;
-    comparator_t _cmp;
-    printer_t _printer;
+    static constexpr size_t buffer_size = 4 * sizeof(void *);
 
-    //
-    // note: these two function templates cause gcov false negatives
     template<typename T>
-    hasher_t make_hasher(T const&) { // LCOV_EXCL_LINE
-      return [](std::any const&me) -> size_t { // LCOV_EXCL_LINE
-        T const *v = std::any_cast<T>(&me); // LCOV_EXCL_LINE
-        black_assert(v != nullptr); // LCOV_EXCL_LINE
-
-        return std::hash<T>{}(*v); // LCOV_EXCL_LINE
-      };
-    }
-    
-    template<typename ...T>
-    hasher_t make_tuple_hasher(std::tuple<T...> const&) {
-      return [](std::any const&me) -> size_t {
-        std::tuple<T...> const *t = std::any_cast<std::tuple<T...>>(&me);
-        black_assert(t != nullptr);
-
-        return std::apply([](auto ...v) {
-          size_t h = 0;
-          ((h = hash_combine(h, std::hash<decltype(v)>{}(v))), ...);
-          return h;
-        }, *t);
-      };
-    }
-    
-    template<typename T, typename U>
-    hasher_t make_pair_hasher(std::pair<T, U> const&) {
-      return [](std::any const&me) -> size_t {
-        std::pair<T, U> const *p = std::any_cast<std::pair<T, U>>(&me);
-        black_assert(p != nullptr);
-
-        size_t h1 = std::hash<T>{}(p->first);
-        size_t h2 = std::hash<U>{}(p->second);
-        return hash_combine(h1, h2);
-      };
-    }
+    static constexpr bool is_inline_v = 
+      sizeof(T) <= buffer_size && alignof(T) <= alignof(void *) &&
+      std::is_nothrow_move_constructible_v<T>;
+
+    struct label_ops {
+      std::type_info const& type;
+      void (*copy)(std::byte *, std::byte const *);
+      void (*move)(std::byte *, std::byte *) noexcept; // also destroys source
+      void (*destroy)(std::byte *) noexcept;
+      bool (*equal)(std::byte const *, std::byte const *);
+      std::string (*print)(std::byte const *);
+      void (*trace)(std::byte const *, node_list &);
+    };
 
     template<typename T>
-    comparator_t make_cmp(T const&) { // LCOV_EXCL_LINE
-      return [](std::any const&me, identifier const&other) -> bool { // LCOV_EXCL_LINE
-        T const* v = std::any_cast<T>(&me); // LCOV_EXCL_LINE
-        T const* otherv = other.get<T>(); // LCOV_EXCL_LINE
-
-        black_assert(v != nullptr); // LCOV_EXCL_LINE
+    static T const *value(std::byte const *buffer) {
+      if constexpr(is_inline_v<T>)
+        return std::launder(reinterpret_cast<T const *>(buffer));
+      else
+        return *std::launder(reinterpret_cast<T * const *>(buffer));
+    }
 
-        return otherv != nullptr && *v == *otherv; // LCOV_EXCL_LINE
-      };
+    template<typename T, typename ...Args>
+    static void construct(std::byte *buffer, Args&& ...args) {
+      if constexpr(is_inline_v<T>)
+        new(buffer) T(std::forward<Args>(args)...);
+      else
+        new(buffer) T *(new T(std::forward<Args>(args)...));
     }
 
+    // note: these lambdas cause gcov false negatives
     template<typename T>
-    printer_t make_printer(T const&) {
-      return [](std::any const&me) -> std::string {
-        T const *v = std::any_cast<T>(&me);
-        black_assert(v != nullptr);
+    static inline label_ops const ops_v = { // LCOV_EXCL_LINE
+      typeid(T),
+      [](std::byte *dst, std::byte const *src) { // LCOV_EXCL_LINE
+        construct<T>(dst, *value<T>(src)); // LCOV_EXCL_LINE
+      },
+      [](std::byte *dst, std::byte *src) noexcept { // LCOV_EXCL_LINE
+        if constexpr(is_inline_v<T>) {
+          T *v = std::launder(reinterpret_cast<T *>(src));
+          new(dst) T(std::move(*v));
+          v->~T();
+        } else
+          new(dst) T *(*std::launder(reinterpret_cast<T **>(src)));
+      },
+      [](std::byte *buffer) noexcept { // LCOV_EXCL_LINE
+        if constexpr(is_inline_v<T>)
+          std::launder(reinterpret_cast<T *>(buffer))->~T();
+        else
+          delete *std::launder(reinterpret_cast<T **>(buffer));
+      },
+      [](std::byte const *b1, std::byte const *b2) -> bool { // LCOV_EXCL_LINE
+        return *value<T>(b1) == *value<T>(b2); // LCOV_EXCL_LINE
+      },
+      [](std::byte const *buffer) -> std::string { // LCOV_EXCL_LINE
+        return to_string(*value<T>(buffer)); // LCOV_EXCL_LINE
+      },
+      [](std::byte const *buffer, node_list &out) { // LCOV_EXCL_LINE
+        trace_nodes(*value<T>(buffer), out); // LCOV_EXCL_LINE
+      }
+    };
+
+    template<typename T, typename Arg>
+    void emplace(Arg&& arg) {
+      construct<T>(_buffer, std::forward<Arg>(arg));
+      _ops = &ops_v<T>;
+      _hash = hash_label(*value<T>(_buffer));
+    }
 
-        return to_string(*v);
-      };
+    void reset() {
+      if(_ops)
+        _ops->destroy(_buffer);
+      _ops = nullptr;
     }
+
+    alignas(void *) std::byte _buffer[buffer_size];
+    label_ops const *_ops = nullptr;
+    size_t _hash = 0;
   };
 }
 
+namespace black_internal::identifier_details {
+  inline void trace_nodes(identifier const& id, node_list &out) {
+    id.nodes(out);
+  }
+}
+
 namespace black_internal {
   using identifier_details::identifier;
 }
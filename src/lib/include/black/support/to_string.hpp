@@ -50,10 +50,12 @@ namespace black_internal {
     struct to_string_niebloid {
       constexpr to_string_niebloid() = default;
 
-      template<typename T>
-      auto operator()(T&& v) const -> decltype(to_string(std::forward<T>(v))) {
+      template<typename T, typename ...Args>
+      auto operator()(T&& v, Args&& ...args) const 
+        -> decltype(to_string(std::forward<T>(v), std::forward<Args>(args)...))
+      {
         //using std::to_string;
-        return to_string(std::forward<T>(v));
+        return to_string(std::forward<T>(v), std::forward<Args>(args)...);
       }
     };
 
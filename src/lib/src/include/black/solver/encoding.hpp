@@ -70,6 +70,31 @@ namespace black_internal::encoder {
     return "{" + to_string(to_formula(req)) + "}"; 
   }
 
+  // see `alphabet::release()`
+  inline void trace_nodes(req_t const& req, node_list &out) {
+    out.push_back(req.target.node());
+    black_internal::trace_nodes(req.signature, out);
+  }
+
+  //
+  // The encoder builds its long conjunctions and disjunctions as single n-ary
+  // nodes (see `fold_nary_op()` in `interface.hpp`). They are not canonical,
+  // but the formulas made by the encoder never reach the user.
+  //
+  template<std::ranges::range Range, typename F>
+  formula flat_and(alphabet &sigma, Range const& r, F&& f) {
+    return fold_nary_op<
+      syntax_element::conjunction, syntax_element::big_conjunction
+    >(r, sigma.boolean(true), std::forward<F>(f));
+  }
+  
+  template<std::ranges::range Range, typename F>
+  formula flat_or(alphabet &sigma, Range const& r, F&& f) {
+    return fold_nary_op<
+      syntax_element::disjunction, syntax_element::big_disjunction
+    >(r, sigma.boolean(false), std::forward<F>(f));
+  }
+
   struct lookahead_t {
     bool operator==(lookahead_t const&) const = default;
 
@@ -84,10 +109,10 @@ namespace black_internal::encoder {
   //
   struct encoder 
   {
-    encoder(formula f, scope &xi, bool finite) 
+    encoder(formula f, scope &xi, bool finite, bool timed = false) 
       : _frm{f}, _sigma{_frm.sigma()}, 
         _global_xi{&xi}, _xi{chain(xi)}, 
-        _finite{finite}
+        _finite{finite}, _timed{timed}
     {
       _frm = to_nnf(_frm);
       _collect_requests(_frm);
@@ -108,6 +133,8 @@ namespace black_internal::encoder {
     static proposition stepped(proposition p, size_t k);
 
     // Make the stepped version of a term, t_G^k
+    // In the time-indexed encoding, non-rigid variables `x` and function
+    // applications `f(t1, ..., tn)` become `x(k)` and `f(k, t1, ..., tn)`
     term stepped(term t, size_t k);
 
     // Make the stepped version of a variable
@@ -176,6 +203,10 @@ namespace black_internal::encoder {
     // encode for finite models
     bool _finite = false;
 
+    // encode non-rigid first-order symbols as a single function of time 
+    // instead of a fresh symbol for each step
+    bool _timed = false;
+
     // X/Y/Z-requests from the formula's closure
     std::vector<req_t> _requests;
 
@@ -183,11 +214,15 @@ namespace black_internal::encoder {
     std::vector<lookahead_t> _lookaheads;
 
     // cache to memoize to_nnf() calls
-    tsl::hopscotch_map<formula, formula> _nnf_cache;
+    tsl::hopscotch_map<compact<formula>, compact<formula>> _nnf_cache;
 
     proposition not_last_prop(size_t);
     proposition not_first_prop(size_t);
-    variable ground(lookahead_t lh, size_t k);
+    term time(size_t k);
+    function timed(variable x);
+    function timed(function f);
+    relation timed(relation r);
+    term ground(lookahead_t lh, size_t k);
     formula ground(req_t, size_t);
     formula forall(std::vector<var_decl> env, formula f);
 
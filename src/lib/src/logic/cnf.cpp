@@ -26,6 +26,8 @@
 
 #include <tsl/hopscotch_set.h>
 
+#include <algorithm>
+
 namespace black_internal::cnf
 { 
   using namespace black;
@@ -117,30 +119,64 @@ namespace black_internal::cnf
     return sigma.boolean(bl->value() == br->value());
   }
 
+  static
+  formula remove_booleans(big_conjunction c, std::vector<formula> const& ops) {
+    alphabet &sigma = *c.sigma();
+    for(formula op : ops)
+      if(auto b = op.to<boolean>(); b && !b->value())
+        return sigma.bottom();
+
+    return fold_nary_op<
+      syntax_element::conjunction, syntax_element::big_conjunction
+    >(ops, sigma.top(), [](formula op) { return op; });
+  }
+
+  static
+  formula remove_booleans(big_disjunction c, std::vector<formula> const& ops) {
+    alphabet &sigma = *c.sigma();
+    for(formula op : ops)
+      if(auto b = op.to<boolean>(); b && b->value())
+        return sigma.top();
+
+    return fold_nary_op<
+      syntax_element::disjunction, syntax_element::big_disjunction
+    >(ops, sigma.bottom(), [](formula op) { return op; });
+  }
+
   formula remove_booleans(auto, auto ...) {
     black_unreachable();
   }
 
   formula remove_booleans(formula f) {
-    return f.match( // LCOV_EXCL_LINE
-      [](boolean b)     -> formula { return b; },
-      [](proposition p) -> formula { return p; },
-      [](auto op, auto ...args) -> formula {
-        return remove_booleans(op, remove_booleans(args)...);
-      }
-    ).match(
-      [](boolean b)     -> formula { return b; },
-      [](proposition p) -> formula { return p; },
-      [](auto op, auto ...args) -> formula {
-        return remove_booleans(op, args...);
-      }
-    );
+    return fold<formula>(f, [](formula g, auto const& result) {
+      return g.match( // LCOV_EXCL_LINE
+        [](boolean b)     -> formula { return b; },
+        [](proposition p) -> formula { return p; },
+        [&](nary n, auto operands) -> formula {
+          std::vector<formula> ops;
+          for(formula op : operands)
+            ops.push_back(result(op));
+          return n.match([&](auto c) { return remove_booleans(c, ops); });
+        },
+        [&](auto op, std::convertible_to<formula> auto ...args) -> formula {
+          return remove_booleans(op, result(args)...);
+        },
+        [](otherwise) -> formula { black_unreachable(); } // LCOV_EXCL_LINE
+      ).match(
+        [](boolean b)     -> formula { return b; },
+        [](proposition p) -> formula { return p; },
+        [](nary n)        -> formula { return n; },
+        [](auto op, auto ...args) -> formula {
+          return remove_booleans(op, args...);
+        }
+      );
+    });
   }
 
   static void tseitin(
     formula f, 
     std::vector<clause> &clauses, 
-    tsl::hopscotch_set<formula> &memo
+    tsl::hopscotch_set<compact<formula>> &memo
   );
 
   // TODO: disambiguate fresh propositions
@@ -150,27 +186,61 @@ namespace black_internal::cnf
     return f.sigma()->proposition(f);
   }
 
+  std::vector<formula> conjuncts(formula f) {
+    std::vector<formula> result;
+    tsl::hopscotch_set<formula> seen;
+
+    // an explicit stack, since conjunctions can be very deep
+    std::vector<formula> stack = {f};
+    while(!stack.empty()) {
+      formula g = stack.back();
+      stack.pop_back();
+
+      g.match(
+        [&](conjunction, formula left, formula right) {
+          stack.push_back(right);
+          stack.push_back(left);
+        },
+        [&](big_conjunction, auto ops) {
+          size_t top = stack.size();
+          for(formula op : ops)
+            stack.push_back(op);
+          std::reverse(stack.begin() + long(top), stack.end());
+        },
+        [&](otherwise) {
+          if(seen.insert(g).second)
+            result.push_back(g);
+        }
+      );
+    }
+
+    return result;
+  }
+
   cnf to_cnf(formula f) {
+    return to_cnf(std::span<formula const>{&f, 1});
+  }
+
+  cnf to_cnf(std::span<formula const> fs) {
     std::vector<clause> result;
-    tsl::hopscotch_set<formula> memo;
+    tsl::hopscotch_set<compact<formula>> memo;
     
-    formula simple = remove_booleans(f);
-    black_assert( // LCOV_EXCL_LINE 
-      simple.is<boolean>() || 
-      !has_any_element_of(simple, syntax_element::boolean)
-    ); // LCOV_EXCL_LINE
-
-    tseitin(simple, result, memo);
-    if(auto b = simple.to<boolean>(); b) {
-      if(b->value())
-        return result;
-      else {
-        result.push_back({});
-        return result;
+    for(formula f : fs) {
+      formula simple = remove_booleans(f);
+      black_assert( // LCOV_EXCL_LINE 
+        simple.is<boolean>() || 
+        !has_any_element_of(simple, syntax_element::boolean)
+      ); // LCOV_EXCL_LINE
+
+      if(auto b = simple.to<boolean>(); b) {
+        if(!b->value())
+          result.push_back({});
+        continue;
       }
-    }
 
-    result.push_back({{true, fresh(simple)}});
+      tseitin(simple, result, memo);
+      result.push_back({{true, fresh(simple)}});
+    }
 
     return {result};
   }
@@ -178,7 +248,7 @@ namespace black_internal::cnf
   static void tseitin(
     formula f, 
     std::vector<clause> &clauses, 
-    tsl::hopscotch_set<formula> &memo
+    tsl::hopscotch_set<compact<formula>> &memo
   ) {
     if(memo.find(f) != memo.end())
       return;
@@ -200,6 +270,32 @@ namespace black_internal::cnf
           {{false, fresh(l)}, {false, fresh(r)}, {true, fresh(f)}}
         });
       },
+      [&](big_conjunction, auto ops) 
+      {
+        // clausal form for n-ary conjunctions:
+        //   f <-> (l1 ∧ ... ∧ ln) == 
+        //     (!f ∨ l1) ∧ ... ∧ (!f ∨ ln) ∧ (!l1 ∨ ... ∨ !ln ∨ f)
+        clause last = {{true, fresh(f)}};
+        for(formula op : ops) {
+          tseitin(op, clauses, memo);
+          clauses.push_back({{false, fresh(f)}, {true, fresh(op)}});
+          last.literals.push_back({false, fresh(op)});
+        }
+        clauses.push_back(last);
+      },
+      [&](big_disjunction, auto ops) 
+      {
+        // clausal form for n-ary disjunctions:
+        //   f <-> (l1 ∨ ... ∨ ln) == 
+        //     (f ∨ !l1) ∧ ... ∧ (f ∨ !ln) ∧ (l1 ∨ ... ∨ ln ∨ !f)
+        clause last = {{false, fresh(f)}};
+        for(formula op : ops) {
+          tseitin(op, clauses, memo);
+          clauses.push_back({{true, fresh(f)}, {false, fresh(op)}});
+          last.literals.push_back({true, fresh(op)});
+        }
+        clauses.push_back(last);
+      },
       [&](disjunction, auto l, auto r) 
       {
         tseitin(l, clauses, memo);
@@ -281,6 +377,30 @@ namespace black_internal::cnf
               {{false, fresh(f)}, {false, fresh(r)}},
             });
           },
+          [&](big_conjunction, auto ops) {
+            // clausal form for negated n-ary conjunction:
+            //   f <-> !(l1 ∧ ... ∧ ln) == 
+            //     (!f ∨ !l1 ∨ ... ∨ !ln) ∧ (f ∨ l1) ∧ ... ∧ (f ∨ ln)
+            clause first = {{false, fresh(f)}};
+            for(formula op : ops) {
+              tseitin(op, clauses, memo);
+              first.literals.push_back({false, fresh(op)});
+              clauses.push_back({{true, fresh(f)}, {true, fresh(op)}});
+            }
+            clauses.push_back(first);
+          },
+          [&](big_disjunction, auto ops) {
+            // clausal form for negated n-ary disjunction:
+            //   f <-> !(l1 ∨ ... ∨ ln) == 
+            //     (f ∨ l1 ∨ ... ∨ ln) ∧ (!f ∨ !l1) ∧ ... ∧ (!f ∨ !ln)
+            clause first = {{true, fresh(f)}};
+            for(formula op : ops) {
+              tseitin(op, clauses, memo);
+              first.literals.push_back({true, fresh(op)});
+              clauses.push_back({{false, fresh(f)}, {false, fresh(op)}});
+            }
+            clauses.push_back(first);
+          },
           [&](implication, auto l, auto r) 
           {
             tseitin(l, clauses, memo);
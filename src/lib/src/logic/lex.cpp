@@ -29,6 +29,7 @@
 #include <istream>
 #include <charconv>
 #include <limits>
+#include <iterator>
 
 namespace black_internal::lexer_details
 {
@@ -179,6 +180,8 @@ namespace black_internal::lexer_details
       case token::punctuation::comma:       return ",";
       case token::punctuation::dot:         return ".";
       case token::punctuation::colon:       return ":";
+      case token::punctuation::let:         return "let";
+      case token::punctuation::in:          return "in";
     }
     black_unreachable(); // LCOV_EXCL_LINE
   }
@@ -192,7 +195,7 @@ namespace black_internal::lexer_details
       [](bool b)                  { return b ? "True"s : "False"s; },
       [](int64_t c)               { return std::to_string(c); },
       [](double d)                { return std::to_string(d); },
-      [](std::string s)           { return s; },
+      [](std::string_view s)      { return std::string{s}; },
       [](quantifier::type k)      { return to_string(k); },
       [](token::equality_t t)     { return to_string(t); },
       [](comparison::type t)      { return to_string(t); },
@@ -207,159 +210,154 @@ namespace black_internal::lexer_details
     return stok;
   }
 
-  namespace {
+  lexer::lexer(std::istream &stream, error_handler error)
+    : _buffer{
+        std::istreambuf_iterator<char>{stream}, 
+        std::istreambuf_iterator<char>{}
+      },
+      _begin{_buffer.data()}, _end{_buffer.data() + _buffer.size()},
+      _error{std::move(error)} { }
 
-    std::optional<token> digits(std::istream &s, lexer::error_handler error)
-    {
-      std::string integer;
+  lexer::lexer(std::string_view buffer, error_handler error)
+    : _begin{buffer.data()}, _end{buffer.data() + buffer.size()},
+      _error{std::move(error)} { }
 
-      // integer part
-      while(isdigit(s.peek())) {
-        integer += char(s.peek());
-        s.get();
-      }
-      if(integer.empty())
-        return {};
-
-      if(s.peek() != '.') {
-        int64_t val = 0;
-        auto [ptr, err] = 
-          std::from_chars(integer.data(), integer.data() + integer.size(), val);
+  std::optional<token> lexer::_digits()
+  {
+    char const *start = _begin;
+    while(isdigit(_peek()))
+      ++_begin;
+    if(_begin == start)
+      return {};
 
-        if(err == std::errc())
-          return token{val};
+    if(_peek() != '.') {
+      int64_t val = 0;
+      auto [ptr, err] = std::from_chars(start, _begin, val);
 
-        error(
-          "Integer constant '" + integer + "' is too big. " +
-          "Admitted range: [" + 
-          std::to_string(std::numeric_limits<int64_t>::min()) + ", " +
-          std::to_string(std::numeric_limits<int64_t>::max()) + "]"
-        );
-        return token{};
-      }
+      if(err == std::errc())
+        return token{val};
 
-      // fractional part
-      std::string fractional;
-      
-      s.get(); // consume the dot
-      while(s.good() && isdigit(s.peek())) {
-        fractional += char(s.peek());
-        s.get();
-      }
-      if(fractional.empty()) {
-        error("Incomplete fractional constant: '" + integer + ".'");
-        return token{};
-      }
-      
-      std::string number = integer + '.' + fractional;
-      try {
-        return token{stod(number)};
-      } catch (std::out_of_range const&) {
-        error(
-          "Fractional constant '" + number + "' cannot be represented as a "
-          "64-bit floating-point value"
-        );
-        return token{};
-      }
+      _error(
+        "Integer constant '" + std::string{start, _begin} + "' is too big. " +
+        "Admitted range: [" + 
+        std::to_string(std::numeric_limits<int64_t>::min()) + ", " +
+        std::to_string(std::numeric_limits<int64_t>::max()) + "]"
+      );
+      return token{};
     }
 
-    std::optional<token> symbol(std::istream &s)
-    {
-      char ch = char(s.peek());
-
-      switch (ch) {
-        case '(':
-          s.get();
-          return token{token::punctuation::left_paren};
-        case ')':
-          s.get();
-          return token{token::punctuation::right_paren};
-        case ',':
-          s.get();
-          return token{token::punctuation::comma};
-        case '.':
-          s.get();
-          return token{token::punctuation::dot};
-        case ':':
-          s.get();
-          return token{token::punctuation::colon};
-        case '!':
-          s.get();
-          if(s.peek() == '=') {
-            s.get();
-            return token{{equality::type::distinct, true}};
-          }
-          return token{unary::type::negation};
-        case '~':
-          s.get();
-          return token{unary::type::negation};
-        // '&' or '&&'
-        case '&':
-          s.get();
-          if (s.peek() == '&')
-            s.get();
-          return token{binary::type::conjunction};
-
-        // '|' or '||'
-        case '|':
-          s.get();
-          if (s.peek() == '|')
-            s.get();
-          return token{binary::type::disjunction};
-
-        // '->' and '=>'
-        case '-':
-          s.get();
-          if (s.peek() == '>') {
-            s.get();
-            return token{binary::type::implication};
-          }
-          return token{binary_term::type::subtraction};
-        case '=':
-          s.get();
-          if (s.peek() == '>') {
-            s.get();
-            return token{binary::type::implication};
-          }
-          return token{{equality::type::equal, true}};
-        
-        case '>':
-          s.get();
-          if(s.peek() == '=') {
-            s.get();
-            return token{comparison::type::greater_than_equal};
-          }
-          return token{comparison::type::greater_than};
-
-        // '<->' or '<=>' or '<>'
-        case '<':
-          s.get();
-          if (s.peek() == '-' || s.peek() == '=')
-            s.get();
-          else
-            return token{comparison::type::less_than};
-
-          if (s.peek() == '>') {
-            s.get();
-            return token{binary::type::iff};
-          }
-          return token{comparison::type::less_than_equal};
-
-        case '+':
-          s.get();
-          return token{binary_term::type::addition};
-        case '*':
-          s.get();
-          return token{binary_term::type::multiplication};
-        case '/':
-          s.get();
-          return token{binary_term::type::division};
-      }
+    // fractional part
+    ++_begin; // consume the dot
+    char const *fractional = _begin;
+    while(isdigit(_peek()))
+      ++_begin;
+    if(_begin == fractional) {
+      _error(
+        "Incomplete fractional constant: '" + 
+        std::string{start, _begin} + "'"
+      );
+      return token{};
+    }
+    
+    double val = 0;
+    auto [ptr, err] = std::from_chars(start, _begin, val);
+    if(err == std::errc())
+      return token{val};
+
+    _error(
+      "Fractional constant '" + std::string{start, _begin} + "' cannot be "
+      "represented as a 64-bit floating-point value"
+    );
+    return token{};
+  }
 
-      // TODO: garantire che se restituiamo nullopt, lo stream non è avanzato
-      return std::nullopt;
+  std::optional<token> lexer::_symbol()
+  {
+    // consumes the next character if it is `c`
+    auto next = [&](char c) {
+      if(_peek() != c)
+        return false;
+      ++_begin;
+      return true;
+    };
+
+    switch (_peek()) {
+      case '(':
+        ++_begin;
+        return token{token::punctuation::left_paren};
+      case ')':
+        ++_begin;
+        return token{token::punctuation::right_paren};
+      case ',':
+        ++_begin;
+        return token{token::punctuation::comma};
+      case '.':
+        ++_begin;
+        return token{token::punctuation::dot};
+      case ':':
+        ++_begin;
+        return token{token::punctuation::colon};
+      case '!':
+        ++_begin;
+        if(next('='))
+          return token{{equality::type::distinct, true}};
+        return token{unary::type::negation};
+      case '~':
+        ++_begin;
+        return token{unary::type::negation};
+      // '&' or '&&'
+      case '&':
+        ++_begin;
+        next('&');
+        return token{binary::type::conjunction};
+
+      // '|' or '||'
+      case '|':
+        ++_begin;
+        next('|');
+        return token{binary::type::disjunction};
+
+      // '->' and '=>'
+      case '-':
+        ++_begin;
+        if(next('>'))
+          return token{binary::type::implication};
+        return token{binary_term::type::subtraction};
+      case '=':
+        ++_begin;
+        if(next('>'))
+          return token{binary::type::implication};
+        return token{{equality::type::equal, true}};
+      
+      case '>':
+        ++_begin;
+        if(next('='))
+          return token{comparison::type::greater_than_equal};
+        return token{comparison::type::greater_than};
+
+      // '<->' or '<=>' or '<>'
+      case '<':
+        ++_begin;
+        if(!next('-') && !next('='))
+          return token{comparison::type::less_than};
+
+        if(next('>'))
+          return token{binary::type::iff};
+        return token{comparison::type::less_than_equal};
+
+      case '+':
+        ++_begin;
+        return token{binary_term::type::addition};
+      case '*':
+        ++_begin;
+        return token{binary_term::type::multiplication};
+      case '/':
+        ++_begin;
+        return token{binary_term::type::division};
     }
-  }  // namespace
+
+    return std::nullopt;
+  }
 
   bool lexer::is_identifier_char(int c) {
     return isalnum(c) || c == '_';
@@ -369,7 +367,7 @@ namespace black_internal::lexer_details
     return isalpha(c) || c == '_' || c == '{';
   }
 
-  std::pair<std::string_view, token> lexer::_keywords[35] = {
+  std::pair<std::string_view, token> lexer::_keywords[37] = {
     {"True",     token{true}},
     {"False",    token{false}},
     {"Int",      token{arithmetic_sort::type::integer_sort}},
@@ -404,7 +402,9 @@ namespace black_internal::lexer_details
     {"W",        token{binary::type::w_until}},
     {"M",        token{binary::type::s_release}},
     {"S",        token{binary::type::since}},
-    {"T",        token{binary::type::triggered}}
+    {"T",        token{binary::type::triggered}},
+    {"let",      token{token::punctuation::let}},
+    {"in",       token{token::punctuation::in}}
   };
 
   bool lexer::is_keyword(std::string_view s) {
@@ -416,23 +416,21 @@ namespace black_internal::lexer_details
 
   std::optional<token> lexer::_identifier()
   {
-    if (!_stream.good() || !is_initial_identifier_char(_stream.peek())) {
+    if (!is_initial_identifier_char(_peek())) {
       _error(
-        std::string{"Unrecognized input character: '"} + 
-        (char)_stream.peek() + "'"
+        std::string{"Unrecognized input character: '"} + *_begin + "'"
       );
       return token{};
     }
 
-    if((char)_stream.peek() == '{')
+    if(_peek() == '{')
       return _raw_identifier();
 
-    std::string id;
-    while (_stream.good() && is_identifier_char(_stream.peek())) 
-    {
-      id += char(_stream.peek());
-      _stream.get();
-    }
+    char const *start = _begin;
+    while (is_identifier_char(_peek()))
+      ++_begin;
+    
+    std::string_view id{start, size_t(_begin - start)};
     black_assert(!id.empty());
 
     auto it = 
@@ -443,59 +441,70 @@ namespace black_internal::lexer_details
     if(it != std::end(_keywords))
       return {it->second};
 
-    return token{std::move(id)};
+    return token{id};
   }
 
+  //
+  // Raw identifiers without escape sequences are returned as views on the
+  // buffer as well. Otherwise, the unescaped string is kept in `_unescaped`.
+  //
   std::optional<token> lexer::_raw_identifier()
   {
     using namespace std::literals;
 
-    black_assert(_stream.peek() == '{');
+    black_assert(_peek() == '{');
+    ++_begin;
 
-    _stream.get();
-    std::string id;
-    
-    while(_stream.peek() != '}') {
-      char c = (char)_stream.peek();
-      
-      if(c == '\\') {
-        _stream.get();
-        char c2 = (char)_stream.peek(); 
-        if(c2 == '}') {
-          c = '}';
-        } else if(c2 == '\\') {
-          c = '\\';
-        } else {
-          _error(
-            "Unknown escape sequence '\\"s + c2 + "' in raw identifier"
-          );
-          return {};
-        }
-      }      
-      
-      _stream.get();
-      id += c;
+    char const *start = _begin;
+    std::optional<std::string> unescaped;
+    while(_peek() != '}') {
+      if(_begin == _end) {
+        _error("Unterminated raw identifier");
+        return {};
+      }
+
+      if(*_begin != '\\') {
+        if(unescaped)
+          *unescaped += *_begin;
+        ++_begin;
+        continue;
+      }
+
+      if(!unescaped)
+        unescaped = std::string{start, _begin};
+
+      ++_begin;
+      char c = static_cast<char>(_peek());
+      if(c != '}' && c != '\\') {
+        _error(
+          "Unknown escape sequence '\\"s + c + "' in raw identifier"
+        );
+        return {};
+      }
+      *unescaped += c;
+      ++_begin;
     }
-    _stream.get();
+    std::string_view id{start, size_t(_begin - start)};
+    ++_begin;
 
-    return token{std::move(id)};
+    if(!unescaped)
+      return token{id};
+
+    return token{std::string_view{_unescaped.emplace_back(*unescaped)}};
   }
 
   std::optional<token> lexer::_lex()
   {
-    char c = (char)_stream.peek();
-    while (_stream.good() && isspace(c)) {
-      _stream.get();
-      c = (char)_stream.peek();
-    }
+    while (isspace(_peek()))
+      ++_begin;
 
-    if (!_stream.good())
+    if (_begin == _end)
       return std::nullopt;
 
-    if(std::optional<token> t = digits(_stream, _error); t)
+    if(std::optional<token> t = _digits(); t)
       return t;
 
-    if(std::optional<token> t = symbol(_stream); t)
+    if(std::optional<token> t = _symbol(); t)
       return t;
 
     return _identifier();
@@ -23,8 +23,17 @@
 
 #include <black/logic/logic.hpp>
 
-#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <variant>
 #include <vector>
 
@@ -33,7 +42,7 @@
 // `logic.hpp` and subfiles. In particular, here we declare some components of
 // the `alphabet` class. BLACK's logic API is for the most part a header library
 // being 99% templates, but this part is implemented in a source file mainly in
-// order to keep `tsl::hopscotch_map` as a private dependency. To understand
+// order to keep `tsl::hopscotch_set` as a private dependency. To understand
 // what follows, be sure to read the explanations in `core.hpp` and
 // `generation.hpp`.
 //
@@ -56,26 +65,341 @@ namespace black_internal::logic {
   } namespace black_internal::logic {
 
   //
-  // The `alphabet` class keeps an hash table from nodes to pointer to nodes.
-  // When we insert a node, if it already exists, we get the existing copy of it
-  // from the hash table. If it does not, we insert it in the hash table. This
-  // mechanism is implemented in the following class, which will be indirectly
-  // inherited by the pimpl class `alphabet_impl`.
+  // The `alphabet` class keeps an hash table of pointers to nodes. When we
+  // insert a node, if it already exists, we get the existing copy of it from
+  // the hash table. If it does not, we move it into the arena and insert its
+  // address in the hash table. Each node is thus stored only once: the table
+  // hashes and compares the pointed-to nodes, and supports heterogeneous
+  // lookups directly from the node that is being inserted. The arena is a
+  // `std::deque`, which never moves its elements when growing at the end, so
+  // the pointers stay valid for the lifetime of the alphabet. This mechanism
+  // is implemented in the following class, which will be indirectly inherited
+  // by the pimpl class `alphabet_impl`.
+  //
+  template<storage_type Storage>
+  struct storage_node_ptr_hash {
+    using is_transparent = void;
+
+    size_t operator()(storage_node<Storage> const& node) const {
+      return std::hash<storage_node<Storage>>{}(node);
+    }
+    
+    size_t operator()(storage_node<Storage> const *node) const {
+      return (*this)(*node);
+    }
+  };
+
+  template<storage_type Storage>
+  struct storage_node_ptr_equal {
+    using is_transparent = void;
+
+    static storage_node<Storage> const& 
+    deref(storage_node<Storage> const& node) { return node; }
+    
+    static storage_node<Storage> const& 
+    deref(storage_node<Storage> const *node) { return *node; }
+
+    template<typename T, typename U>
+    bool operator()(T const& t, U const& u) const {
+      return deref(t) == deref(u);
+    }
+  };
+
+  //
+  // Nodes are stored in slots that can be freed and reused individually when
+  // regions are released (see `alphabet::release()`). Hence, the arena does
+  // not construct nor destroy the nodes by itself, which is done explicitly
+  // by the shard: live nodes are exactly those in the hash table, and freed
+  // slots are kept in a free list.
+  //
+  template<storage_type Storage>
+  union storage_slot {
+    storage_slot() { }
+    ~storage_slot() { }
+
+    storage_node<Storage> node;
+  };
+
+  //
+  // The table mapping the `index` of each node to the node itself, used to
+  // resolve compact handles (see `compact` in `generation.hpp`). Indexes are
+  // given to nodes when they are created, starting from 1, and are not reused
+  // when nodes are freed. The table is split in chunks of growing size, the
+  // k-th one holding 2^(k + 10) entries, so that chunks never move and lookups
+  // can proceed without locking while new chunks are added by other threads.
+  // The entry of a node is written before the node is published to any other
+  // thread, so only the chunk pointers need to be atomic.
+  //
+  class node_table {
+  public:
+    node_table() = default;
+    node_table(node_table const&) = delete;
+    node_table &operator=(node_table const&) = delete;
+
+    ~node_table() {
+      for(auto &chunk : _chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    void add(hierarchy_node *node) {
+      uint32_t index = _next.fetch_add(1, std::memory_order_relaxed);
+      black_assert(index != 0); // wrap-around
+      
+      node->index = index;
+      slot(index) = node;
+    }
+
+    void remove(hierarchy_node const *node) {
+      slot(node->index) = nullptr;
+    }
+
+    // the index that will be given to the next node
+    uint32_t next() const {
+      return _next.load(std::memory_order_relaxed);
+    }
+
+    hierarchy_node const *get(uint32_t index) const {
+      black_assert(index > 0 && index < _next.load(std::memory_order_relaxed));
+      auto [k, offset] = locate(index);
+      return _chunks[k].load(std::memory_order_acquire)[offset];
+    }
+
+  private:
+    static constexpr size_t first_bits = 10;
+    static constexpr size_t n_chunks = 33 - first_bits;
+
+    static std::pair<size_t, size_t> locate(uint32_t index) {
+      uint64_t i = uint64_t{index} + (uint64_t{1} << first_bits);
+      size_t k = size_t(std::bit_width(i)) - first_bits - 1;
+      return {k, size_t(i - (uint64_t{1} << (k + first_bits)))};
+    }
+
+    hierarchy_node const *&slot(uint32_t index) {
+      auto [k, offset] = locate(index);
+
+      hierarchy_node const **chunk = _chunks[k].load(std::memory_order_acquire);
+      if(!chunk) {
+        std::lock_guard lock{_grow};
+        chunk = _chunks[k].load(std::memory_order_acquire);
+        if(!chunk) {
+          chunk = new hierarchy_node const *[size_t{1} << (k + first_bits)]();
+          _chunks[k].store(chunk, std::memory_order_release);
+        }
+      }
+
+      return chunk[offset];
+    }
+
+    std::array<std::atomic<hierarchy_node const **>, n_chunks> _chunks{};
+    std::atomic<uint32_t> _next = 1;
+    std::mutex _grow;
+  };
+
+  //
+  // Nodes reachable from the roots given to `alphabet::release()`. 
+  //
+  using marked_nodes = tsl::hopscotch_set<hierarchy_node const*>;
+
+  //
+  // Completes the summary of a new node (see `hierarchy_node` in `core.hpp`)
+  // from those of its children, which are exactly the fields of type
+  // `hierarchy_node const*` and `std::vector<hierarchy_node const*>`.
+  //
+  struct node_summary {
+    uint64_t elements;
+    uint64_t size = 1;
+    uint32_t depth = 0;
+
+    void add(hierarchy_node const *child) {
+      elements |= child->elements;
+      size += child->size;
+      depth = std::max(depth, child->depth);
+    }
+
+    void add(std::vector<hierarchy_node const*> const& children) {
+      for(auto child : children)
+        add(child);
+    }
+
+    template<typename T>
+    void add(T const&) { }
+  };
+
+  template<storage_type Storage>
+  void summarize(storage_node<Storage> &node) {
+    node_summary summary{node.elements};
+    std::apply([&](auto const& ...values) {
+      (summary.add(values), ...);
+    }, node.data.values);
+    
+    node.elements = summary.elements;
+    node.size = uint32_t(
+      std::min<uint64_t>(summary.size, std::numeric_limits<uint32_t>::max())
+    );
+    node.depth = summary.depth + 1;
+  }
+
+  template<storage_type Storage>
+  struct storage_shard {
+    std::deque<storage_slot<Storage>> _store;
+    std::vector<storage_slot<Storage> *> _free;
+    tsl::hopscotch_set<
+      storage_node<Storage> *, 
+      storage_node_ptr_hash<Storage>, storage_node_ptr_equal<Storage>
+    > _set;
+
+    storage_shard() = default;
+    storage_shard(storage_shard const&) = delete;
+    storage_shard &operator=(storage_shard const&) = delete;
+
+    ~storage_shard() {
+      for(storage_node<Storage> *obj : _set)
+        std::destroy_at(obj);
+    }
+
+    storage_node<Storage> *find(storage_node<Storage> const& node) const {
+      auto it = _set.find(node);
+      if(it != _set.end())
+        return *it;
+      return nullptr;
+    }
+
+    storage_node<Storage> *
+    insert(storage_node<Storage> node, node_table &table) {
+      summarize(node);
+
+      storage_slot<Storage> *slot;
+      if(!_free.empty()) {
+        slot = _free.back();
+        _free.pop_back();
+      } else
+        slot = &_store.emplace_back();
+
+      storage_node<Storage> *obj = 
+        std::construct_at(&slot->node, std::move(node));
+      table.add(obj);
+      _set.insert(obj);
+
+      return obj;
+    }
+
+    //
+    // The nodes of a region are those with an index not lower than `first`,
+    // the first index given after the region was opened.
+    //
+    void 
+    sweep(uint32_t first, marked_nodes const& marked, node_table &table) {
+      std::vector<storage_node<Storage> *> dead;
+      for(storage_node<Storage> *obj : _set)
+        if(obj->index >= first && marked.find(obj) == marked.end())
+          dead.push_back(obj);
+      
+      for(storage_node<Storage> *obj : dead) {
+        _set.erase(obj);
+        table.remove(obj);
+        std::destroy_at(obj);
+        _free.push_back(reinterpret_cast<storage_slot<Storage> *>(obj));
+      }
+    }
+
+    void account(storage_usage &usage) const {
+      usage.nodes += _set.size();
+      usage.bytes += _store.size() * sizeof(storage_slot<Storage>) +
+        _free.capacity() * sizeof(void *) +
+        _set.bucket_count() * sizeof(void *);
+      
+      for(storage_node<Storage> const *obj : _set)
+        std::apply([&](auto const& ...values) {
+          ((usage.bytes += heap_bytes(values)), ...);
+        }, obj->data.values);
+    }
+
+    template<typename T>
+    static size_t heap_bytes(T const&) { return 0; }
+
+    template<typename T>
+    static size_t heap_bytes(std::vector<T> const& v) { 
+      return v.capacity() * sizeof(T);
+    }
+  };
+
+  //
+  // By default, the alphabet is not thread-safe and all the nodes of a given
+  // storage kind go in a single unsynchronized shard. After a call to
+  // `alphabet::make_concurrent()`, nodes are instead distributed over a fixed
+  // number of shards selected by the node's hash, each one protected by its
+  // own reader/writer lock. Looking up an existing node only takes the shared
+  // lock of its shard, so threads building overlapping formulas do not
+  // serialize, and insertions only contend with other accesses to the same
+  // shard. Nodes already created when switching mode are redistributed to
+  // the shards (only their pointers move, so existing handles stay valid).
   //
   template<storage_type Storage>
   struct storage_allocator {
-    std::deque<storage_node<Storage>> _store;
-    tsl::hopscotch_map<storage_node<Storage>, storage_node<Storage> *> _map;
+    static constexpr size_t n_shards = 64;
+
+    struct locked_shard : storage_shard<Storage> {
+      std::shared_mutex mutex;
+    };
+
+    // `_main` is declared first because the shards may own nodes that live in
+    // its arena, so it must be destroyed last.
+    storage_shard<Storage> _main;
+    std::unique_ptr<std::array<locked_shard, n_shards>> _shards;
+
+    static size_t shard_of(storage_node<Storage> const& node) {
+      // the low bits of the hash are those used by the shards' hash tables
+      return (storage_node_ptr_hash<Storage>{}(node) >> 16) % n_shards;
+    }
    
-    storage_node<Storage> *allocate(storage_node<Storage> const& node) {
-      auto it = _map.find(node);
-      if(it != _map.end())
-        return it->second;
-     
-      storage_node<Storage> *obj = &_store.emplace_back(node);
-      _map.insert({node, obj});
+    storage_node<Storage> *
+    allocate(storage_node<Storage> node, node_table &table) {
+      if(!_shards) {
+        if(auto obj = _main.find(node); obj)
+          return obj;
+        return _main.insert(std::move(node), table);
+      }
 
-      return obj;
+      locked_shard &shard = (*_shards)[shard_of(node)];
+      {
+        std::shared_lock lock{shard.mutex};
+        if(auto obj = shard.find(node); obj)
+          return obj;
+      }
+
+      std::unique_lock lock{shard.mutex};
+      if(auto obj = shard.find(node); obj) // someone may have been faster
+        return obj;
+      return shard.insert(std::move(node), table);
+    }
+
+    void init(node_table &) { }
+
+    void make_concurrent() {
+      if(_shards)
+        return;
+      
+      _shards = std::make_unique<std::array<locked_shard, n_shards>>();
+      for(storage_node<Storage> *obj : _main._set)
+        (*_shards)[shard_of(*obj)]._set.insert(obj);
+      _main._set.clear();
+    }
+
+    void 
+    sweep(uint32_t first, marked_nodes const& marked, node_table &table) {
+      _main.sweep(first, marked, table);
+      if(_shards)
+        for(auto &shard : *_shards)
+          shard.sweep(first, marked, table);
+    }
+
+    storage_usage usage() const {
+      storage_usage result{Storage};
+      _main.account(result);
+      if(_shards)
+        for(auto const& shard : *_shards)
+          shard.account(result);
+      return result;
     }
   };
 
@@ -93,13 +417,50 @@ namespace black_internal::logic {
     storage_node<Storage> _true{element_of_storage_v<Storage>, true};
     storage_node<Storage> _false{element_of_storage_v<Storage>, false};
     
-    storage_node<Storage> *allocate(storage_node<Storage> node) {
+    storage_node<Storage> *allocate(storage_node<Storage> node, node_table &) {
       if(std::get<0>(node.data.values))
         return &_true;
       return &_false;
     }
+
+    void init(node_table &table) {
+      table.add(&_true);
+      table.add(&_false);
+    }
+
+    void make_concurrent() { }
+
+    void sweep(uint32_t, marked_nodes const&, node_table &) { }
+
+    storage_usage usage() const {
+      return storage_usage{Storage, 2, 0};
+    }
   };
 
+  //
+  // Helpers to find the nodes referenced by the fields of a node, used to
+  // mark the reachable nodes when a region is released.
+  //
+  inline void trace_field(hierarchy_node const *node, node_list &out) {
+    out.push_back(node);
+  }
+
+  inline void trace_field(identifier const& id, node_list &out) {
+    id.nodes(out);
+  }
+
+  template<typename T>
+  void trace_field(T const& value, node_list &out) {
+    trace_nodes(value, out);
+  }
+
+  template<storage_type Storage>
+  void trace_storage(storage_node<Storage> const *node, node_list &out) {
+    std::apply([&](auto const& ...values) {
+      (trace_field(values, out), ...);
+    }, node->data.values);
+  }
+
   struct alphabet_base::alphabet_impl : std::monostate
   #define declare_storage_kind(Base, Storage) \
     , storage_allocator<storage_type::Storage>
@@ -108,6 +469,86 @@ namespace black_internal::logic {
     #define declare_storage_kind(Base, Storage) \
       using storage_allocator<storage_type::Storage>::allocate;
     #include <black/internal/logic/hierarchy.hpp>
+
+    alphabet_impl() {
+      #define declare_storage_kind(Base, Storage) \
+        storage_allocator<storage_type::Storage>::init(table);
+      #include <black/internal/logic/hierarchy.hpp>
+    }
+
+    void make_concurrent() {
+      #define declare_storage_kind(Base, Storage) \
+        storage_allocator<storage_type::Storage>::make_concurrent();
+      #include <black/internal/logic/hierarchy.hpp>
+      concurrent = true;
+    }
+
+    void trace(hierarchy_node const *node, node_list &out) {
+      switch(storage_of_element(node->type)) {
+        #define declare_storage_kind(Base, Storage) \
+          case storage_type::Storage: \
+            trace_storage( \
+              static_cast<storage_node<storage_type::Storage> const *>(node), \
+              out \
+            ); \
+            break;
+        #include <black/internal/logic/hierarchy.hpp>
+      }
+    }
+
+    //
+    // Indexes are given in order of creation and never reused, so a region
+    // is identified by the first index given after it was opened, and the
+    // survivors of a released region belong to the enclosing one with no
+    // bookkeeping. `regions` holds the first index of each open region.
+    //
+    uint32_t open_region() {
+      regions.push_back(table.next());
+      return static_cast<uint32_t>(regions.size());
+    }
+
+    //
+    // Mark and sweep. Nodes can only reference nodes created before them, so
+    // nodes older than the region are never freed and do not need to be
+    // traversed, and the visit stops as soon as it reaches them. A null
+    // pointer comes from a label that cannot be traced (see `trace_nodes()`
+    // in `identifier.hpp`), which might reference any node, so in this case
+    // nothing is freed.
+    //
+    void release(uint32_t r, node_list roots) {
+      uint32_t first = regions[r - 1];
+      regions.resize(r - 1);
+
+      marked_nodes marked;
+      while(!roots.empty()) {
+        hierarchy_node const *node = roots.back();
+        roots.pop_back();
+        
+        if(!node)
+          return;
+        if(node->index < first || !marked.insert(node).second)
+          continue;
+        trace(node, roots);
+      }
+
+      #define declare_storage_kind(Base, Storage) \
+        storage_allocator<storage_type::Storage>::sweep(first, marked, table);
+      #include <black/internal/logic/hierarchy.hpp>
+    }
+
+    std::vector<storage_usage> usage() const {
+      std::vector<storage_usage> result;
+      #define declare_storage_kind(Base, Storage) \
+        result.push_back( \
+          storage_allocator<storage_type::Storage>::usage() \
+        );
+      #include <black/internal/logic/hierarchy.hpp>
+      return result;
+    }
+
+    node_table table;
+    bool concurrent = false;
+    std::vector<uint32_t> regions;
   };
 
   //
@@ -126,6 +567,34 @@ namespace black_internal::logic {
     return _impl.get();
   }
 
+  void alphabet_base::make_concurrent() {
+    impl()->make_concurrent();
+  }
+
+  bool alphabet_base::is_concurrent() const {
+    return _impl && _impl->concurrent;
+  }
+
+  alphabet_base::region alphabet_base::open_region() {
+    return impl()->open_region();
+  }
+
+  void alphabet_base::release_nodes(region r, node_list roots) {
+    black_assert(r > 0 && r <= impl()->regions.size());
+    impl()->release(r, std::move(roots));
+  }
+
+  hierarchy_node const *alphabet_base::node_at(uint32_t index) const {
+    black_assert(_impl);
+    return _impl->table.get(index);
+  }
+
+  std::vector<storage_usage> alphabet_base::memory_usage() const {
+    if(!_impl)
+      return alphabet_impl{}.usage();
+    return _impl->usage();
+  }
+
   //
   // out-of-line definitions of `alphabet_base` member functions, which will be
   // inherited by `alphabet` and used by the constructors of storage and element
@@ -136,7 +605,7 @@ namespace black_internal::logic {
     alphabet_base::unique( \
       storage_node<storage_type::Storage> node \
     ) { \
-      return impl()->allocate(std::move(node)); \
+      return impl()->allocate(std::move(node), impl()->table); \
     }
 
   #include <black/internal/logic/hierarchy.hpp>
@@ -27,7 +27,10 @@
 
 #include <tsl/hopscotch_map.h>
 
+#include <optional>
 #include <string>
+#include <string_view>
+#include <variant>
 #include <vector>
 #include <sstream>
 
@@ -38,10 +41,9 @@ namespace black_internal
   // Easy entry-point for parsing formulas
   std::optional<formula>
   parse_formula(
-    alphabet &sigma, std::string const&s, parser::error_handler error
+    alphabet &sigma, std::string_view s, parser::error_handler error
   ) {
-    std::stringstream stream{s, std::stringstream::in};
-    parser p{sigma, stream, std::move(error)};
+    parser p{sigma, s, std::move(error)};
 
     return p.parse();
   }
@@ -56,52 +58,154 @@ namespace black_internal
     return p.parse();
   }
 
+  //
+  // The parser is a predictive operator-precedence parser that never
+  // backtracks and never recurses: the nesting of the input is kept on an
+  // explicit stack of frames, each waiting for the result of the
+  // subexpression being parsed, so that the parser runs in linear time and
+  // constant native stack even on huge machine-generated formulas. Tokens
+  // are pulled from the lexer one at a time, and a single token of lookahead
+  // is enough to take every decision.
+  //
+  // The only ambiguity of the grammar is between formulas and terms, e.g. an
+  // identifier can be a proposition or a variable, and a parenthesized
+  // expression can be a formula or a term, until we see whether an
+  // arithmetic or relational operator follows. Such primaries are kept as
+  // `item`s and resolved as soon as the next token tells what they are.
+  //
+  // Subformulas and subterms can be given a name with `let name = value in
+  // body`, so that inputs with a lot of sharing can be written (see
+  // `to_string(formula, print_sharing)`) and parsed in time linear in the
+  // size of their DAG. The body extends as far as possible, as for the
+  // matrix of SMT-LIB quantifiers, and the names are looked up in `_lets`.
+  //
   struct parser::_parser_t {
+    // an identifier, possibly applied to some arguments, still to be
+    // resolved as a proposition/relational atom or as a variable/application
+    struct pending {
+      std::string_view id;
+      std::optional<std::vector<term>> args;
+    };
+    using item = std::variant<formula, term, pending>;
+
+    //
+    // Frames of the parsing stack.
+    //
+    // The sequence of binary operators that follows a primary is parsed by
+    // precedence climbing. A frame corresponds to a level of the climbing,
+    // with its left operand `lhs` and the operator `op` waiting for its
+    // right operand, if any.
+    struct formula_ops {
+      int prec;
+      std::optional<item> lhs = {};
+      std::optional<token> op = {};
+    };
+    struct term_ops {
+      int prec;
+      std::optional<term> lhs = {};
+      std::optional<token> op = {};
+    };
+
+    // operators waiting for their (only) operand. Quantified variables hide
+    // the `let` bindings with the same name, which are kept in `hidden`.
+    struct unary_op { unary::type op; };
+    struct quantifier_op { 
+      quantifier::type q; 
+      std::vector<var_decl> vars; 
+      std::vector<std::pair<std::string_view, item>> hidden;
+    };
+    struct negative_op { };
+    struct term_ctor { unary_term::type op; };
+
+    // a term whose left operand has been parsed, waiting for the right one
+    struct relational { term lhs; token op; };
+
+    // the arguments of a relation or function application
+    struct arguments { 
+      std::string_view id; 
+      std::vector<term> terms; 
+      bool primary; // whether the application is a primary formula item
+    };
+
+    // parenthesized subexpressions, and terms in place of primary formulas
+    struct parens { };
+    struct term_parens { };
+    struct primary_term { };
+
+    // the value of a `let`, and its body with the binding it hides, if any
+    struct let_value { std::string_view name; };
+    struct let_body { std::string_view name; std::optional<item> hidden; };
+
+    using frame = std::variant<
+      formula_ops, term_ops, unary_op, quantifier_op, negative_op, term_ctor,
+      relational, arguments, parens, term_parens, primary_term, let_value,
+      let_body
+    >;
+
+    //
+    // The states of the parsing loop. `_item` and `_term` hold the result of
+    // the last parsed subexpression, when the state says so.
+    //
+    enum class step {
+      formula,       // parsing a primary formula
+      item,          // parsed a primary item in `_item`
+      primary,       // parsed a complete primary formula in `_item`
+      formula_rhs,   // climbing the formula operators on top of the stack
+      formula_done,  // parsed a whole formula in `_item`
+      term,          // parsing a primary term
+      term_primary,  // parsed a primary term in `_term`
+      term_rhs,      // climbing the term operators on top of the stack
+      term_done,     // parsed a whole term in `_term`
+      failed
+    };
+
     alphabet &_alphabet;
     lexer _lex;
-    bool _trying = false;
     std::function<void(std::string)> _error;
-    std::vector<token> _tokens;
-    size_t _pos = 0;
+    std::vector<frame> _stack;
+    std::optional<item> _item;
+    std::optional<term> _term;
+    tsl::hopscotch_map<std::string_view, item> _lets;
 
-    _parser_t(alphabet &sigma, std::istream &stream, error_handler error);
-
-    template<typename F>
-    auto try_parse(F f);
+    template<typename Source>
+    _parser_t(alphabet &sigma, Source &&source, error_handler error);
 
     std::optional<token> peek();
-    std::optional<token> get();
     std::optional<token> consume();
     std::optional<token> consume(token::punctuation p);
+    bool peek_is(token::punctuation p);
 
     std::nullopt_t error(std::string const&s);
+    step fail(std::string const&s);
+
+    std::optional<formula> to_formula(item const& i);
+    std::optional<term> to_term(item const& i);
 
     std::optional<formula> parse_formula();
-    std::optional<formula> parse_binary_rhs(int, formula);
-    std::optional<formula> parse_boolean();
-    std::optional<formula> parse_relational_atom();
-    std::optional<formula> parse_atom();
-    std::optional<formula> parse_quantifier();
-    std::optional<formula> parse_unary();
-    std::optional<formula> parse_parens();
-    std::optional<formula> parse_primary();
+    step parse_primary();
+    step parse_quantifier();
+    step parse_let();
+    step parse_item();
+    step parse_operand();
+    step parse_binary_rhs();
+    step parse_formula_done();
 
     std::optional<sort> parse_sort();
 
-    std::optional<term> build_binary_term(binary_term::type, term, term);
-    std::optional<term> parse_term();
-    std::optional<term> parse_term_primary();
-    std::optional<term> parse_term_binary_rhs(int precedence, term lhs);
-    std::optional<term> parse_term_constant();
-    std::optional<term> parse_term_unary_minus();
-    std::optional<term> parse_term_ctor();
-    std::optional<term> parse_term_var_or_func();
-    std::optional<term> parse_term_parens();
+    step parse_term();
+    step parse_term_primary();
+    step parse_term_operand();
+    step parse_term_binary_rhs();
+    step parse_term_done();
   };
 
   parser::parser(alphabet &sigma, std::istream &stream, error_handler error)
     : _data(std::make_unique<_parser_t>(sigma, stream, error)) { }
 
+  parser::parser(
+    alphabet &sigma, std::string_view buffer, error_handler error
+  ) : _data(std::make_unique<_parser_t>(sigma, buffer, error)) { }
+
   parser::~parser() = default;
 
   std::optional<formula> parser::parse() {
@@ -117,53 +221,22 @@ namespace black_internal
     return *f;
   }
 
+  template<typename Source>
   parser::_parser_t::_parser_t(
-    alphabet &sigma, std::istream &stream, error_handler error
-  ) : _alphabet(sigma), _lex(stream, error), _error(error)
+    alphabet &sigma, Source &&source, error_handler error
+  ) : _alphabet(sigma), _lex(source, error), _error(error)
   {
-    std::optional<token> tok = _lex.get();
-    if(tok)    
-      _tokens.push_back(*tok);
-  }
-
-  template<typename F>
-  auto parser::_parser_t::try_parse(F f) {
-    size_t pos = _pos;
-    
-    bool t = _trying;
-    _trying = true;
-    
-    auto r = f();
-    if(!r)
-      _pos = pos;
-    
-    _trying = t;
-    return r;
+    _lex.get();
   }
 
   std::optional<token> parser::_parser_t::peek() {
-    if(_pos < _tokens.size())
-      return _tokens[_pos];
-    return {};
-  }
-
-  std::optional<token> parser::_parser_t::get() {
-    _pos++;
-    if(_pos < _tokens.size())
-      return _tokens[_pos];
-    
-    std::optional<token> tok = _lex.get();
-    if(!tok)
-      return {};
-    
-    _tokens.push_back(*tok);
-    return tok;
+    return _lex.peek();
   }
 
   std::optional<token> parser::_parser_t::consume() {
     auto tok = peek();
     if(tok)
-      get();
+      _lex.get();
 
     return tok;
   }
@@ -186,19 +259,95 @@ namespace black_internal
     return tok;
   }
 
+  bool parser::_parser_t::peek_is(token::punctuation p) {
+    return peek() && peek()->data<token::punctuation>() == p;
+  }
+
   std::nullopt_t parser::_parser_t::error(std::string const&s) {
-    if(!_trying) {
-      _error(s);
-    }
+    _error(s);
     return std::nullopt;
   }
 
-  std::optional<formula> parser::_parser_t::parse_formula() {
-    std::optional<formula> lhs = parse_primary();
-    if(!lhs)
-      return error("Expected formula");
+  parser::_parser_t::step parser::_parser_t::fail(std::string const&s) {
+    error(s);
+    return step::failed;
+  }
+
+  std::optional<formula> parser::_parser_t::to_formula(item const& i) {
+    if(auto f = std::get_if<formula>(&i); f)
+      return *f;
+
+    if(auto p = std::get_if<pending>(&i); p) {
+      if(!p->args)
+        return _alphabet.proposition(p->id);
+      
+      relation r = _alphabet.relation(p->id);
+      return r(*p->args);
+    }
+
+    return error("Expected formula, found term");
+  }
+
+  std::optional<term> parser::_parser_t::to_term(item const& i) {
+    if(auto t = std::get_if<term>(&i); t)
+      return *t;
+
+    if(auto p = std::get_if<pending>(&i); p) {
+      if(!p->args)
+        return _alphabet.variable(p->id);
+
+      function f = _alphabet.function(p->id);
+      return f(*p->args);
+    }
 
-    return parse_binary_rhs(0, *lhs);
+    return error("Expected term, found formula");
+  }
+
+  //
+  // The main loop. Each `parse_*` function below handles one state and
+  // returns the next one.
+  //
+  std::optional<formula> parser::_parser_t::parse_formula() {
+    _stack.clear();
+    _lets.clear();
+    _stack.push_back(formula_ops{0});
+
+    step s = step::formula;
+    while(true) {
+      switch(s) {
+        case step::formula:
+          s = parse_primary();
+          break;
+        case step::item:
+          s = parse_item();
+          break;
+        case step::primary:
+          s = parse_operand();
+          break;
+        case step::formula_rhs:
+          s = parse_binary_rhs();
+          break;
+        case step::formula_done:
+          if(_stack.empty())
+            return to_formula(*_item);
+          s = parse_formula_done();
+          break;
+        case step::term:
+          s = parse_term_primary();
+          break;
+        case step::term_primary:
+          s = parse_term_operand();
+          break;
+        case step::term_rhs:
+          s = parse_term_binary_rhs();
+          break;
+        case step::term_done:
+          s = parse_term_done();
+          break;
+        case step::failed:
+          return {};
+      }
+    }
   }
 
   static std::optional<int> precedence(token const&tok)
@@ -231,248 +380,321 @@ namespace black_internal
     black_unreachable();
   }
 
-  std::optional<formula> 
-  parser::_parser_t::parse_binary_rhs(int prec, formula lhs) {
-    while(1) {
-      if(!peek() || precedence(*peek()) < prec)
-         return {lhs};
-
-      token op = *consume();
-
-      std::optional<formula> rhs = parse_primary();
-      if(!rhs)
-        return error("Expected right operand to binary operator");
+  parser::_parser_t::step parser::_parser_t::parse_primary() {
+    std::optional<token> tok = peek();
+    if(!tok)
+      return fail("Expected formula, found end of input");
 
-      if(!peek() || precedence(op) < precedence(*peek())) {
-        rhs = parse_binary_rhs(prec + 1, *rhs);
-        if(!rhs)
-          return error("Expected right operand to binary operator");
+    switch(tok->token_type()) {
+      case token::type::boolean:
+        consume();
+        _item = _alphabet.boolean(*tok->data<bool>());
+        return step::primary;
+      case token::type::quantifier:
+        return parse_quantifier();
+      case token::type::unary_operator:
+        consume();
+        _stack.push_back(unary_op{*tok->data<unary::type>()});
+        return step::formula;
+      case token::type::identifier: {
+        consume();
+        std::string_view id = *tok->data<std::string_view>();
+        
+        // if there is no open paren this is a proposition or a variable,
+        // unless it is the name of a `let`
+        if(!peek_is(token::punctuation::left_paren)) {
+          if(auto it = _lets.find(id); it != _lets.end())
+            _item = it->second;
+          else
+            _item = pending{id, {}};
+          return step::item;
+        }
+        
+        // otherwise a relational atom or a function application
+        consume();
+        _stack.push_back(arguments{id, {}, true});
+        return parse_term();
       }
-
-      black_assert(op.is<binary::type>());
-      lhs = binary(*op.data<binary::type>(), lhs, *rhs);
+      case token::type::integer:
+      case token::type::real:
+      case token::type::unary_term_operator:
+        _stack.push_back(primary_term{});
+        return parse_term();
+      case token::type::binary_term_operator:
+        if(tok->data<binary_term::type>() != binary_term::type::subtraction)
+          break;
+        _stack.push_back(primary_term{});
+        return parse_term();
+      case token::type::punctuation:
+        if(tok->data<token::punctuation>() == token::punctuation::let)
+          return parse_let();
+        if(tok->data<token::punctuation>() != token::punctuation::left_paren)
+          break;
+        consume();
+        _stack.push_back(parens{});
+        _stack.push_back(formula_ops{0});
+        return step::formula;
+      default:
+        break;
     }
-  }
-
-  std::optional<formula> parser::_parser_t::parse_boolean()
-  {
-    black_assert(peek() && peek()->token_type() == token::type::boolean);  // LCOV_EXCL_LINE
-
-    std::optional<token> tok = consume();
 
-    black_assert(tok);
-    black_assert(tok->token_type() == token::type::boolean);
-
-    return _alphabet.boolean(*tok->data<bool>());
-  }
-
-  std::optional<formula> parser::_parser_t::parse_relational_atom() {
-    black_assert(peek());
-    
-    std::optional<term> lhs = parse_term();
-    if(!lhs)
-      return {};
-
-    if(!peek() || 
-      (peek()->token_type() != token::type::equality &&
-       peek()->token_type() != token::type::comparison))
-      return {};
-
-    token op = *peek();
-    consume();
-
-    std::optional<term> rhs = parse_term();
-    if(!rhs)
-      return {};
-
-    if(op.token_type() == token::type::equality)
-      return equality(
-        op.data<token::equality_t>()->first, std::vector<term>{*lhs, *rhs}
-      );
-
-    black_assert(op.token_type() == token::type::comparison);
-    return comparison(*op.data<comparison::type>(), *lhs, *rhs);
+    return fail("Expected formula, found '" + to_string(*tok) + "'");
   }
 
-  std::optional<formula> parser::_parser_t::parse_atom()
-  {
-    black_assert(peek());
-
-    std::optional<formula> a = 
-      try_parse([&](){ return parse_relational_atom(); });
-    if(a)
-      return a;
-
-    if(peek()->token_type() != token::type::identifier)
-      return error("Expected identifier, found '" + to_string(*peek()) + "'");
-
-    std::string id{*peek()->data<std::string>()};
-    consume();
-
-    // if there is no open paren this is a simple proposition
-    if(!peek() || 
-        peek()->data<token::punctuation>() != token::punctuation::left_paren)
-      return _alphabet.proposition(id);
-
-    // otherwise it is a relational atom
-    std::vector<term> terms;
-    do {      
-      consume();
-      std::optional<term> t = parse_term();
-      if(!t)
-        return {};
-      terms.push_back(*t);
-    } while(
-      peek() && 
-      peek()->data<token::punctuation>() == token::punctuation::comma
-    );
-
-    if(!consume(token::punctuation::right_paren))
-      return {};
-
-    relation r = _alphabet.relation(id);
-    return r(terms);
-  }
-
-  std::optional<formula> parser::_parser_t::parse_quantifier() {
+  parser::_parser_t::step parser::_parser_t::parse_quantifier() {
     black_assert(peek());
     black_assert(peek()->data<quantifier::type>());
 
-    quantifier::type q = quantifier::type::forall;
-    if(consume()->data<quantifier::type>() == quantifier::type::exists) 
-      q = quantifier::type::exists;
+    quantifier::type q = *consume()->data<quantifier::type>();
 
     std::vector<var_decl> vars;
-    while(
-      !peek() || 
-      peek()->data<token::punctuation>() != token::punctuation::dot
-    ) {
+    std::vector<std::string_view> names;
+    while(!peek_is(token::punctuation::dot)) {
       bool paren = false;
-      if(peek()->data<token::punctuation>() == 
-         token::punctuation::left_paren) 
-      {
+      if(peek_is(token::punctuation::left_paren)) {
         consume();
         paren = true;
       }
       if(!peek())
-        return error("Expected variable name, found end of input");
+        return fail("Expected variable name, found end of input");
 
       if(peek()->token_type() != token::type::identifier)
         return 
-          error("Expected variable name, found '" + to_string(*peek()) + "'");
+          fail("Expected variable name, found '" + to_string(*peek()) + "'");
 
-      identifier varid = *consume()->data<std::string>();
+      std::string_view varid = *consume()->data<std::string_view>();
 
-      std::optional<sort> s;
       if(!peek())
-        return error("Expected ':', found end of input");
+        return fail("Expected ':', found end of input");
 
       if(peek()->data<token::punctuation>() != token::punctuation::colon) 
-        return error("Expected ':', found '" + to_string(*peek()) + "'");
+        return fail("Expected ':', found '" + to_string(*peek()) + "'");
 
       consume(); // consume the colon
       
-      s = parse_sort();
+      std::optional<sort> s = parse_sort();
       if(!s)
-        return {};
+        return step::failed;
 
       vars.push_back(_alphabet.var_decl(_alphabet.variable(varid), *s));
+      names.push_back(varid);
 
       if(paren && !consume(token::punctuation::right_paren))
-        return {};
+        return step::failed;
 
-      if(
-        peek() && 
-        peek()->data<token::punctuation>() == token::punctuation::comma
-      ) {
+      if(peek_is(token::punctuation::comma)) {
         consume();
-        if(
-          peek() && 
-          peek()->data<token::punctuation>() == token::punctuation::comma
-        ) {
-          return error("Expected variable, found '" + to_string(*peek()) + ";");
-        } 
+        if(peek_is(token::punctuation::comma))
+          return fail("Expected variable, found '" + to_string(*peek()) + ";");
       }
     }
 
-    if(!peek())
-      return error("Expected '.', found end of input");
-
     if(vars.empty())
-      return error("Expected variable list, found '.'");
+      return fail("Expected variable list, found '.'");
 
     consume(); // consume the dot
 
-    std::optional<formula> matrix = parse_primary();
-    if(!matrix)
-      return {};
+    // the matrix is a primary formula
+    std::vector<std::pair<std::string_view, item>> hidden;
+    for(std::string_view name : names) {
+      if(auto it = _lets.find(name); it != _lets.end()) {
+        hidden.push_back(*it);
+        _lets.erase(it);
+      }
+    }
+
+    _stack.push_back(quantifier_op{q, std::move(vars), std::move(hidden)});
+    return step::formula;
+  }
 
-    if(q == quantifier::type::exists)
-      return exists(vars, *matrix);
+  parser::_parser_t::step parser::_parser_t::parse_let() {
+    consume(); // consume the `let`
 
-    return forall(vars, *matrix);
+    std::optional<token> tok = consume();
+    if(!tok)
+      return fail("Expected name, found end of input");
+    if(tok->token_type() != token::type::identifier)
+      return fail("Expected name, found '" + to_string(*tok) + "'");
+    
+    std::string_view name = *tok->data<std::string_view>();
+    
+    std::optional<token> eq = consume();
+    if(!eq)
+      return fail("Expected '=', found end of input");
+    if(eq->data<token::equality_t>() != 
+        token::equality_t{equality::type::equal, true})
+      return fail("Expected '=', found '" + to_string(*eq) + "'");
+
+    // the value is parsed as a whole formula, or term, up to the `in`
+    _stack.push_back(let_value{name});
+    _stack.push_back(formula_ops{0});
+    return step::formula;
   }
 
-  std::optional<formula> parser::_parser_t::parse_unary()
-  {
-    std::optional<token> op = consume(); // consume unary op
-    black_assert(op && op->is<unary::type>());  // LCOV_EXCL_LINE
+  //
+  // Here we resolve the ambiguity between formulas and terms: if `_item` is
+  // followed by an arithmetic operator it is the left operand of a term, and
+  // if it is followed by a relational operator it is the left-hand side of a
+  // relational atom. Otherwise, it is a primary formula.
+  //
+  parser::_parser_t::step parser::_parser_t::parse_item() {
+    if(std::holds_alternative<formula>(*_item) || !peek())
+      return step::primary;
 
-    std::optional<formula> formula = parse_primary();
-    if(!formula)
-      return {};
+    token tok = *peek();
+    if(tok.is<binary_term::type>()) {
+      std::optional<term> lhs = to_term(*_item);
+      if(!lhs)
+        return step::failed;
+      
+      _stack.push_back(primary_term{});
+      _stack.push_back(term_ops{0, *lhs});
+      return step::term_rhs;
+    }
+
+    if(tok.is<token::equality_t>() || tok.is<comparison::type>()) {
+      std::optional<term> lhs = to_term(*_item);
+      if(!lhs)
+        return step::failed;
+
+      consume();
+      _stack.push_back(relational{*lhs, tok});
+      return parse_term();
+    }
 
-    return unary(*op->data<unary::type>(), *formula);
+    return step::primary;
   }
 
-  std::optional<formula> parser::_parser_t::parse_parens() {
-    black_assert(peek());
-    black_assert(
-      peek()->data<token::punctuation>() == token::punctuation::left_paren);
+  parser::_parser_t::step parser::_parser_t::parse_operand() {
+    black_assert(!_stack.empty());
+    frame &top = _stack.back();
 
-    std::optional<formula> a = 
-      try_parse([&](){ return parse_relational_atom(); });
-    if(a)
-      return a;
+    if(auto op = std::get_if<unary_op>(&top); op) {
+      unary::type type = op->op;
+      _stack.pop_back();
 
-    consume(); // Consume left paren '('
+      std::optional<formula> f = to_formula(*_item);
+      if(!f)
+        return step::failed;
+      
+      _item = unary(type, *f);
+      return step::primary;
+    }
+
+    if(auto q = std::get_if<quantifier_op>(&top); q) {
+      std::optional<formula> matrix = to_formula(*_item);
+      if(!matrix)
+        return step::failed;
+
+      if(q->q == quantifier::type::exists)
+        _item = exists(q->vars, *matrix);
+      else
+        _item = forall(q->vars, *matrix);
+      
+      for(auto const& [name, value] : q->hidden)
+        _lets.insert_or_assign(name, value);
+
+      _stack.pop_back();
+      return step::primary;
+    }
+
+    formula_ops &ops = std::get<formula_ops>(top);
+    if(!ops.lhs) {
+      ops.lhs = *_item;
+      return step::formula_rhs;
+    }
+
+    // if the next operator binds tighter, it climbs to the next level
+    black_assert(ops.op);
+    if(!peek() || precedence(*ops.op) < precedence(*peek())) {
+      int prec = ops.prec + 1;
+      _stack.push_back(formula_ops{prec, *_item});
+      return step::formula_rhs;
+    }
+
+    std::optional<formula> rhs = to_formula(*_item);
+    if(!rhs)
+      return step::failed;
+
+    ops.lhs = binary(
+      *ops.op->data<binary::type>(), std::get<formula>(*ops.lhs), *rhs
+    );
+    ops.op = std::nullopt;
 
-    std::optional<formula> formula = parse_formula();
-    if(!formula)
-      return {}; // error raised by parse();
+    return step::formula_rhs;
+  }
 
-    if(!consume(token::punctuation::right_paren))
-      return {}; // error raised by consume()
+  parser::_parser_t::step parser::_parser_t::parse_binary_rhs() {
+    formula_ops &ops = std::get<formula_ops>(_stack.back());
+    black_assert(ops.lhs);
 
-    return formula;
+    if(!peek() || precedence(*peek()) < ops.prec) {
+      _item = *ops.lhs;
+      _stack.pop_back();
+      return step::formula_done;
+    }
+
+    std::optional<formula> lhs = to_formula(*ops.lhs);
+    if(!lhs)
+      return step::failed;
+
+    ops.lhs = *lhs;
+    ops.op = consume();
+
+    return step::formula;
   }
 
-  std::optional<formula> parser::_parser_t::parse_primary() {
-    if(!peek())
-      return {};
+  parser::_parser_t::step parser::_parser_t::parse_formula_done() {
+    frame &top = _stack.back();
+
+    if(std::holds_alternative<parens>(top)) {
+      _stack.pop_back();
+      if(!consume(token::punctuation::right_paren))
+        return step::failed;
+
+      return step::item;
+    }
 
-    if(peek()->token_type() == token::type::boolean)
-      return parse_boolean();
-    if(peek()->token_type() == token::type::integer ||
-       peek()->token_type() == token::type::real ||
-       peek()->data<binary_term::type>() == binary_term::type::subtraction ||
-       peek()->token_type() == token::type::identifier ||
-       peek()->data<unary_term::type>() == unary_term::type::to_integer ||
-       peek()->data<unary_term::type>() == unary_term::type::to_real ||
-       peek()->data<unary_term::type>() == unary_term::type::next ||
-       peek()->data<unary_term::type>() == unary_term::type::wnext ||
-       peek()->data<unary_term::type>() == unary_term::type::prev ||
-       peek()->data<unary_term::type>() == unary_term::type::wprev)
-      return parse_atom();
-    if(peek()->data<quantifier::type>() == quantifier::type::exists ||
-       peek()->data<quantifier::type>() == quantifier::type::forall)
-      return parse_quantifier();
-    if(peek()->is<unary::type>())
-      return parse_unary();
-    if(peek()->data<token::punctuation>() == token::punctuation::left_paren)
-       return parse_parens();
-
-    return error("Expected formula, found '" + to_string(*peek()) + "'");
+    if(auto let = std::get_if<let_value>(&top); let) {
+      std::string_view name = let->name;
+      _stack.pop_back();
+      if(!consume(token::punctuation::in))
+        return step::failed;
+
+      std::optional<item> hidden;
+      if(auto it = _lets.find(name); it != _lets.end())
+        hidden = it->second;
+      _lets.insert_or_assign(name, *_item);
+
+      _stack.push_back(let_body{name, std::move(hidden)});
+      _stack.push_back(formula_ops{0});
+      return step::formula;
+    }
+
+    if(auto let = std::get_if<let_body>(&top); let) {
+      if(let->hidden)
+        _lets.insert_or_assign(let->name, *let->hidden);
+      else
+        _lets.erase(let->name);
+      
+      _stack.pop_back();
+      return step::item;
+    }
+
+    // the right operand of the operator waiting at the previous level
+    formula_ops &ops = std::get<formula_ops>(top);
+    black_assert(ops.op);
+
+    std::optional<formula> rhs = to_formula(*_item);
+    if(!rhs)
+      return step::failed;
+    
+    ops.lhs = binary(
+      *ops.op->data<binary::type>(), std::get<formula>(*ops.lhs), *rhs
+    );
+    ops.op = std::nullopt;
+
+    return step::formula_rhs;
   }
 
   std::optional<sort> parser::_parser_t::parse_sort() 
@@ -491,48 +713,74 @@ namespace black_internal
       return _alphabet.real_sort();
 
     if(tok->token_type() == token::type::identifier)
-      return _alphabet.named_sort(*tok->data<std::string>());
+      return _alphabet.named_sort(*tok->data<std::string_view>());
 
     return error("Expected sort, found '" + to_string(*tok) + "'");
   }
 
-  std::optional<term> parser::_parser_t::parse_term() {
-    std::optional<term> lhs = parse_term_primary();
-    if(!lhs) {
-      if(peek())
-        return error("Expected term, found '" + to_string(*peek()) + "'");
-      return error("Expected term, found end of input");
-    }
-    
-    return parse_term_binary_rhs(0, *lhs);
+  parser::_parser_t::step parser::_parser_t::parse_term() {
+    _stack.push_back(term_ops{0});
+    return step::term;
   }
 
-  std::optional<term> parser::_parser_t::parse_term_primary() {
-    if(!peek())
-      return {};
-
-    if(peek()->token_type() == token::type::integer ||
-       peek()->token_type() == token::type::real)
-      return parse_term_constant();
-
-    if(peek()->data<binary_term::type>() == binary_term::type::subtraction)
-      return parse_term_unary_minus();
-
-    if(peek()->data<unary_term::type>() == unary_term::type::to_integer ||
-       peek()->data<unary_term::type>() == unary_term::type::to_real ||
-       peek()->data<unary_term::type>() == unary_term::type::next ||
-       peek()->data<unary_term::type>() == unary_term::type::wnext ||
-       peek()->data<unary_term::type>() == unary_term::type::prev ||
-       peek()->data<unary_term::type>() == unary_term::type::wprev)
-       return parse_term_ctor();
-
-    if(peek()->token_type() == token::type::identifier)
-      return parse_term_var_or_func();
+  parser::_parser_t::step parser::_parser_t::parse_term_primary() {
+    std::optional<token> tok = peek();
+    if(!tok)
+      return fail("Expected term, found end of input");
 
-    if(peek()->data<token::punctuation>() == token::punctuation::left_paren)
-      return parse_term_parens();
+    switch(tok->token_type()) {
+      case token::type::integer:
+        consume();
+        _term = constant(_alphabet.integer(*tok->data<int64_t>()));
+        return step::term_primary;
+      case token::type::real:
+        consume();
+        _term = constant(_alphabet.real(*tok->data<double>()));
+        return step::term_primary;
+      case token::type::binary_term_operator:
+        if(tok->data<binary_term::type>() != binary_term::type::subtraction)
+          break;
+        consume();
+        _stack.push_back(negative_op{});
+        return parse_term();
+      case token::type::unary_term_operator:
+        consume();
+        if(!consume(token::punctuation::left_paren))
+          return step::failed;
+        _stack.push_back(term_ctor{*tok->data<unary_term::type>()});
+        return parse_term();
+      case token::type::identifier: {
+        consume();
+        std::string_view id = *tok->data<std::string_view>();
+
+        // if there is no open paren this is a simple variable, unless it is
+        // the name of a `let`
+        if(!peek_is(token::punctuation::left_paren)) {
+          if(auto it = _lets.find(id); it != _lets.end()) {
+            _term = to_term(it->second);
+            if(!_term)
+              return step::failed;
+          } else
+            _term = _alphabet.variable(id);
+          return step::term_primary;
+        }
+
+        // otherwise it is a function application
+        consume();
+        _stack.push_back(arguments{id, {}, false});
+        return parse_term();
+      }
+      case token::type::punctuation:
+        if(tok->data<token::punctuation>() != token::punctuation::left_paren)
+          break;
+        consume();
+        _stack.push_back(term_parens{});
+        return parse_term();
+      default:
+        break;
+    }
 
-    return error("Expected term, found '" + to_string(*peek()) + "'");
+    return fail("Expected term, found '" + to_string(*tok) + "'");
   }
 
   static std::optional<int> func_precedence(token const&tok)
@@ -555,136 +803,120 @@ namespace black_internal
     black_unreachable();
   }
 
-  std::optional<term> 
-  parser::_parser_t::parse_term_binary_rhs(int prec, term lhs) {
-    while(1) {
-      if(!peek() || func_precedence(*peek()) < prec)
-         return {lhs};
-
-      token op = *consume();
-
-      std::optional<term> rhs = parse_term_primary();
-      if(!rhs)
-        return error("Expected right operand to binary function symbol");
-
-      if(!peek() || func_precedence(op) < func_precedence(*peek())) {
-        rhs = parse_term_binary_rhs(prec + 1, *rhs);
-        if(!rhs)
-          return error("Expected right operand to binary function symbol");
-      }
-      
-      black_assert(op.is<binary_term::type>());
-      lhs = binary_term(*op.data<binary_term::type>(), lhs, *rhs);
+  parser::_parser_t::step parser::_parser_t::parse_term_operand() {
+    term_ops &ops = std::get<term_ops>(_stack.back());
+    if(!ops.lhs) {
+      ops.lhs = *_term;
+      return step::term_rhs;
     }
-  }
-
-  std::optional<term> parser::_parser_t::parse_term_constant() {
-    black_assert(peek());
-    black_assert( // LCOV_EXCL_LINE
-      peek()->token_type() == token::type::integer ||
-      peek()->token_type() == token::type::real
-    );
 
-    token tok = *peek();
-    consume();
-
-    if(tok.token_type() == token::type::integer) {
-      int64_t value = *tok.data<int64_t>();
-      return constant(_alphabet.integer(value));
+    // if the next operator binds tighter, it climbs to the next level
+    black_assert(ops.op);
+    if(!peek() || func_precedence(*ops.op) < func_precedence(*peek())) {
+      int prec = ops.prec + 1;
+      _stack.push_back(term_ops{prec, *_term});
+      return step::term_rhs;
     }
-    
-    black_assert(tok.token_type() == token::type::real);
 
-    double value = *tok.data<double>();
-    return constant(_alphabet.real(value));
-  }
+    ops.lhs = binary_term(*ops.op->data<binary_term::type>(), *ops.lhs, *_term);
+    ops.op = std::nullopt;
 
-  std::optional<term> parser::_parser_t::parse_term_unary_minus() {
-    black_assert(peek());
-    black_assert(
-      peek()->data<binary_term::type>() == binary_term::type::subtraction
-    );
-
-    consume();
-    std::optional<term> t = parse_term();
-    if(!t)
-      return {};
-    return negative(*t);
+    return step::term_rhs;
   }
 
-  std::optional<term> parser::_parser_t::parse_term_ctor() {
-    black_assert(
-      peek()->data<unary_term::type>() == unary_term::type::to_integer ||
-      peek()->data<unary_term::type>() == unary_term::type::to_real ||
-      peek()->data<unary_term::type>() == unary_term::type::next ||
-      peek()->data<unary_term::type>() == unary_term::type::wnext ||
-      peek()->data<unary_term::type>() == unary_term::type::prev ||
-      peek()->data<unary_term::type>() == unary_term::type::wprev
-    );
+  parser::_parser_t::step parser::_parser_t::parse_term_binary_rhs() {
+    term_ops &ops = std::get<term_ops>(_stack.back());
+    black_assert(ops.lhs);
 
-    token op = *consume();
+    if(!peek() || func_precedence(*peek()) < ops.prec) {
+      _term = *ops.lhs;
+      _stack.pop_back();
+      return step::term_done;
+    }
 
-    if(!consume(token::punctuation::left_paren))
-      return {};
+    ops.op = consume();
+    return step::term;
+  }
 
-    std::optional<term> t = parse_term();
-    if(!t)
-      return {};
+  parser::_parser_t::step parser::_parser_t::parse_term_done() {
+    black_assert(!_stack.empty());
+    frame &top = _stack.back();
 
-    if(!consume(token::punctuation::right_paren))
-      return {};
+    if(auto ops = std::get_if<term_ops>(&top); ops) {
+      black_assert(ops->op);
+      ops->lhs = 
+        binary_term(*ops->op->data<binary_term::type>(), *ops->lhs, *_term);
+      ops->op = std::nullopt;
+      return step::term_rhs;
+    }
 
-    return unary_term(*op.data<unary_term::type>(), *t);
-  }
+    if(std::holds_alternative<negative_op>(top)) {
+      _stack.pop_back();
+      _term = negative(*_term);
+      return step::term_primary;
+    }
 
-  std::optional<term> 
-  parser::_parser_t::parse_term_var_or_func() {
-    black_assert(peek());
-    black_assert(peek()->token_type() == token::type::identifier);
+    if(auto ctor = std::get_if<term_ctor>(&top); ctor) {
+      unary_term::type type = ctor->op;
+      _stack.pop_back();
+      if(!consume(token::punctuation::right_paren))
+        return step::failed;
+      
+      _term = unary_term(type, *_term);
+      return step::term_primary;
+    }
 
-    std::string id{*peek()->data<std::string>()};
-    consume();
+    if(std::holds_alternative<term_parens>(top)) {
+      _stack.pop_back();
+      if(!consume(token::punctuation::right_paren))
+        return step::failed;
 
-    // if there is no open paren this is a simple variable
-    if(!peek() || 
-        peek()->data<token::punctuation>() != token::punctuation::left_paren)
-      return _alphabet.variable(id);
+      return step::term_primary;
+    }
 
-    // otherwise it is a function application
-    std::vector<term> terms;
-    do {      
-      consume();
-      std::optional<term> t = parse_term();
-      if(!t)
-        return {};
-      terms.push_back(*t);
-    } while(
-      peek() && 
-      peek()->data<token::punctuation>() == token::punctuation::comma
-    );
+    if(auto args = std::get_if<arguments>(&top); args) {
+      args->terms.push_back(*_term);
+      if(peek_is(token::punctuation::comma)) {
+        consume();
+        return parse_term();
+      }
 
-    if(!consume(token::punctuation::right_paren))
-      return {};
+      if(!consume(token::punctuation::right_paren))
+        return step::failed;
 
-    function f = _alphabet.function(id);
-    return f(terms);
-  }
+      arguments app = std::move(*args);
+      _stack.pop_back();
 
-  std::optional<term> parser::_parser_t::parse_term_parens() {
-    black_assert(peek());
-    black_assert(
-      peek()->data<token::punctuation>() == token::punctuation::left_paren);
+      if(app.primary) {
+        _item = pending{app.id, std::move(app.terms)};
+        return step::item;
+      }
 
-    consume(); // Consume left paren '('
+      function f = _alphabet.function(app.id);
+      _term = f(app.terms);
+      return step::term_primary;
+    }
 
-    std::optional<term> t = parse_term();
-    if(!t)
-      return {}; // error raised by parse();
+    if(auto rel = std::get_if<relational>(&top); rel) {
+      relational r = std::move(*rel);
+      _stack.pop_back();
 
-    if(!consume(token::punctuation::right_paren))
-      return {}; // error raised by consume()
+      if(r.op.token_type() == token::type::equality)
+        _item = equality(
+          r.op.data<token::equality_t>()->first, 
+          std::vector<term>{r.lhs, *_term}
+        );
+      else
+        _item = comparison(*r.op.data<comparison::type>(), r.lhs, *_term);
+      
+      return step::item;
+    }
 
-    return t;
+    black_assert(std::holds_alternative<primary_term>(top));
+    _stack.pop_back();
+    _item = *_term;
+    
+    return step::item;
   }
 
 } // namespace black_internal
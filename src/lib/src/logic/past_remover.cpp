@@ -24,7 +24,9 @@
 #include <black/logic/past_remover.hpp>
 #include <black/logic/prettyprint.hpp>
 
-#include <numeric>
+#include <tsl/hopscotch_set.h>
+
+#include <vector>
 
 namespace black_internal::remove_past {
 
@@ -49,73 +51,119 @@ namespace black_internal::remove_past {
     return a && G(implies(X(a), f) && implies(f, wX(a)));
   }
 
-  // Obtain semantics for since propositional letter
+  // Obtain semantics for since propositional letter, given the letter `y`
+  // for its yesterday, whose semantics is obtained separately
   static
   formula since_semantics(
     proposition since, formula l, formula r, proposition y
   ) {
-    return G(iff(since, r || (l && y))) && yesterday_semantics(y, since);
+    return G(iff(since, r || (l && y)));
   }
 
-  static
-  formula sub_past(formula f, std::vector<formula> &sem) {
+  //
+  // Replaces the past subformulas of a formula with fresh labels, collecting
+  // the semantics of the labels. The translation is a `fold_t`, so each 
+  // distinct subformula is translated once, making the whole translation
+  // linear in the size of the DAG of the formula without deep recursion, and
+  // the semantics of each label is collected only once, however many times
+  // the label occurs.
+  //
+  class past_remover 
+  {
+  public:
+    formula sub_past(formula f) {
+      auto translate = [this](formula g, auto const& result) {
+        return this->translate(g, result);
+      };
+      return _fold(f, translate);
+    }
+
+    std::vector<formula> const& semantics() const { return _semantics; }
+
+  private:
+    template<typename R>
+    formula translate(formula f, R const& sub_past);
+
+    void add_semantics(formula f) {
+      if(_emitted.insert(f).second)
+        _semantics.push_back(f);
+    }
+
+    fold_t<formula::hierarchy, formula> _fold;
+    tsl::hopscotch_set<formula> _emitted;
+    std::vector<formula> _semantics;
+  };
+
+  //
+  // `sub_past(g)` returns the translation of `g`, which is already done if
+  // `g` is a child of `f`, and is done on the spot otherwise
+  //
+  template<typename R>
+  formula past_remover::translate(formula f, R const& sub_past) {
     return f.match( // LCOV_EXCL_LINE
-        [&](boolean b) { return b; },
-        [&](proposition p) { return p; },
+        [&](boolean b) -> formula { return b; },
+        [&](proposition p) -> formula { return p; },
         
-        [&](yesterday, auto op) {
-          auto sub = sub_past(op, sem);
+        [&](yesterday, auto op) -> formula {
+          formula sub = sub_past(op);
           auto prop = past_label(Y(sub));
-          sem.push_back(yesterday_semantics(prop, sub));
+          add_semantics(yesterday_semantics(prop, sub));
 
           return prop;
         },
-        [&](w_yesterday, auto op) {
-          auto sub = sub_past(op, sem);
+        [&](w_yesterday, auto op) -> formula {
+          formula sub = sub_past(op);
           auto prop = past_label(Z(op));
-          sem.push_back(w_yesterday_semantics(prop, sub));
+          add_semantics(w_yesterday_semantics(prop, sub));
 
           return prop;
         },
-        [&](since, auto left, auto right) {
-          auto lsub = sub_past(left, sem);
-          auto rsub = sub_past(right, sem);
+        [&](since, auto left, auto right) -> formula {
+          formula lsub = sub_past(left);
+          formula rsub = sub_past(right);
           auto prop = past_label(S(lsub, rsub));
           auto yprop = past_label(Y(prop));
 
-          sem.push_back(since_semantics(prop, lsub, rsub, yprop));
+          add_semantics(since_semantics(prop, lsub, rsub, yprop));
+          add_semantics(yesterday_semantics(yprop, prop));
 
           return prop;
         },
-        [&](triggered, auto left, auto right) {
-          return sub_past(!S(!left, !right), sem);
+        [&](triggered, auto left, auto right) -> formula {
+          return sub_past(!S(!left, !right));
         },
-        [&](once p, auto op) { 
-          return sub_past(S(p.sigma()->top(), op), sem); 
+        [&](once p, auto op) -> formula { 
+          return sub_past(S(p.sigma()->top(), op)); 
         },
-        [&](historically, auto op) { 
-          return sub_past(!O(!op), sem); 
+        [&](historically, auto op) -> formula { 
+          return sub_past(!O(!op)); 
         },
-        [&](unary u, auto arg) {
-          return unary(u.node_type(), sub_past(arg, sem));
+        [&](unary u, auto arg) -> formula {
+          return unary(u.node_type(), sub_past(arg));
         },
-        [&](binary b, auto left, auto right) {
-          return binary(
-            b.node_type(), sub_past(left, sem), sub_past(right, sem)
-          );
+        [&](binary b, auto left, auto right) -> formula {
+          return binary(b.node_type(), sub_past(left), sub_past(right));
+        },
+        [&](nary n, auto operands) -> formula {
+          std::vector<formula> ops;
+          for(formula op : operands)
+            ops.push_back(sub_past(op));
+          return nary(n.node_type(), ops);
         }
     );
   }
 
   formula remove_past(formula f) {
-    
-    std::vector<formula> semantics;
-    formula ltl = sub_past(f, semantics);
+    past_remover remover;
+    formula ltl = remover.sub_past(f);
 
     // Conjoin the ltl formula with its semantics formulas
-    return // LCOV_EXCL_LINE
-      std::accumulate(semantics.begin(), semantics.end(), ltl, // LCOV_EXCL_LINE
-        [](auto f1, auto f2) { return f1 && f2; }
+    std::vector<formula> conjuncts = {ltl};
+    conjuncts.insert(
+      conjuncts.end(), 
+      remover.semantics().begin(), remover.semantics().end()
     );
+
+    return big_and(*f.sigma(), conjuncts);
   }
 } // namespace black_internal
@@ -30,6 +30,15 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
 namespace black_internal::logic
 {
 
@@ -42,6 +51,9 @@ namespace black_internal::logic
         (!parent.is<conjunction>() && !parent.is<disjunction>())
           || (parent.node_type() != arg.node_type());
       },
+      [&](nary) {
+        parens = true;
+      },
       [&](comparison) {
         parens = true;
       },
@@ -55,7 +67,7 @@ namespace black_internal::logic
   }
 
   static
-  std::string to_string(unary::type t) {
+  std::string_view to_string(unary::type t) {
     switch(t) {
       case unary::type::negation:
         return "!";
@@ -80,7 +92,7 @@ namespace black_internal::logic
   }
 
   static
-  std::string to_string(binary::type t) {
+  std::string_view to_string(binary::type t) {
     switch(t) {
       case binary::type::conjunction:
         return "&";
@@ -107,7 +119,7 @@ namespace black_internal::logic
   }
 
   static
-  std::string to_string(equality::type t, bool binary) {
+  std::string_view to_string(equality::type t, bool binary) {
     switch(t) {
       case equality::type::equal:
         return binary ? "=" : "equal";
@@ -118,7 +130,7 @@ namespace black_internal::logic
   }
 
   static
-  std::string to_string(comparison::type t) {
+  std::string_view to_string(comparison::type t) {
     switch(t) {
       case comparison::type::less_than:
         return "<";
@@ -132,11 +144,6 @@ namespace black_internal::logic
     black_unreachable();
   }
 
-  template<typename T>
-  std::string parens_if_needed(T t, bool needs_parens) {
-    return needs_parens ? "(" + to_string(t) + ")" : to_string(t);
-  }
-
   static
   std::string escape(std::string s) {
     if(s.empty())
@@ -171,164 +178,432 @@ namespace black_internal::logic
     return s;
   }
 
-  static
-  std::string term_parens(term t) {
-    return t.match(
-      [&](variable) {
-        return to_string(t);
-      },
-      [&](constant) {
-        return to_string(t);
-      },
-      [&](otherwise) {
-        return "(" + to_string(t) + ")";
+  //
+  // The printers below are iterative: printing a node writes what comes
+  // before its children, and schedules the children, with what comes between
+  // and after them, on an explicit stack of tasks. In this way the output is
+  // written directly to the stream, in time linear in its size, and without
+  // overflowing the native stack on deep formulas.
+  //
+  // Subformulas and subterms bound to a name with `bind()` are printed as
+  // that name instead of in full, unless the derived printer hides the names
+  // by making `_hidden` nonzero.
+  //
+  template<typename Derived>
+  class stack_printer 
+  {
+  public:
+    explicit stack_printer(std::ostream &out) : _out{out} { }
+
+    void bind(hierarchy auto h, std::string name) {
+      _names.insert({h.node(), std::move(name)});
+    }
+
+    // prints `h`, or its name if it is bound
+    void operator()(hierarchy auto h) {
+      schedule(h);
+      run();
+    }
+
+    // prints `h` in full, even if it is bound
+    void print(hierarchy auto h) {
+      static_cast<Derived &>(*this).expand(h);
+      run();
+    }
+
+  protected:
+    struct unhide { };
+    using task = std::variant<std::string_view, formula, term, unhide>;
+
+    bool named(hierarchy auto h) const {
+      return _hidden == 0 && _names.count(h.node()) > 0;
+    }
+
+    // schedules the arguments to be printed in order
+    template<typename ...Args>
+    void schedule(Args ...args) {
+      std::array<task, sizeof...(Args)> tasks = {task{args}...};
+      for(auto it = tasks.rbegin(); it != tasks.rend(); ++it)
+        _stack.push_back(*it);
+    }
+
+    void run() {
+      while(!_stack.empty()) {
+        task t = _stack.back();
+        _stack.pop_back();
+
+        std::visit(overloaded {
+          [&](std::string_view s) { 
+            _out << s; 
+          },
+          [&](unhide) { 
+            --_hidden; 
+          },
+          [&](auto h) {
+            auto it = _names.find(h.node());
+            if(_hidden == 0 && it != _names.end())
+              _out << it->second;
+            else
+              static_cast<Derived &>(*this).expand(h);
+          }
+        }, t);
       }
-    );
-  }
+    }
+
+    std::ostream &_out;
+    size_t _hidden = 0;
+    std::vector<task> _stack;
+    tsl::hopscotch_map<hierarchy_node const *, std::string> _names;
+  };
 
-  std::string to_string(term t)
+  //
+  // Printer of formulas and terms in our own syntax, read back by the parser.
+  //
+  class printer : public stack_printer<printer>
+  {
+  public:
+    using stack_printer::stack_printer;
+
+    void expand(term t);
+    void expand(formula f);
+
+  private:
+    static std::string_view open(bool parens) { return parens ? "(" : ""; }
+    static std::string_view close(bool parens) { return parens ? ")" : ""; }
+
+    bool needs_parens(formula parent, formula arg) const {
+      return !named(arg) && does_need_parens(parent, arg);
+    }
+
+    bool needs_parens(term t) const {
+      return !named(t) && !t.is<variable>() && !t.is<constant>();
+    }
+
+    void infix(term left, std::string_view op, term right) {
+      bool l = needs_parens(left);
+      bool r = needs_parens(right);
+      schedule(open(l), left, close(l), op, open(r), right, close(r));
+    }
+
+    // schedules `t1, ..., tn)`
+    void arguments(auto const& terms) {
+      _stack.push_back(std::string_view{")"});
+      for(size_t i = terms.size(); i > 0; --i) {
+        _stack.push_back(term{terms[i - 1]});
+        if(i > 1)
+          _stack.push_back(std::string_view{", "});
+      }
+    }
+  };
+
+  void printer::expand(term t)
   {
-    using namespace std::literals;
     using namespace black_internal;
 
-    return t.match(
+    t.match(
       [&](constant c) {
-        return to_string(c.value());
+        _out << to_string(c.value());
       },
       [&](variable x) {
-        return escape(to_string(x.name()));
+        _out << escape(to_string(x.name()));
       },
       [&](application a) {
-        std::string result = 
-          escape(to_string(a.func().name())) + "(" + to_string(a.terms()[0]);
-        for(size_t i = 1; i < a.terms().size(); ++i) {
-          result += ", " + to_string(a.terms()[i]);
-        }
-        result += ")";
-
-        return result;
-      }, // LCOV_EXCL_LINE
+        _out << escape(to_string(a.func().name())) << "(";
+        arguments(a.terms());
+      },
       [&](negative, auto arg) {
-        return fmt::format("-({})", to_string(arg));
+        _out << "-(";
+        schedule(arg, ")");
       },
       [&](to_integer, auto arg) {
-        return fmt::format("to_int({})", to_string(arg));
+        _out << "to_int(";
+        schedule(arg, ")");
       },
       [&](to_real, auto arg) {
-        return fmt::format("to_real({})", to_string(arg));
+        _out << "to_real(";
+        schedule(arg, ")");
       },
       [&](next, auto arg) {
-        return fmt::format("next({})", to_string(arg));
+        _out << "next(";
+        schedule(arg, ")");
       },
       [&](wnext, auto arg) {
-        return fmt::format("wnext({})", to_string(arg));
+        _out << "wnext(";
+        schedule(arg, ")");
       },
       [&](prev, auto arg) {
-        return fmt::format("prev({})", to_string(arg));
+        _out << "prev(";
+        schedule(arg, ")");
       },
       [&](wprev, auto arg) {
-        return fmt::format("wprev({})", to_string(arg));
+        _out << "wprev(";
+        schedule(arg, ")");
       },
       [&](addition, auto left, auto right) {
-        return fmt::format("{} + {}", term_parens(left), term_parens(right));
+        infix(left, " + ", right);
       },
       [&](subtraction, auto left, auto right) {
-        return fmt::format("{} - {}", term_parens(left), term_parens(right));
+        infix(left, " - ", right);
       },
       [&](multiplication, auto left, auto right) {
-        return fmt::format("{} * {}", term_parens(left), term_parens(right));
+        infix(left, " * ", right);
       },
       [&](division, auto left, auto right) {
-        return fmt::format("{} / {}", term_parens(left), term_parens(right));
+        infix(left, " / ", right);
       },
       [&](int_division, auto left, auto right) {
-        return fmt::format("{} div {}", term_parens(left), term_parens(right));
+        infix(left, " div ", right);
       }
     );
   }
 
-  std::string to_string(formula f)
+  void printer::expand(formula f)
   {
-    using namespace std::literals;
     using namespace ::black_internal;
 
-    return f.match(
+    f.match(
       [&](proposition p) {
-        return escape(to_string(p.name()));
+        _out << escape(to_string(p.name()));
       },
       [&](atom a) {
-        std::string result = 
-          escape(to_string(a.rel().name())) + "(" + to_string(a.terms()[0]);
-        for(size_t i = 1; i < a.terms().size(); ++i) {
-          result += ", " + to_string(a.terms()[i]);
-        }
-        result += ")";
-
-        return result;
-      }, // LCOV_EXCL_LINE
-      [](equality e, auto terms) {
+        _out << escape(to_string(a.rel().name())) << "(";
+        arguments(a.terms());
+      },
+      [&](equality e, auto terms) {
         black_assert(terms.size() > 0);
 
-        if(terms.size() == 2) 
-          return fmt::format(
-            "{} {} {}", 
-            to_string(terms[0]), 
-            to_string(e.node_type(), true), 
-            to_string(terms[1])
+        if(terms.size() == 2) {
+          schedule(
+            terms[0], " ", to_string(e.node_type(), true), " ", terms[1]
           );
+          return;
+        }
         
-        std::string args = to_string(terms[0]);
-        for(size_t i = 1; i < terms.size(); ++i) 
-          args += ", " + to_string(terms[i]);
-        
-        return fmt::format("{}({})", to_string(e.node_type(), false), args);
+        _out << to_string(e.node_type(), false) << "(";
+        arguments(terms);
       },
-      [](comparison c, auto left, auto right) {
-        return fmt::format(
-          "{} {} {}", 
-          to_string(left), to_string(c.node_type()), to_string(right)
-        );
+      [&](comparison c, auto left, auto right) {
+        schedule(left, " ", to_string(c.node_type()), " ", right);
       },
-      [](quantifier q) {
-        std::string qs = q.node_type() == quantifier::type::exists ?
-          "exists " : "forall ";
-
-        bool parens = q.matrix().is<binary>();
+      [&](quantifier q) {
+        _out << (q.node_type() == quantifier::type::exists ?
+          "exists " : "forall ");
 
         for(var_decl d : q.variables()) {
-          qs += 
-            '(' + to_string(d.variable()) + " : " + to_string(d.sort()) + ") ";
+          _out << '(' << escape(to_string(d.variable().name())) << " : " 
+               << to_string(d.sort()) << ") ";
         }
+        _out << ". ";
 
-        return fmt::format("{}. {}", qs, parens_if_needed(q.matrix(), parens));
+        bool parens = 
+          !named(q.matrix()) && 
+          (q.matrix().is<binary>() || q.matrix().is<nary>());
+
+        schedule(open(parens), q.matrix(), close(parens));
       }, // LCOV_EXCL_LINE
-      [](boolean, bool b) {
-        return b ? "True" : "False";
-      },
-      [](negation n, auto arg) {
-        bool needs_parens = does_need_parens(n, arg);
-        return fmt::format("{}{}", 
-          to_string(unary::type::negation), 
-          parens_if_needed(arg, needs_parens)
+      [&](boolean, bool b) {
+        _out << (b ? "True" : "False");
+      },
+      [&](negation n, auto arg) {
+        bool parens = needs_parens(n, arg);
+        _out << to_string(unary::type::negation);
+        schedule(open(parens), arg, close(parens));
+      },
+      [&](unary u, auto arg) {
+        bool parens = needs_parens(u, arg);
+        _out << to_string(u.node_type()) << (parens ? "" : " ");
+        schedule(open(parens), arg, close(parens));
+      },
+      [&](binary b, auto left, auto right) {
+        bool l = needs_parens(b, left);
+        bool r = needs_parens(b, right);
+        schedule(
+          open(l), left, close(l), 
+          " ", to_string(b.node_type()), " ", 
+          open(r), right, close(r)
         );
       },
-      [](unary u, auto arg) {
-        bool needs_parens = does_need_parens(u, arg);
-        return fmt::format("{}{}{}",
-                            to_string(u.node_type()),
-                            needs_parens ? "" : " ",
-                            parens_if_needed(arg, needs_parens));
-      },
-      [](binary b, auto left, auto right) {
-        return
-          fmt::format("{} {} {}",
-                      parens_if_needed(left, does_need_parens(b, left)),
-                      to_string(b.node_type()),
-                      parens_if_needed(right, does_need_parens(b, right)));
+      [&](nary n, auto operands) {
+        std::string_view op = to_string(
+          n.is<big_conjunction>() ? 
+            binary::type::conjunction : binary::type::disjunction
+        );
+
+        std::vector<formula> ops;
+        for(formula arg : operands)
+          ops.push_back(arg);
+
+        for(size_t i = ops.size(); i > 0; --i) {
+          bool parens = needs_parens(n, ops[i - 1]);
+          schedule(open(parens), ops[i - 1], close(parens));
+          if(i > 1)
+            schedule(" ", op, " ");
+        }
       }
     );
   }
 
+  using node_t = std::variant<formula, term>;
+
+  static hierarchy_node const *node_of(node_t n) {
+    return std::visit([](auto h) -> hierarchy_node const * { 
+      return h.node(); 
+    }, n);
+  }
+
+  // calls `f` on the subformulas and subterms that are children of `n`
+  template<typename F>
+  static void for_each_operand(node_t n, bool quantifiers, F f) {
+    std::visit([&](auto h) {
+      if constexpr(std::is_same_v<decltype(h), formula>) {
+        if(!quantifiers && h.template is<quantifier>())
+          return;
+      }
+      for_each_direct_child(h, [&](auto child) {
+        constexpr auto H = decltype(child)::hierarchy;
+        if constexpr(
+          H == hierarchy_type::formula || H == hierarchy_type::term
+        ) {
+          f(node_t{hierarchy_type_of_t<H>{child}});
+        }
+      });
+    }, n);
+  }
+
+  //
+  // Calls `f` once on each distinct subformula and subterm of `root`, 
+  // children first, exploring the matrices of quantifiers only if
+  // `quantifiers` is true.
+  //
+  template<typename F>
+  static void for_each_node(formula root, bool quantifiers, F f) {
+    tsl::hopscotch_set<hierarchy_node const *> visited;
+    std::vector<std::pair<node_t, bool>> stack = {{root, false}};
+    while(!stack.empty()) {
+      auto [n, expanded] = stack.back();
+      if(expanded) {
+        stack.pop_back();
+        f(n);
+        continue;
+      }
+      
+      if(!visited.insert(node_of(n)).second) {
+        stack.pop_back();
+        continue;
+      }
+
+      stack.back().second = true;
+      for_each_operand(n, quantifiers, [&](node_t child) {
+        if(visited.count(node_of(child)) == 0)
+          stack.push_back({child, false});
+      });
+    }
+  }
+
+  //
+  // Subformulas and subterms of `f` worth a name when printing with
+  // `print_sharing::let`, i.e. those that are not atomic and occur more than
+  // once, ordered so that each one comes after those it contains. Each one
+  // comes with its level, i.e. the maximum number of nested shared nodes it
+  // contains, so that nodes of the same level can be bound together.
+  //
+  static std::vector<std::pair<node_t, size_t>> 
+  shared_nodes(formula f, bool quantifiers) {
+    auto is_atomic = overloaded {
+      [](formula g) { return g.is<proposition>() || g.is<boolean>(); },
+      [](term t) { return t.is<variable>() || t.is<constant>(); }
+    };
+
+    std::vector<node_t> order;
+    tsl::hopscotch_map<hierarchy_node const *, size_t> occurrences;
+    for_each_node(f, quantifiers, [&](node_t n) {
+      order.push_back(n);
+      for_each_operand(n, quantifiers, [&](node_t child) {
+        ++occurrences[node_of(child)];
+      });
+    });
+
+    auto shared = [&](node_t n) {
+      return occurrences[node_of(n)] > 1 && !std::visit(is_atomic, n);
+    };
+
+    std::vector<std::pair<node_t, size_t>> result;
+    tsl::hopscotch_map<hierarchy_node const *, size_t> levels;
+    for(node_t n : order) {
+      size_t level = 0;
+      for_each_operand(n, quantifiers, [&](node_t child) {
+        level = std::max(level, levels[node_of(child)] + shared(child));
+      });
+      levels[node_of(n)] = level;
+
+      if(shared(n))
+        result.push_back({n, level});
+    }
+
+    return result;
+  }
+
+  void print(std::ostream &out, formula f, print_sharing sharing) {
+    printer p{out};
+
+    if(sharing == print_sharing::let) {
+      // names must not clash with those of propositions and variables
+      tsl::hopscotch_set<std::string> used;
+      for_each_node(f, true, [&](node_t n) {
+        std::visit(overloaded {
+          [&](formula g) {
+            if(auto prop = g.to<proposition>(); prop)
+              used.insert(black_internal::to_string(prop->name()));
+            if(auto q = g.to<quantifier>(); q)
+              for(var_decl d : q->variables())
+                used.insert(black_internal::to_string(d.variable().name()));
+          },
+          [&](term t) {
+            if(auto x = t.to<variable>(); x)
+              used.insert(black_internal::to_string(x->name()));
+          }
+        }, n);
+      });
+
+      size_t next = 0;
+      for(auto [n, level] : shared_nodes(f, true)) {
+        std::string name;
+        do {
+          name = "_" + std::to_string(++next);
+        } while(used.count(name) > 0);
+
+        std::visit([&](auto h) {
+          out << "let " << name << " = ";
+          p.print(h);
+          out << " in ";
+          p.bind(h, name);
+        }, n);
+      }
+    }
+
+    p(f);
+  }
+
+  void print(std::ostream &out, term t) {
+    printer{out}(t);
+  }
+
+  std::string to_string(formula f, print_sharing sharing) {
+    std::ostringstream str;
+    print(str, f, sharing);
+    return str.str();
+  }
+
+  std::string to_string(formula f) {
+    return to_string(f, print_sharing::expand);
+  }
+
+  std::string to_string(term t) {
+    std::ostringstream str;
+    print(str, t);
+    return str.str();
+  }
+
   std::string to_string(symbol s) {
     return s.match(
       [](relation r) {
@@ -397,226 +672,297 @@ namespace black_internal::logic
   static inline std::string to_smtlib2(uintptr_t n) {
     return "|" + std::to_string(n) + "|";
   }
-  
-  static inline std::string to_smtlib2_inner(term t) {
-    using namespace std::literals;
-    return t.match(
-      [](constant, auto c) {
-        return c.match(
-          [](integer, auto v) {
-            return std::to_string(v);
+
+  //
+  // Printer of formulas and terms in SMT-LIB syntax. Names are hidden inside
+  // quantifiers, whose variables would capture the free variables of shared
+  // subterms bound outside (see `print_smtlib2()`).
+  //
+  class smtlib2_printer : public stack_printer<smtlib2_printer>
+  {
+  public:
+    using stack_printer::stack_printer;
+
+    void expand(term t);
+    void expand(formula f);
+
+  private:
+    // schedules ` t1 ... tn)`
+    void arguments(auto const& terms) {
+      _stack.push_back(std::string_view{")"});
+      for(size_t i = terms.size(); i > 0; --i) {
+        _stack.push_back(term{terms[i - 1]});
+        _stack.push_back(std::string_view{" "});
+      }
+    }
+
+    // prints `(op f1 ... fn)` for the chain of `E`s rooted at `e`, whose
+    // operands are the maximal subformulas that are not `E`s or are named
+    template<typename E>
+    void associative(E e, std::string_view op) {
+      std::vector<formula> ops;
+      std::vector<formula> stack = {e.right(), e.left()};
+      while(!stack.empty()) {
+        formula g = stack.back();
+        stack.pop_back();
+
+        if(auto c = g.to<E>(); c && !named(*c)) {
+          stack.push_back(c->right());
+          stack.push_back(c->left());
+        } else
+          ops.push_back(g);
+      }
+
+      _out << "(" << op;
+      _stack.push_back(std::string_view{")"});
+      for(size_t i = ops.size(); i > 0; --i) {
+        _stack.push_back(ops[i - 1]);
+        _stack.push_back(std::string_view{" "});
+      }
+    }
+  };
+
+  void smtlib2_printer::expand(term t) {
+    t.match(
+      [&](constant, auto c) {
+        c.match(
+          [&](integer, auto v) {
+            _out << std::to_string(v);
           },
-          [](real, auto v) {
-            return std::to_string(v);
+          [&](real, auto v) {
+            _out << std::to_string(v);
           }
         );
       },
-      [](variable x) {
-        return to_smtlib2(to_underlying(x.unique_id()));
+      [&](variable x) {
+        _out << to_smtlib2(to_underlying(x.unique_id()));
       },
-      [](application a) {
-        std::string s = "(" + to_smtlib2(to_underlying(a.func().unique_id()));
-
-        for(auto arg : a.terms()) {
-          s += " " + to_smtlib2_inner(arg);
-        }
-
-        s += ")";
-        return s;
-      }, // LCOV_EXCL_LINE
-      [](negative, auto arg) {
-        return fmt::format("(- {})", to_smtlib2_inner(arg));
+      [&](application a) {
+        _out << "(" << to_smtlib2(to_underlying(a.func().unique_id()));
+        arguments(a.terms());
       },
-      [](to_integer, auto arg) {
-        return fmt::format("(to_int {})", to_smtlib2_inner(arg));
+      [&](negative, auto arg) {
+        _out << "(- ";
+        schedule(arg, ")");
       },
-      [](to_real, auto arg) {
-        return fmt::format("(to_real {})", to_smtlib2_inner(arg));
+      [&](to_integer, auto arg) {
+        _out << "(to_int ";
+        schedule(arg, ")");
       },
-      [](addition, auto left, auto right) {
-        return fmt::format(
-          "(+ {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right)
-        );
+      [&](to_real, auto arg) {
+        _out << "(to_real ";
+        schedule(arg, ")");
       },
-      [](subtraction, auto left, auto right) {
-        return fmt::format(
-          "(- {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right)
-        );
+      [&](addition, auto left, auto right) {
+        _out << "(+ ";
+        schedule(left, " ", right, ")");
       },
-      [](multiplication, auto left, auto right) {
-        return fmt::format(
-          "(* {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right)
-        );
+      [&](subtraction, auto left, auto right) {
+        _out << "(- ";
+        schedule(left, " ", right, ")");
       },
-      [](division, auto left, auto right) {
-        return fmt::format(
-          "(/ {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right)
-        ); // LCOV_EXCL_LINE
+      [&](multiplication, auto left, auto right) {
+        _out << "(* ";
+        schedule(left, " ", right, ")");
       },
-      [](int_division, auto left, auto right) {
-        return fmt::format(
-          "(div {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right)
-        ); // LCOV_EXCL_LINE
+      [&](division, auto left, auto right) {
+        _out << "(/ "; // LCOV_EXCL_LINE
+        schedule(left, " ", right, ")"); // LCOV_EXCL_LINE
+      },
+      [&](int_division, auto left, auto right) {
+        _out << "(div "; // LCOV_EXCL_LINE
+        schedule(left, " ", right, ")"); // LCOV_EXCL_LINE
       }
     );
   }
 
-  static inline std::string to_smtlib2_inner(formula f) {
-    return f.match(
-      [](boolean, bool b) {
-        return b ? "true" : "false";
+  void smtlib2_printer::expand(formula f) {
+    f.match(
+      [&](boolean, bool b) {
+        _out << (b ? "true" : "false");
       },
-      [](proposition p) {
-        return to_smtlib2(to_underlying(p.unique_id()));
+      [&](proposition p) {
+        _out << to_smtlib2(to_underlying(p.unique_id()));
       },
-      [](atom a) {
-        std::string s = "(" + to_smtlib2(to_underlying(a.rel().unique_id()));
-
-        for(auto t : a.terms()) {
-          s += " " + to_smtlib2_inner(t);
-        }
-
-        s += ")";
-        return s;
-      }, // LCOV_EXCL_LINE
-      [](equality e, auto terms) {
+      [&](atom a) {
+        _out << "(" << to_smtlib2(to_underlying(a.rel().unique_id()));
+        arguments(a.terms());
+      },
+      [&](equality e, auto terms) {
         black_assert(terms.size() > 0);
 
-        std::string args = to_smtlib2_inner(terms[0]);
-        for(size_t i = 1; i < terms.size(); ++i)
-          args = " " + to_smtlib2_inner(terms[i]);
-
-        return fmt::format(
-          "({} {})", e.is<equal>() ? "=" : "distinct", args
-        );
+        _out << (e.is<equal>() ? "(=" : "(distinct");
+        arguments(terms);
       },
-      [](less_than cmp) {
-        return fmt::format(
-          "(< {} {})", 
-          to_smtlib2_inner(cmp.left()), to_smtlib2_inner(cmp.right())
-        );
-      },
-      [](less_than_equal cmp) {
-        return fmt::format(
-          "(<= {} {})", 
-          to_smtlib2_inner(cmp.left()), to_smtlib2_inner(cmp.right())
-        );
-      },
-      [](greater_than cmp) {
-        return fmt::format(
-          "(> {} {})", 
-          to_smtlib2_inner(cmp.left()), to_smtlib2_inner(cmp.right())
-        );
-      },
-      [](greater_than_equal cmp) {
-        return fmt::format(
-          "(>= {} {})", 
-          to_smtlib2_inner(cmp.left()), to_smtlib2_inner(cmp.right())
-        );
+      [&](comparison c, auto left, auto right) {
+        _out << "(" << to_string(c.node_type()) << " ";
+        schedule(left, " ", right, ")");
       },
       [&](quantifier q) {
-        std::string vars;
+        _out << (q.is<exists>() ? "(exists (" : "(forall (");
+        
+        bool first = true;
         for(auto d : q.variables()) {
-          vars += fmt::format(
-            " ({} {})", 
-            to_smtlib2(to_underlying(d.variable().unique_id())), 
-            to_string(d.sort())
-          );
+          _out << (first ? "" : " ") << "(" 
+               << to_smtlib2(to_underlying(d.variable().unique_id())) << " "
+               << to_string(d.sort()) << ")";
+          first = false;
         }
-        vars.erase(vars.begin()); 
+        _out << ") ";
 
-        return fmt::format(
-          "({} ({}) {})", 
-          q.is<exists>() ? "exists" : "forall",
-          vars, to_smtlib2_inner(q.matrix())
-        );
+        _hidden++;
+        schedule(q.matrix(), unhide{}, ")");
       },
-      [](negation, auto op) {
-        return fmt::format("(not {})", to_smtlib2_inner(op));
+      [&](negation, auto op) {
+        _out << "(not ";
+        schedule(op, ")");
       },
-      [](conjunction c) {
-        std::string ops;
-        for(auto op : operands(c))
-          ops += " " + to_smtlib2_inner(op);
-        ops.erase(ops.begin());
-
-        return fmt::format("(and {})", ops);        
+      [&](conjunction c) {
+        associative(c, "and");
       },
-      [](disjunction c) {
-        std::string ops;
-        for(auto op : operands(c))
-          ops += " " + to_smtlib2_inner(op);
-        ops.erase(ops.begin());
-
-        return fmt::format("(or {})", ops);        
+      [&](disjunction c) {
+        associative(c, "or");
+      },
+      [&](nary n, auto operands) {
+        _out << (n.is<big_conjunction>() ? "(and" : "(or");
+        
+        std::vector<formula> ops;
+        for(formula op : operands)
+          ops.push_back(op);
+        
+        _stack.push_back(std::string_view{")"});
+        for(size_t i = ops.size(); i > 0; --i) {
+          _stack.push_back(ops[i - 1]);
+          _stack.push_back(std::string_view{" "});
+        }
       },
       //
-      // We exclude these two cases from code coverage because to_smtlib2() is
+      // We exclude this case from code coverage because to_smtlib2() is
       // only usually called on the encoding formulas which never contain 
-      // implications or double implications
+      // implications
       //
-      [](implication, auto left, auto right) { // LCOV_EXCL_LINE
-        return fmt::format( // LCOV_EXCL_LINE
-          "(=> {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right) // LCOV_EXCL_LINE
-        ); // LCOV_EXCL_LINE
+      [&](implication, auto left, auto right) { // LCOV_EXCL_LINE
+        _out << "(=> "; // LCOV_EXCL_LINE
+        schedule(left, " ", right, ")"); // LCOV_EXCL_LINE
       }, // LCOV_EXCL_LINE
-      [](iff, auto left, auto right) { // LCOV_EXCL_LINE
-        return fmt::format( // LCOV_EXCL_LINE
-          "(= {} {})", to_smtlib2_inner(left), to_smtlib2_inner(right) // LCOV_EXCL_LINE
-        ); // LCOV_EXCL_LINE
-      } // LCOV_EXCL_LINE
+      [&](iff, auto left, auto right) {
+        _out << "(= ";
+        schedule(left, " ", right, ")");
+      }
     );
   }
 
-  std::string to_smtlib2(formula f, scope const& xi) {
+  //
+  // With `print_sharing::let`, each assertion binds its shared subformulas
+  // and subterms with nested `let`s, one for each level of nesting among
+  // them. Those inside quantifiers are not bound, because they may refer to
+  // the quantified variables.
+  //
+  static void print_assertion(
+    std::ostream &out, formula f, print_sharing sharing
+  ) {
+    smtlib2_printer p{out};
+    
+    out << "(assert ";
+    
+    size_t lets = 0;
+    if(sharing == print_sharing::let) {
+      auto shared = shared_nodes(f, false);
+      std::stable_sort(shared.begin(), shared.end(), [](auto a, auto b) {
+        return a.second < b.second;
+      });
+
+      for(size_t i = 0; i < shared.size(); ++lets) {
+        size_t level = shared[i].second;
+        out << "(let (";
+        for(size_t j = i; i < shared.size() && shared[i].second == level; ++i)
+        {
+          std::string name = "|_" + std::to_string(i + 1) + "|";
+          std::visit([&](auto h) {
+            out << (i == j ? "(" : " (") << name << " ";
+            p.print(h);
+            out << ")";
+            p.bind(h, name);
+          }, shared[i].first);
+        }
+        out << ") ";
+      }
+    }
+
+    p(f);
+
+    out << std::string(lets, ')') << ")";
+  }
+
+  //
+  // Symbols declared in an SMT-LIB script.
+  //
+  struct smtlib2_symbols {
     tsl::hopscotch_set<proposition> props;
     tsl::hopscotch_set<variable> vars;
     tsl::hopscotch_set<relation> rels;
     tsl::hopscotch_set<function> funs;
+  };
 
-    logic::for_each_child_deep(f, [&](auto child) {
-      child.match(
-        [&](proposition p) {
-          props.insert(p);
-        },
-        [&](variable x) {
-          vars.insert(x);
-        },
-        [&](atom a) {
-          rels.insert(a.rel());
-        },
-        [&](application a) {
-          funs.insert(a.func());
+  //
+  // Prints the declarations of the symbols of `f` that are not in `declared`
+  // yet, and adds them to it. Symbols whose sort is not known in `xi` are not
+  // declared.
+  //
+  static void print_declarations(
+    std::ostream &out, formula f, scope const& xi, smtlib2_symbols &declared
+  ) {
+    smtlib2_symbols found;
+
+    for_each_node(f, true, [&](node_t n) {
+      std::visit(overloaded {
+        [&](formula g) {
+          g.match(
+            [&](proposition p) {
+              if(!declared.props.contains(p))
+                found.props.insert(p);
+            },
+            [&](atom a) {
+              if(!declared.rels.contains(a.rel()))
+                found.rels.insert(a.rel());
+            },
+            [](otherwise) { }
+          );
         },
-        [](otherwise) { }
-      );
+        [&](term t) {
+          t.match(
+            [&](variable x) {
+              if(!declared.vars.contains(x))
+                found.vars.insert(x);
+            },
+            [&](application a) {
+              if(!declared.funs.contains(a.func()))
+                found.funs.insert(a.func());
+            },
+            [](otherwise) { }
+          );
+        }
+      }, n);
     });
 
-    std::string smtlib;
-
-    smtlib += "(set-logic ALL)\n\n";
-
-    for(auto p : props) {
-      smtlib += 
-        fmt::format(
-          "(declare-const {} Bool)\n", 
-          to_smtlib2(to_underlying(p.unique_id()))
-        );
+    for(auto p : found.props) {
+      out << "(declare-const " << to_smtlib2(to_underlying(p.unique_id())) 
+          << " Bool)\n";
+      declared.props.insert(p);
     }
     
-    for(auto x : vars) {
+    for(auto x : found.vars) {
       auto s = xi.sort(x);
       
-      if(s)
-        smtlib += 
-          fmt::format(
-            "(declare-const {} {})\n", 
-            to_smtlib2(to_underlying(x.unique_id())), 
-            to_string(*s)
-          );
+      if(!s)
+        continue;
+
+      out << "(declare-const " << to_smtlib2(to_underlying(x.unique_id())) 
+          << " " << to_string(*s) << ")\n";
+      declared.vars.insert(x);
     }
     
-    for(auto r : rels) {
+    for(auto r : found.rels) {
       std::optional<std::vector<sort>> signature = xi.signature(r);
       if(!signature)
         continue;
@@ -626,14 +972,12 @@ namespace black_internal::logic
         args += " " + to_string(signature->at(i));
       }
 
-      smtlib += fmt::format(
-        "(declare-fun {} ({}) Bool)\n", 
-        to_smtlib2(to_underlying(r.unique_id())), 
-        args
-      );
+      out << "(declare-fun " << to_smtlib2(to_underlying(r.unique_id())) 
+          << " (" << args << ") Bool)\n";
+      declared.rels.insert(r);
     }
     
-    for(auto fun : funs) {
+    for(auto fun : found.funs) {
       std::optional<std::vector<sort>> signature = xi.signature(fun);
       std::optional<sort> result = xi.sort(fun);
 
@@ -645,30 +989,100 @@ namespace black_internal::logic
         args += " " + to_string(signature->at(i));
       }
 
-      smtlib += fmt::format(
-        "(declare-fun {} ({}) {})\n", 
-        to_smtlib2(to_underlying(fun.unique_id())), 
-        args,
-        to_string(*result)
-      );
+      out << "(declare-fun " << to_smtlib2(to_underlying(fun.unique_id())) 
+          << " (" << args << ") " << to_string(*result) << ")\n";
+      declared.funs.insert(fun);
     }
+  }
+
+  void print_smtlib2(
+    std::ostream &out, formula f, scope const& xi, print_sharing sharing
+  ) {
+    smtlib2_symbols declared;
+
+    out << "(set-logic ALL)\n\n";
 
-    smtlib += "\n";
+    print_declarations(out, f, xi, declared);
+
+    out << "\n";
 
     f.match(
       [&](conjunction c) {
         for(auto op : operands(c)) {
-          smtlib += fmt::format("(assert {})\n\n", to_smtlib2_inner(op));
+          print_assertion(out, op, sharing);
+          out << "\n\n";
+        }
+      },
+      [&](big_conjunction c) {
+        for(auto op : operands(c)) {
+          print_assertion(out, op, sharing);
+          out << "\n\n";
         }
       },
       [&](otherwise) {
-        smtlib += fmt::format("(assert {})\n", to_smtlib2_inner(f));
+        print_assertion(out, f, sharing);
+        out << "\n";
       }
     );
 
-    smtlib += "(check-sat)\n";
+    out << "(check-sat)\n";
+  }
 
-    return smtlib;
+  std::string to_smtlib2(formula f, scope const& xi, print_sharing sharing) {
+    std::ostringstream str;
+    print_smtlib2(str, f, xi, sharing);
+    return str.str();
   }
-}
 
+  struct smtlib2_script::_script_t {
+    std::ostream &out;
+    print_sharing sharing;
+    smtlib2_symbols declared;
+    size_t assumptions = 0;
+  };
+
+  smtlib2_script::smtlib2_script(std::ostream &out, print_sharing sharing)
+    : _data{std::make_unique<_script_t>(out, sharing)} 
+  { 
+    _data->out << "(set-logic ALL)\n";
+  }
+
+  smtlib2_script::~smtlib2_script() = default;
+
+  void smtlib2_script::comment(std::string_view text) {
+    _data->out << "\n; " << text << "\n";
+  }
+
+  void smtlib2_script::assert_formula(formula f, scope const& xi) {
+    print_declarations(_data->out, f, xi, _data->declared);
+    print_assertion(_data->out, f, _data->sharing);
+    _data->out << "\n";
+  }
+
+  void smtlib2_script::check_sat() {
+    _data->out << "(check-sat)\n" << std::flush;
+  }
+
+  void smtlib2_script::check_sat_assuming(formula f, scope const& xi) {
+    std::ostream &out = _data->out;
+    print_declarations(out, f, xi, _data->declared);
+
+    if(auto p = f.to<proposition>(); p) {
+      out << "(check-sat-assuming (" 
+          << to_smtlib2(to_underlying(p->unique_id())) << "))\n" 
+          << std::flush;
+      return;
+    }
+
+    proposition a = f.sigma()->proposition(
+      std::pair{std::string_view{"_smtlib2_assumption"}, _data->assumptions++}
+    );
+    std::string name = to_smtlib2(to_underlying(a.unique_id()));
+
+    out << "(push 1)\n";
+    out << "(declare-const " << name << " Bool)\n";
+    print_assertion(out, iff(a, f), _data->sharing);
+    out << "\n(check-sat-assuming (" << name << "))\n";
+    out << "(pop 1)\n" << std::flush;
+  }
+}
@@ -558,6 +558,12 @@ namespace black_internal::logic {
       },
       [&](binary, auto left, auto right) {
         return type_check(left) && type_check(right);
+      },
+      [&](nary, auto operands) {
+        for(formula op : operands)
+          if(!type_check(op))
+            return false;
+        return true;
       }
     );
   }
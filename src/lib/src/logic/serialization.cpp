@@ -0,0 +1,781 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/logic/serialization.hpp>
+#include <black/logic/prettyprint.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define BLACK_SERIALIZATION_MMAP
+#endif
+
+namespace black_internal::serialization
+{
+  using namespace logic;
+
+  //
+  // Layout of the format. After the header, which is the magic number, the
+  // version, and the number of items of each of the following sections, there
+  // are:
+  // 1. the string table, where each string is a word with its length followed
+  //    by its bytes, padded to a multiple of four;
+  // 2. the names of the syntax elements used in the file, as indexes into the
+  //    string table, so that the element codes used below do not depend on
+  //    the `syntax_element` enum, which changes with the hierarchy;
+  // 3. the nodes, each made of its element code followed by its fields and
+  //    children in declaration order (see `hierarchy.hpp`);
+  // 4. the indexes of the nodes of the serialized formulas.
+  //
+  // Inside nodes, children and fields of hierarchy types are indexes of
+  // previous nodes, vectors are their size followed by the elements, integers
+  // and doubles take two words, and identifiers are made of the kind of label
+  // (see `label_types` below) followed by its value.
+  //
+  static constexpr uint32_t magic = 0x464b4c42; // "BLKF"
+  static constexpr uint32_t version = 1;
+
+  //
+  // The types of labels supported by the format. The kind of a label in the
+  // file is the index of its type in this list, so new types must be appended
+  // at the end.
+  //
+  using label_types = std::tuple<
+    std::string, int, int64_t, uint64_t, formula,
+    std::tuple<std::string_view, formula>
+  >;
+
+  inline constexpr size_t label_types_size = std::tuple_size_v<label_types>;
+
+  //
+  // `std::string_view`s in labels refer to string literals (e.g. the 
+  // `"_past_label"sv` of `remove_past()`), so when read back they must point 
+  // to storage that lives as long as the program.
+  //
+  static std::string_view intern(std::string_view s) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> pool;
+
+    std::lock_guard lock{mutex};
+    return *pool.insert(std::string{s}).first;
+  }
+
+  class writer
+  {
+  public:
+    explicit writer(error_handler error) : _error{std::move(error)} { }
+
+    bool add(formula f) {
+      std::optional<uint32_t> id = visit(f.node());
+      if(!id)
+        return false;
+      _roots.push_back(*id);
+      return true;
+    }
+
+    void write(std::ostream &out) const;
+
+  private:
+    std::optional<uint32_t> visit(hierarchy_node const *root);
+    bool emit(hierarchy_node const *node);
+    
+    uint32_t string_id(std::string_view s);
+    uint32_t element_code(syntax_element e);
+
+    void put(uint32_t w) { _nodes.push_back(w); }
+
+    void put64(uint64_t w) { 
+      put(static_cast<uint32_t>(w));
+      put(static_cast<uint32_t>(w >> 32));
+    }
+
+    bool write_value(hierarchy_node const *node) {
+      black_assert(_ids.contains(node));
+      put(_ids.at(node));
+      return true;
+    }
+
+    template<hierarchy H>
+    bool write_value(H h) {
+      return write_value(h.node());
+    }
+
+    bool write_value(bool b) { 
+      put(b);
+      return true;
+    }
+
+    template<std::integral T>
+    bool write_value(T v) {
+      put64(static_cast<uint64_t>(v));
+      return true;
+    }
+
+    bool write_value(double d) {
+      put64(std::bit_cast<uint64_t>(d));
+      return true;
+    }
+
+    bool write_value(std::string_view s) {
+      put(string_id(s));
+      return true;
+    }
+
+    bool write_value(std::string const& s) {
+      return write_value(std::string_view{s});
+    }
+
+    template<typename T>
+    bool write_value(std::vector<T> const& v) {
+      put(static_cast<uint32_t>(v.size()));
+      return std::all_of(begin(v), end(v), [&](auto const& x) {
+        return write_value(x);
+      });
+    }
+
+    template<typename ...Ts>
+    bool write_value(std::tuple<Ts...> const& t) {
+      return std::apply([&](auto const& ...v) {
+        return (write_value(v) && ...);
+      }, t);
+    }
+
+    bool write_value(domain_ref const&) {
+      _error("sort declarations with a domain cannot be serialized");
+      return false;
+    }
+
+    bool write_value(identifier const& id) {
+      bool found = [&]<size_t ...I>(std::index_sequence<I...>) {
+        return (write_label<I>(id) || ...);
+      }(std::make_index_sequence<label_types_size>{});
+
+      if(!found)
+        _error("the label `" + black_internal::to_string(id) + "` cannot be serialized");
+      return found;
+    }
+
+    template<size_t I>
+    bool write_label(identifier const& id) {
+      auto const *value = id.get<std::tuple_element_t<I, label_types>>();
+      if(!value)
+        return false;
+
+      put(static_cast<uint32_t>(I));
+      return write_value(*value);
+    }
+
+    error_handler _error;
+    std::unordered_map<hierarchy_node const *, uint32_t> _ids;
+    std::unordered_map<std::string, uint32_t> _string_ids;
+    std::vector<std::string_view> _strings;
+    std::unordered_map<syntax_element, uint32_t> _element_codes;
+    std::vector<uint32_t> _elements;
+    std::vector<uint32_t> _nodes;
+    std::vector<uint32_t> _roots;
+  };
+
+  //
+  // The nodes referenced by a field, including those inside labels.
+  //
+  static void dependencies(identifier const& id, node_list &out) {
+    id.nodes(out);
+  }
+
+  template<typename T>
+  static void dependencies(T const& value, node_list &out) {
+    trace_nodes(value, out);
+  }
+
+  static void node_dependencies(hierarchy_node const *node, node_list &out) {
+    switch(storage_of_element(node->type)) {
+      #define declare_storage_kind(Base, Storage) \
+        case storage_type::Storage: \
+          std::apply([&](auto const& ...values) { \
+            (dependencies(values, out), ...); \
+          }, \
+            static_cast< \
+              storage_node<storage_type::Storage> const * \
+            >(node)->data.values \
+          ); \
+          break;
+      #include <black/internal/logic/hierarchy.hpp>
+    }
+  }
+
+  //
+  // Depth-first visit with an explicit stack, so that deep formulas do not
+  // overflow the call stack. Nodes are emitted after their dependencies.
+  //
+  std::optional<uint32_t> writer::visit(hierarchy_node const *root) {
+    std::vector<std::pair<hierarchy_node const *, bool>> stack = {
+      {root, false}
+    };
+    while(!stack.empty()) {
+      auto [node, expanded] = stack.back();
+      if(_ids.contains(node)) {
+        stack.pop_back();
+        continue;
+      }
+
+      if(!expanded) {
+        stack.back().second = true;
+        node_list deps;
+        node_dependencies(node, deps);
+        for(auto dep : deps) // null for labels that cannot be serialized
+          if(dep && !_ids.contains(dep))
+            stack.push_back({dep, false});
+        continue;
+      }
+
+      stack.pop_back();
+      if(!emit(node))
+        return {};
+      _ids.insert({node, static_cast<uint32_t>(_ids.size())});
+    }
+
+    return _ids.at(root);
+  }
+
+  bool writer::emit(hierarchy_node const *node) {
+    put(element_code(node->type));
+
+    switch(storage_of_element(node->type)) {
+      #define declare_storage_kind(Base, Storage) \
+        case storage_type::Storage: \
+          return std::apply([&](auto const& ...values) { \
+            return (write_value(values) && ...); \
+          }, \
+            static_cast< \
+              storage_node<storage_type::Storage> const * \
+            >(node)->data.values \
+          );
+      #include <black/internal/logic/hierarchy.hpp>
+    }
+    black_unreachable(); // LCOV_EXCL_LINE
+  }
+
+  uint32_t writer::string_id(std::string_view s) {
+    auto [it, inserted] = _string_ids.insert(
+      {std::string{s}, static_cast<uint32_t>(_strings.size())}
+    );
+    if(inserted)
+      _strings.push_back(it->first);
+    return it->second;
+  }
+
+  uint32_t writer::element_code(syntax_element e) {
+    auto [it, inserted] = _element_codes.insert(
+      {e, static_cast<uint32_t>(_elements.size())}
+    );
+    if(inserted)
+      _elements.push_back(string_id(logic::to_string(e)));
+    return it->second;
+  }
+
+  //
+  // Words are written byte by byte in little-endian order, so the format does
+  // not depend on the host.
+  //
+  static void put_word(std::string &buffer, uint32_t w) {
+    buffer.push_back(static_cast<char>(w & 0xff));
+    buffer.push_back(static_cast<char>((w >> 8) & 0xff));
+    buffer.push_back(static_cast<char>((w >> 16) & 0xff));
+    buffer.push_back(static_cast<char>((w >> 24) & 0xff));
+  }
+
+  static size_t padded(size_t size) {
+    return (size + 3) & ~size_t{3};
+  }
+
+  void writer::write(std::ostream &out) const {
+    std::string buffer;
+    buffer.reserve(
+      4 * (7 + _elements.size() + _nodes.size() + _roots.size())
+    );
+
+    for(uint32_t w : {
+      magic, version, 
+      static_cast<uint32_t>(_strings.size()), 
+      static_cast<uint32_t>(_elements.size()),
+      static_cast<uint32_t>(_ids.size()), 
+      static_cast<uint32_t>(_nodes.size()), 
+      static_cast<uint32_t>(_roots.size())
+    })
+      put_word(buffer, w);
+
+    for(std::string_view s : _strings) {
+      put_word(buffer, static_cast<uint32_t>(s.size()));
+      buffer.append(s);
+      buffer.resize(padded(buffer.size()), '\0');
+    }
+
+    for(auto const& section : {_elements, _nodes, _roots})
+      for(uint32_t w : section)
+        put_word(buffer, w);
+
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  }
+
+  bool serialize(
+    std::ostream &out, std::vector<formula> const& formulas,
+    error_handler error
+  ) {
+    writer w{std::move(error)};
+    for(formula f : formulas)
+      if(!w.add(f))
+        return false;
+    
+    w.write(out);
+    return true;
+  }
+
+  bool serialize(std::ostream &out, formula f, error_handler error) {
+    return serialize(out, std::vector<formula>{f}, std::move(error));
+  }
+
+  //
+  // The type of the value read for each argument of the allocating
+  // constructors of the nodes (see `storage_alloc_args` in `core.hpp`).
+  //
+  template<typename T>
+  struct read_type : std::type_identity<T> { };
+
+  template<hierarchy_type H>
+  struct read_type<child_arg<H>> : std::type_identity<hierarchy_type_of_t<H>> 
+  { };
+
+  template<hierarchy_type H>
+  struct read_type<children_arg<H>> 
+    : std::type_identity<std::vector<hierarchy_type_of_t<H>>> { };
+
+  template<typename T>
+  using read_type_t = typename read_type<T>::type;
+
+  class reader
+  {
+  public:
+    reader(
+      alphabet &sigma, std::span<std::byte const> data, error_handler error
+    ) : _sigma{sigma}, _data{data}, _error{std::move(error)} { }
+
+    std::optional<std::vector<formula>> read();
+
+  private:
+    std::nullopt_t error(std::string const& message) {
+      if(!_failed)
+        _error(message);
+      _failed = true;
+      return std::nullopt;
+    }
+
+    size_t remaining() const { return (_data.size() - _pos) / 4; }
+
+    std::optional<uint32_t> word() {
+      if(_failed)
+        return {};
+      if(_data.size() - _pos < 4)
+        return error("unexpected end of data");
+
+      auto byte = [&](size_t i) { 
+        return std::to_integer<uint32_t>(_data[_pos + i]); 
+      };
+      uint32_t w = byte(0) | byte(1) << 8 | byte(2) << 16 | byte(3) << 24;
+      _pos += 4;
+      return w;
+    }
+
+    std::optional<uint64_t> word64() {
+      std::optional<uint32_t> low = word();
+      std::optional<uint32_t> high = word();
+      if(!low || !high)
+        return {};
+      return uint64_t{*low} | uint64_t{*high} << 32;
+    }
+
+    std::optional<uint32_t> index(size_t size, std::string_view what) {
+      std::optional<uint32_t> i = word();
+      if(i && *i >= size)
+        return error("invalid " + std::string{what} + " index");
+      return i;
+    }
+
+    bool read_strings(uint32_t count);
+    bool read_elements(uint32_t count);
+    std::optional<hierarchy_node const *> read_node();
+
+    template<syntax_element Element>
+    std::optional<hierarchy_node const *> read_element();
+
+    template<hierarchy T>
+    std::optional<T> read(std::type_identity<T>) {
+      std::optional<uint32_t> i = index(_nodes.size(), "node");
+      if(!i)
+        return {};
+      
+      hierarchy_node const *node = _nodes[*i];
+      if(hierarchy_of_storage(storage_of_element(node->type)) != T::hierarchy)
+        return error("ill-typed reference to a node");
+
+      hierarchy_type_of_t<T::hierarchy> h{&_sigma, node};
+      std::optional<T> t = h.template to<T>();
+      if(!t)
+        return error("ill-typed reference to a node");
+      return t;
+    }
+
+    std::optional<bool> read(std::type_identity<bool>) {
+      std::optional<uint32_t> w = word();
+      if(!w)
+        return {};
+      if(*w > 1)
+        return error("invalid boolean value");
+      return *w == 1;
+    }
+
+    template<std::integral T>
+    std::optional<T> read(std::type_identity<T>) {
+      std::optional<uint64_t> w = word64();
+      if(!w)
+        return {};
+      return static_cast<T>(*w);
+    }
+
+    std::optional<double> read(std::type_identity<double>) {
+      std::optional<uint64_t> w = word64();
+      if(!w)
+        return {};
+      return std::bit_cast<double>(*w);
+    }
+
+    std::optional<std::string> read(std::type_identity<std::string>) {
+      std::optional<uint32_t> i = index(_strings.size(), "string");
+      if(!i)
+        return {};
+      return std::string{_strings[*i]};
+    }
+
+    std::optional<std::string_view> read(std::type_identity<std::string_view>) 
+    {
+      std::optional<uint32_t> i = index(_strings.size(), "string");
+      if(!i)
+        return {};
+      return intern(_strings[*i]);
+    }
+
+    template<typename T>
+    std::optional<std::vector<T>> read(std::type_identity<std::vector<T>>) {
+      std::optional<uint32_t> size = word();
+      if(!size)
+        return {};
+      if(*size > remaining())
+        return error("invalid vector size");
+
+      std::vector<T> v;
+      v.reserve(*size);
+      for(uint32_t i = 0; i < *size; ++i) {
+        std::optional<T> x = read(std::type_identity<T>{});
+        if(!x)
+          return {};
+        v.push_back(std::move(*x));
+      }
+      return v;
+    }
+
+    template<typename ...Ts>
+    std::optional<std::tuple<Ts...>> 
+    read(std::type_identity<std::tuple<Ts...>>) {
+      std::tuple<std::optional<Ts>...> values;
+      bool ok = std::apply([&](auto& ...v) {
+        return ((v = read(std::type_identity<Ts>{}), v.has_value()) && ...);
+      }, values);
+      
+      if(!ok)
+        return {};
+      return std::apply([](auto& ...v) {
+        return std::tuple<Ts...>{std::move(*v)...};
+      }, values);
+    }
+
+    std::optional<domain_ref> read(std::type_identity<domain_ref>) {
+      return error("sort declarations with a domain cannot be serialized");
+    }
+
+    std::optional<identifier> read(std::type_identity<identifier>) {
+      std::optional<uint32_t> kind = index(label_types_size, "label kind");
+      if(!kind)
+        return {};
+
+      std::optional<identifier> id;
+      [&]<size_t ...I>(std::index_sequence<I...>) {
+        ((*kind == I ? (id = read_label<I>(), true) : false) || ...);
+      }(std::make_index_sequence<label_types_size>{});
+      return id;
+    }
+
+    template<size_t I>
+    std::optional<identifier> read_label() {
+      using T = std::tuple_element_t<I, label_types>;
+      std::optional<T> value = read(std::type_identity<T>{});
+      if(!value)
+        return {};
+      return identifier{std::move(*value)};
+    }
+
+    alphabet &_sigma;
+    std::span<std::byte const> _data;
+    error_handler _error;
+    size_t _pos = 0;
+    bool _failed = false;
+    std::vector<std::string_view> _strings;
+    std::vector<syntax_element> _elements;
+    std::vector<hierarchy_node const *> _nodes;
+  };
+
+  bool reader::read_strings(uint32_t count) {
+    _strings.reserve(std::min<size_t>(count, remaining()));
+    for(uint32_t i = 0; i < count; ++i) {
+      std::optional<uint32_t> size = word();
+      if(!size)
+        return false;
+      if(padded(*size) > _data.size() - _pos) {
+        error("unexpected end of data");
+        return false;
+      }
+
+      _strings.push_back({
+        reinterpret_cast<char const *>(_data.data() + _pos), *size
+      });
+      _pos += padded(*size);
+    }
+    return true;
+  }
+
+  bool reader::read_elements(uint32_t count) {
+    std::unordered_map<std::string_view, syntax_element> names;
+    for(size_t e = 0; e < syntax_element_enum_size(); ++e) {
+      auto element = static_cast<syntax_element>(e);
+      names.insert({logic::to_string(element), element});
+    }
+
+    for(uint32_t i = 0; i < count; ++i) {
+      std::optional<uint32_t> name = index(_strings.size(), "string");
+      if(!name)
+        return false;
+      
+      auto it = names.find(_strings[*name]);
+      if(it == names.end()) {
+        error("unknown syntax element `" + std::string{_strings[*name]} + "`");
+        return false;
+      }
+      _elements.push_back(it->second);
+    }
+    return true;
+  }
+
+  std::optional<hierarchy_node const *> reader::read_node() {
+    std::optional<uint32_t> code = index(_elements.size(), "element");
+    if(!code)
+      return {};
+
+    switch(_elements[*code]) {
+      #define declare_leaf_storage_kind(Base, Storage) \
+        case syntax_element::Storage: \
+          return read_element<syntax_element::Storage>();
+      #define has_no_hierarchy_elements(Base, Storage) \
+        case syntax_element::Storage: \
+          return read_element<syntax_element::Storage>();
+      #define declare_hierarchy_element(Base, Storage, Element) \
+        case syntax_element::Element: \
+          return read_element<syntax_element::Element>();
+      #include <black/internal/logic/hierarchy.hpp>
+    }
+    black_unreachable(); // LCOV_EXCL_LINE
+  }
+
+  //
+  // The node is built reading the arguments of its allocating constructor
+  // (see `storage_alloc_args`), which are in the same order as the fields
+  // written by the writer. Leaf elements are allocated by the alphabet.
+  //
+  template<syntax_element Element>
+  std::optional<hierarchy_node const *> reader::read_element() {
+    constexpr storage_type storage = storage_of_element(Element);
+
+    return [&]<typename ...Args>(std::type_identity<std::tuple<Args...>>)
+      -> std::optional<hierarchy_node const *>
+    {
+      using args_t = std::tuple<read_type_t<Args>...>;
+      std::optional<args_t> args = read(std::type_identity<args_t>{});
+      if(!args)
+        return {};
+
+      bool empty = std::apply([](auto const& ...v) {
+        return ([&]{
+          if constexpr(is_children_arg_v<Args>)
+            return v.empty();
+          else
+            return false;
+        }() || ...);
+      }, *args);
+      if(empty)
+        return error("empty list of children");
+
+      return std::apply([&](auto& ...v) {
+        if constexpr(storage_has_children(storage))
+          return element_type_of_t<Element>(std::move(v)...).node();
+        else {
+          using ctor_t = alphabet_ctor_base<Element, alphabet_base>;
+          alphabet_base &base = _sigma;
+          return static_cast<ctor_t &>(base).construct(std::move(v)...).node();
+        }
+      }, *args);
+    }(std::type_identity<storage_alloc_args_t<storage>>{});
+  }
+
+  std::optional<std::vector<formula>> reader::read() {
+    std::optional<uint32_t> m = word();
+    if(!m)
+      return {};
+    if(*m != magic)
+      return error("not a serialized formula");
+
+    std::optional<uint32_t> v = word();
+    if(!v)
+      return {};
+    if(*v != version)
+      return error("unsupported format version " + std::to_string(*v));
+
+    uint32_t counts[5];
+    for(uint32_t &count : counts) {
+      std::optional<uint32_t> w = word();
+      if(!w)
+        return {};
+      count = *w;
+    }
+    auto [strings, elements, nodes, node_words, roots] = counts;
+
+    if(!read_strings(strings) || !read_elements(elements))
+      return {};
+
+    if(node_words > remaining())
+      return error("unexpected end of data");
+    size_t nodes_end = _pos + size_t{node_words} * 4;
+
+    _nodes.reserve(std::min<size_t>(nodes, node_words));
+    for(uint32_t i = 0; i < nodes; ++i) {
+      std::optional<hierarchy_node const *> node = read_node();
+      if(!node)
+        return {};
+      _nodes.push_back(*node);
+    }
+    if(_pos != nodes_end)
+      return error("malformed node section");
+
+    std::vector<formula> result;
+    for(uint32_t i = 0; i < roots; ++i) {
+      std::optional<formula> f = read(std::type_identity<formula>{});
+      if(!f)
+        return {};
+      result.push_back(*f);
+    }
+    if(_pos != _data.size())
+      return error("trailing data after the end of the formulas");
+
+    return result;
+  }
+
+  std::optional<std::vector<formula>>
+  deserialize(
+    alphabet &sigma, std::span<std::byte const> data, error_handler error
+  ) {
+    return reader{sigma, data, std::move(error)}.read();
+  }
+
+  std::optional<std::vector<formula>>
+  load_formulas(
+    alphabet &sigma, std::string const& path, error_handler error
+  ) {
+    auto fail = [&](std::string const& what) {
+      error("unable to read `" + path + "`: " + what);
+      return std::nullopt;
+    };
+
+  #ifdef BLACK_SERIALIZATION_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+      return fail(std::strerror(errno));
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0) {
+      int err = errno;
+      ::close(fd);
+      return fail(std::strerror(err));
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if(size == 0) {
+      ::close(fd);
+      return deserialize(sigma, {}, std::move(error));
+    }
+
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if(map == MAP_FAILED)
+      return fail(std::strerror(err));
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    auto result = deserialize(
+      sigma, {static_cast<std::byte const *>(map), size}, std::move(error)
+    );
+    ::munmap(map, size);
+    return result;
+  #else
+    std::ifstream in{path, std::ios::binary};
+    if(!in)
+      return fail("cannot open the file");
+
+    std::vector<char> buffer{
+      std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}
+    };
+    return deserialize(sigma, std::as_bytes(std::span{buffer}), error);
+  #endif
+  }
+}
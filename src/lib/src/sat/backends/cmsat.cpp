@@ -52,12 +52,19 @@ namespace black_internal::cmsat
   }
   
   void cmsat::assert_clause(dimacs::clause cl) {
+    assert_clauses({&cl, 1});
+  }
+
+  void cmsat::assert_clauses(std::span<dimacs::clause const> cls) {
     std::vector<CMSat::Lit> lits;
-    for(dimacs::literal lit : cl.literals) {
-      lits.push_back(CMSat::Lit{lit.var, !lit.sign});
-    }
+    for(dimacs::clause const& cl : cls) {
+      lits.clear();
+      for(dimacs::literal lit : cl.literals) {
+        lits.push_back(CMSat::Lit{lit.var, !lit.sign});
+      }
 
-    _data->solver->add_clause(lits);
+      _data->solver->add_clause(lits);
+    }
   }
 
   tribool cmsat::is_sat() {
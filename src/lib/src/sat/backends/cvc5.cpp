@@ -160,6 +160,18 @@ namespace black_internal::cvc5
 
   void cvc5::clear() {
     _data->solver.resetAssertions();
+    _data->props.clear();
+    _data->sat_response = false;
+  }
+
+  //
+  // The term manager and the solver, with its options, are kept, while
+  // everything cached in the old scope is dropped with it.
+  //
+  void cvc5::reset(class scope const& xi) {
+    clear();
+    _data->global_xi = logic::scope{chain(xi)};
+    _data->xi = logic::scope{chain(_data->global_xi)};
   }
 
   void cvc5::interrupt() { }
@@ -293,6 +305,20 @@ namespace black_internal::cvc5
 
         return mgr.mkTerm(cvc::Kind::OR, args);
       },
+      [&](big_conjunction c) { // LCOV_EXCL_LINE
+        std::vector<cvc::Term> args;
+        for(formula op : operands(c))
+          args.push_back(to_cvc5(op));
+
+        return mgr.mkTerm(cvc::Kind::AND, args);
+      },
+      [&](big_disjunction c) { // LCOV_EXCL_LINE
+        std::vector<cvc::Term> args;
+        for(formula op : operands(c))
+          args.push_back(to_cvc5(op));
+
+        return mgr.mkTerm(cvc::Kind::OR, args);
+      },
       [&](implication, formula left, formula right) { // LCOV_EXCL_LINE
         return 
           mgr.mkTerm(cvc::Kind::IMPLIES,{to_cvc5(left), to_cvc5(right)});
@@ -38,19 +38,26 @@ BLACK_REGISTER_SAT_BACKEND(mathsat, {black::sat::feature::smt})
 
 namespace black_internal::mathsat
 {
+  inline proposition fresh(formula f) {
+    return f.sigma()->proposition(f);
+  }
+
   struct mathsat::_mathsat_t {
     scope xi;
 
     _mathsat_t(scope const& _xi) : xi{chain(_xi)} { }
 
+    msat_config cfg;
     msat_env env;
-    tsl::hopscotch_map<formula, msat_term> formulas;
-    tsl::hopscotch_map<term, msat_term> terms;
+    tsl::hopscotch_map<compact<formula>, msat_term> formulas;
+    tsl::hopscotch_map<compact<term>, msat_term> terms;
     tsl::hopscotch_map<function, msat_decl> functions;
     tsl::hopscotch_map<relation, msat_decl> relations;
     tsl::hopscotch_map<term, msat_decl> variables;
+    tsl::hopscotch_map<formula, msat_term> assumptions;
     std::optional<msat_model> model;
 
+    msat_term to_assumption(formula);
     msat_term to_mathsat(formula);
     msat_term to_mathsat_inner(formula);
     msat_term to_mathsat(term);
@@ -60,19 +67,22 @@ namespace black_internal::mathsat
     msat_decl to_mathsat(relation);
     msat_decl to_mathsat(variable);
 
+    // the model belongs to the environment, so it goes first
     ~_mathsat_t() {
       if(model)
         msat_destroy_model(*model);
+      msat_destroy_env(env);
+      msat_destroy_config(cfg);
     }
   };
 
   mathsat::mathsat(scope const&xi) : _data{std::make_unique<_mathsat_t>(xi)}
   {  
-    msat_config cfg = msat_create_config();
-    msat_set_option(cfg, "model_generation", "true");
-    msat_set_option(cfg, "unsat_core_generation","3");
+    _data->cfg = msat_create_config();
+    msat_set_option(_data->cfg, "model_generation", "true");
+    msat_set_option(_data->cfg, "unsat_core_generation","3");
     
-    _data->env = msat_create_env(cfg);
+    _data->env = msat_create_env(_data->cfg);
   }
 
   mathsat::~mathsat() { }
@@ -99,10 +109,9 @@ namespace black_internal::mathsat
 
   tribool mathsat::is_sat_with(formula f) 
   {
-    msat_push_backtrack_point(_data->env);
-  
-    assert_formula(f);
-    msat_result res = msat_solve(_data->env);
+    msat_term assumption = _data->to_assumption(f);
+    msat_result res = 
+      msat_solve_with_assumptions(_data->env, &assumption, 1);
 
     if(res == MSAT_SAT) {
       if(_data->model)
@@ -112,7 +121,6 @@ namespace black_internal::mathsat
       black_assert(!MSAT_ERROR_MODEL(*_data->model));
     }
   
-    msat_pop_backtrack_point(_data->env);
     return res == MSAT_SAT ? tribool{true} :
            res == MSAT_UNSAT ? tribool{false} :
            tribool::undef; // LCOV_EXCL_LINE
@@ -183,10 +191,58 @@ namespace black_internal::mathsat
 
   void mathsat::clear() {
     msat_reset_env(_data->env);
+    _data->assumptions.clear();
+  }
+
+  //
+  // MathSAT refuses to redeclare a symbol name with a different type, and
+  // names come from unique ids that a new alphabet may reuse, so a real reset
+  // needs a fresh environment. The configuration is kept.
+  //
+  void mathsat::reset(scope const& xi) {
+    if(_data->model)
+      msat_destroy_model(*_data->model);
+    _data->model.reset();
+
+    msat_destroy_env(_data->env);
+    _data->env = msat_create_env(_data->cfg);
+
+    _data->formulas.clear();
+    _data->terms.clear();
+    _data->functions.clear();
+    _data->relations.clear();
+    _data->variables.clear();
+    _data->assumptions.clear();
+    _data->xi = scope{chain(xi)};
   }
   
   void mathsat::interrupt() { }
 
+  //
+  // Assumptions are passed to msat_solve_with_assumptions() as indicator
+  // literals defined once and for all by `fresh(f) <-> f`, so that no
+  // backtrack point is needed and the solver keeps what it learnt across
+  // calls. Indicators are cached until the next clear(). Propositions are
+  // literals already and are used directly.
+  //
+  msat_term mathsat::_mathsat_t::to_assumption(formula f) 
+  {
+    if(auto it = assumptions.find(f); it != assumptions.end())
+      return it->second;
+
+    msat_term literal;
+    if(f.is<proposition>())
+      literal = to_mathsat(f);
+    else {
+      proposition indicator = fresh(f);
+      msat_assert_formula(env, to_mathsat(iff(indicator, f)));
+      literal = to_mathsat(indicator);
+    }
+    assumptions.insert({f, literal});
+
+    return literal;
+  }
+
   msat_term mathsat::_mathsat_t::to_mathsat(formula f) 
   {
     if(auto it = formulas.find(f); it != formulas.end()) 
@@ -278,6 +334,22 @@ namespace black_internal::mathsat
 
         return acc;
       },
+      [this](big_conjunction c) { // LCOV_EXCL_LINE
+        msat_term acc = msat_make_true(env);
+
+        for(formula op : operands(c))
+          acc = msat_make_and(env, acc, to_mathsat(op));
+
+        return acc;
+      },
+      [this](big_disjunction c) { // LCOV_EXCL_LINE
+        msat_term acc = msat_make_false(env);
+
+        for(formula op : operands(c))
+          acc = msat_make_or(env, acc, to_mathsat(op));
+
+        return acc;
+      },
       [this](implication t) { // LCOV_EXCL_LINE
         return
           msat_make_or(env,
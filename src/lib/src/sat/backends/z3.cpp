@@ -32,6 +32,7 @@
 #include <z3.h>
 #include <tsl/hopscotch_map.h>
 
+#include <atomic>
 #include <limits>
 #include <optional>
 #include <string>
@@ -71,7 +72,28 @@ namespace black_internal::z3
     std::optional<Z3_model> model;
     bool solver_upgraded = false;
 
-    tsl::hopscotch_map<proposition, Z3_ast> props;
+    // interrupt() calls not yet consumed by a check (see result())
+    std::atomic<bool> interrupted = false;
+
+    // the assumptions found in the unsat core by the last is_sat_assuming()
+    std::vector<formula> unsat_assumptions;
+
+    //
+    // Translations of formulas and terms are cached until the next clear(),
+    // so that the subformulas shared among the encodings of successive bounds
+    // are only translated once. Subformulas found inside quantifiers are not
+    // cached, because the translation of their variables depends on the 
+    // enclosing binders (see `quantifier_depth`).
+    //
+    // The context is made by Z3_mk_context(), not Z3_mk_context_rc(), so Z3
+    // keeps every AST alive until the context is deleted, cached or not, and
+    // the Z3_inc_ref()/Z3_dec_ref() calls on the cached ASTs would only matter
+    // if the context became reference-counted. This is why the pool of 
+    // backend instances limits how many times a context is reused.
+    //
+    tsl::hopscotch_map<compact<formula>, Z3_ast> formulas;
+    tsl::hopscotch_map<compact<term>, Z3_ast> terms;
+    size_t quantifier_depth = 0;
 
     Z3_func_decl to_z3(function);
     Z3_func_decl to_z3(relation);
@@ -82,7 +104,11 @@ namespace black_internal::z3
     Z3_ast to_z3_inner(formula);
     Z3_ast to_z3_inner(term);
 
+    // updates the model after a check and converts its result
+    tribool result(Z3_lbool res);
+
     void upgrade_solver();
+    void release();
   };
 
 
@@ -154,6 +180,7 @@ namespace black_internal::z3
   }
 
   z3::~z3() {
+    _data->release();
     Z3_solver_dec_ref(_data->context, _data->solver);
     Z3_del_context(_data->context);
   }
@@ -165,47 +192,87 @@ namespace black_internal::z3
 
     Z3_solver_assert(_data->context, _data->solver, ast);
   }
+
+  void z3::assert_formulas(std::span<formula const> fs) {
+    // as above, everything is translated before asserting anything because
+    // the translation might replace _data->solver
+    std::vector<Z3_ast> asts;
+    asts.reserve(fs.size());
+    for(formula f : fs)
+      asts.push_back(_data->to_z3(f));
+
+    for(Z3_ast ast : asts)
+      Z3_solver_assert(_data->context, _data->solver, ast);
+  }
   
   tribool z3::is_sat_with(formula f) {
     Z3_ast asmptn = _data->to_z3(f);
     
+    if(_data->interrupted.exchange(false))
+      return tribool::undef;
+
     Z3_lbool res = 
       Z3_solver_check_assumptions(_data->context, _data->solver, 1, &asmptn);
 
-    if(res == Z3_L_TRUE) {
-      if(_data->model)
-        Z3_model_dec_ref(_data->context, *_data->model);
-      
-      _data->model = Z3_solver_get_model(_data->context, _data->solver);
+    return _data->result(res);
+  }
+
+  tribool z3::is_sat_assuming(std::span<formula const> assumptions) {
+    // as in assert_formulas(), everything is translated before checking
+    tsl::hopscotch_map<Z3_ast, formula> asmptns;
+    std::vector<Z3_ast> asts;
+    asts.reserve(assumptions.size());
+    for(formula f : assumptions) {
+      Z3_ast ast = _data->to_z3(f);
+      asts.push_back(ast);
+      asmptns.insert({ast, f});
+    }
+
+    _data->unsat_assumptions.clear();
+    if(_data->interrupted.exchange(false))
+      return tribool::undef;
+
+    Z3_lbool res = Z3_solver_check_assumptions(
+      _data->context, _data->solver, unsigned(asts.size()), asts.data()
+    );
+
+    if(res == Z3_L_FALSE) {
+      Z3_ast_vector core = 
+        Z3_solver_get_unsat_core(_data->context, _data->solver);
+      Z3_ast_vector_inc_ref(_data->context, core);
+
+      unsigned size = Z3_ast_vector_size(_data->context, core);
+      for(unsigned i = 0; i < size; ++i) {
+        Z3_ast ast = Z3_ast_vector_get(_data->context, core, i);
+        if(auto it = asmptns.find(ast); it != asmptns.end())
+          _data->unsat_assumptions.push_back(it->second);
+      }
+
+      Z3_ast_vector_dec_ref(_data->context, core);
     }
 
-    return res == Z3_L_TRUE ? tribool{true} :
-           res == Z3_L_FALSE ? tribool{false} :
-           tribool::undef;
+    return _data->result(res);
+  }
+
+  std::vector<formula> z3::unsat_assumptions() const {
+    return _data->unsat_assumptions;
   }
 
   tribool z3::is_sat() {
-    Z3_lbool res = Z3_solver_check(_data->context, _data->solver);
+    if(_data->interrupted.exchange(false))
+      return tribool::undef;
 
-    if(res == Z3_L_TRUE) {
-      if(_data->model)
-        Z3_model_dec_ref(_data->context, *_data->model);
-      
-      _data->model = Z3_solver_get_model(_data->context, _data->solver);
-      Z3_model_inc_ref(_data->context, *_data->model);
-    }
+    Z3_lbool res = Z3_solver_check(_data->context, _data->solver);
 
-    return res == Z3_L_TRUE ? tribool{true} :
-           res == Z3_L_FALSE ? tribool{false} :
-           tribool::undef;
+    return _data->result(res);
   }
 
   tribool z3::value(proposition a) const {
     if(!_data->model)
       return tribool::undef;
     
-    auto it = _data->props.find(a);
-    if(it == _data->props.end())
+    auto it = _data->formulas.find(a);
+    if(it == _data->formulas.end())
       return tribool::undef;
     
     Z3_ast term = it->second;
@@ -288,14 +355,75 @@ namespace black_internal::z3
     return result;
   }
 
+  //
+  // A real reset: the translation caches and the model are released and the
+  // solver starts over from scratch, but the context (which is the expensive
+  // part to create) is kept.
+  //
   void z3::clear() { 
-    Z3_solver_reset(_data->context, _data->solver);
+    _data->release();
+    _data->interrupted = false;
+
+    if(_data->solver_upgraded) {
+      Z3_solver_dec_ref(_data->context, _data->solver);
+      _data->solver = Z3_mk_solver(_data->context);
+      Z3_solver_inc_ref(_data->context, _data->solver);
+      _data->solver_upgraded = false;
+    } else {
+      Z3_solver_reset(_data->context, _data->solver);
+    }
+  }
+
+  void z3::reset(class scope const& xi) {
+    clear();
+    _data->global_xi = logic::scope{chain(xi)};
+    _data->xi = logic::scope{chain(_data->global_xi)};
   }
 
   void z3::interrupt() {
+    _data->interrupted = true;
     Z3_interrupt(_data->context);
   }
 
+  tribool z3::_z3_t::result(Z3_lbool res) {
+    //
+    // Z3_interrupt() has no effect on an idle context, so an interrupt() that
+    // comes when no check is running is kept pending and cancels the next
+    // check before it starts. One that comes while the check is running is
+    // consumed here instead, whatever the result. It can also cancel the
+    // construction of the model, which is then missing, so in that case the
+    // model is not fetched and the check counts as cancelled.
+    //
+    bool cancelled = interrupted.exchange(false);
+
+    if(res != Z3_L_TRUE)
+      return res == Z3_L_FALSE ? tribool{false} : tribool::undef;
+
+    if(cancelled)
+      return tribool::undef;
+
+    if(model)
+      Z3_model_dec_ref(context, *model);
+    model = Z3_solver_get_model(context, solver);
+    Z3_model_inc_ref(context, *model);
+    
+    return true;
+  }
+
+  void z3::_z3_t::release() {
+    for(auto [f, ast] : formulas)
+      Z3_dec_ref(context, ast);
+    for(auto [t, ast] : terms)
+      Z3_dec_ref(context, ast);
+    formulas.clear();
+    terms.clear();
+
+    if(model)
+      Z3_model_dec_ref(context, *model);
+    model.reset();
+    unsat_assumptions.clear();
+  }
+
   void z3::_z3_t::upgrade_solver() {
     // gcov false negative
     if(solver_upgraded)
@@ -431,7 +559,37 @@ namespace black_internal::z3
     return Z3_mk_const(context, symbol, s);
   }
 
-  Z3_ast z3::_z3_t::to_z3(formula f) 
+  Z3_ast z3::_z3_t::to_z3(formula f) {
+    // propositions do not depend on the enclosing quantifiers, so they can be
+    // cached anywhere
+    if(quantifier_depth > 0 && !f.is<proposition>())
+      return to_z3_inner(f);
+
+    if(auto it = formulas.find(f); it != formulas.end())
+      return it->second;
+
+    Z3_ast result = to_z3_inner(f);
+    Z3_inc_ref(context, result);
+    formulas.insert({f, result});
+
+    return result;
+  }
+
+  Z3_ast z3::_z3_t::to_z3(term t) {
+    if(quantifier_depth > 0)
+      return to_z3_inner(t);
+
+    if(auto it = terms.find(t); it != terms.end())
+      return it->second;
+
+    Z3_ast result = to_z3_inner(t);
+    Z3_inc_ref(context, result);
+    terms.insert({t, result});
+
+    return result;
+  }
+
+  Z3_ast z3::_z3_t::to_z3_inner(formula f) 
   {
     return f.match(
       [&](boolean b) {
@@ -489,6 +647,7 @@ namespace black_internal::z3
           upgrade_solver();
         
         nest_scope_t nest{xi};
+        quantifier_depth++;
 
         std::vector<Z3_app> z3_apps;
 
@@ -504,20 +663,15 @@ namespace black_internal::z3
           z3_apps.data(), 0, nullptr, to_z3(q.matrix())
         );
 
+        quantifier_depth--;
         return result;
       },
       [&](proposition p) {
-        if(auto it = props.find(p); it != props.end())
-          return it->second;
-
         Z3_sort sort = Z3_mk_bool_sort(context);
         Z3_symbol symbol = 
           Z3_mk_string_symbol(context, to_string(p.unique_id()).c_str());
         
-        Z3_ast result = Z3_mk_const(context, symbol, sort);
-        props.insert({p, result});
-
-        return result;
+        return Z3_mk_const(context, symbol, sort);
       },
       [&](negation, auto arg) {
         return Z3_mk_not(context, to_z3(arg));
@@ -542,6 +696,26 @@ namespace black_internal::z3
         return Z3_mk_or(context, 
           static_cast<unsigned int>(args.size()), args.data());
       }, // LCOV_EXCL_LINE
+      [&](big_conjunction c) {
+        std::vector<Z3_ast> args;
+        for(formula op : operands(c))
+          args.push_back(to_z3(op));
+        
+        black_assert(args.size() <= std::numeric_limits<unsigned int>::max());
+
+        return Z3_mk_and(context, 
+          static_cast<unsigned int>(args.size()), args.data());
+      }, // LCOV_EXCL_LINE
+      [&](big_disjunction c) {
+        std::vector<Z3_ast> args;
+        for(formula op : operands(c))
+          args.push_back(to_z3(op));
+        
+        black_assert(args.size() <= std::numeric_limits<unsigned int>::max());
+
+        return Z3_mk_or(context, 
+          static_cast<unsigned int>(args.size()), args.data());
+      }, // LCOV_EXCL_LINE
       [&](implication, auto left, auto right) {
         return Z3_mk_implies(context, to_z3(left), to_z3(right));
       },
@@ -551,7 +725,7 @@ namespace black_internal::z3
     );
   }
 
-  Z3_ast z3::_z3_t::to_z3(term t) {
+  Z3_ast z3::_z3_t::to_z3_inner(term t) {
     return t.match(
       [&](constant, auto n) {
         return n.match(
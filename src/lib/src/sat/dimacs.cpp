@@ -55,32 +55,40 @@ namespace black_internal::dimacs
 
   void solver::assert_formula(formula f) 
   {
-    // conversion of the formula to CNF
-    cnf::cnf c = cnf::to_cnf(f);
+    this->assert_formulas({&f, 1});
+  }
+
+  void solver::assert_formulas(std::span<formula const> fs)
+  {
+    // conversion of the whole batch to CNF at once, so that subformulas
+    // shared by different formulas are defined only once
+    cnf::cnf c = cnf::to_cnf(fs);
 
     // census of new variables
     size_t old_size = _data->vars.size();
-    for(black::clause cl : c.clauses) {
+    for(black::clause const& cl : c.clauses) {
       for(black::literal lit : cl.literals) {
         _data->var(lit.prop);
       }
     }
     
-    // allocate the new variables
+    // allocate the new variables all at once
     size_t new_size = _data->vars.size();
     if(new_size > old_size)
       this->new_vars(new_size - old_size);
 
-    // assert the clauses
-    for(black::clause cl : c.clauses) {
-      dimacs::clause dcl;
+    // translate and assert the clauses in a single batch
+    std::vector<dimacs::clause> dcls;
+    dcls.reserve(c.clauses.size());
+    for(black::clause const& cl : c.clauses) {
+      dimacs::clause &dcl = dcls.emplace_back();
+      dcl.literals.reserve(cl.literals.size());
       for(black::literal lit : cl.literals) {
         dcl.literals.push_back({ lit.sign, _data->var(lit.prop) });
       }
-
-      // assert the clause
-      this->assert_clause(dcl);
     }
+
+    this->assert_clauses(dcls);
   }
 
   // TODO: optimize corner cases (e.g. if assumption is already a literal)
@@ -115,6 +123,10 @@ namespace black_internal::dimacs
     return tribool::undef; // LCOV_EXCL_LINE
   }
 
+  void solver::reset(scope const&) {
+    this->clear();
+  }
+
   void solver::clear_vars() {
     _data = std::make_unique<_solver_t>();
   }
@@ -40,6 +40,29 @@ namespace black::sat
         >;
       
       std::unique_ptr<backends_map> _backends = nullptr;
+
+      //
+      // Pool of idle backend instances, one for each thread. 
+      // Instances are not reused forever because some backends (e.g. Z3) do
+      // not release the memory of what has been created inside a context
+      // until the context itself is destroyed.
+      //
+      constexpr size_t max_idle_instances = 4;
+      constexpr size_t max_instance_uses = 32;
+
+      struct pool_t {
+        tsl::hopscotch_map<
+          std::string_view, std::vector<std::unique_ptr<solver>>
+        > idle;
+
+        ~pool_t() { destroyed = true; }
+
+        // instances given back after the destruction of the pool at thread 
+        // exit are simply destroyed
+        static inline thread_local bool destroyed = false;
+      };
+
+      thread_local pool_t _pool;
     }
     
     backend_init_hook::backend_init_hook(
@@ -67,8 +90,49 @@ namespace black::sat
     auto it = _backends->find(name); 
     
     black_assert(it != _backends->end());
+
+    std::unique_ptr<solver> s;
+    if(std::vector<std::unique_ptr<solver>> &idle = _pool.idle[it->first]; 
+       !idle.empty()) 
+    {
+      s = std::move(idle.back());
+      idle.pop_back();
+      s->reset(xi);
+    } else {
+      s = (it->second.first)(xi);
+      s->_backend = it->first;
+    }
     
-    return (it->second.first)(xi);
+    s->_uses++;
+    return s;
+  }
+
+  void solver::recycle(std::unique_ptr<solver> s) {
+    using namespace black::sat::internal;
+
+    if(!s || pool_t::destroyed || s->_uses >= max_instance_uses)
+      return;
+
+    std::vector<std::unique_ptr<solver>> &idle = _pool.idle[s->_backend];
+    if(idle.size() >= max_idle_instances)
+      return;
+    
+    s->clear();
+    s->_assumptions.clear();
+    idle.push_back(std::move(s));
+  }
+
+  tribool solver::is_sat_assuming(std::span<formula const> assumptions) {
+    _assumptions.assign(assumptions.begin(), assumptions.end());
+    if(assumptions.empty())
+      return is_sat();
+
+    alphabet &sigma = *assumptions.front().sigma();
+    return is_sat_with(big_and(sigma, assumptions));
+  }
+
+  std::vector<formula> solver::unsat_assumptions() const {
+    return _assumptions;
   }
 
   bool solver::backend_has_feature(std::string_view name, feature f)
@@ -23,14 +23,23 @@
 
 #include <black/solver/core.hpp>
 
+#include <black/support/config.hpp>
 #include <black/support/common.hpp>
 #include <black/logic/logic.hpp>
 #include <black/logic/prettyprint.hpp>
-#include <black/solver/solver.hpp>
+#include <black/solver/encoding.hpp>
+#include <black/sat/solver.hpp>
 
 #include <tsl/hopscotch_map.h>
 #include <tsl/hopscotch_set.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 namespace black_internal::core {
 
   struct K_data_t {
@@ -40,7 +49,7 @@ namespace black_internal::core {
 
   static size_t traverse_impl(
     formula f, tsl::hopscotch_map<formula, K_data_t> &ks, 
-    size_t &next_placeholder
+    std::vector<formula> &order, size_t &next_placeholder
   ) {
     return f.match(
       [](boolean) -> size_t { return 1; },
@@ -53,8 +62,10 @@ namespace black_internal::core {
       },
       [&](unary, formula arg) -> size_t {
         K_data_t data = ks.find(f) != ks.end() ? ks[f] : K_data_t{0, 0};
-        if(data.size == 0)
-          data.size = 1 + traverse_impl(arg, ks, next_placeholder);
+        if(data.size == 0) {
+          data.size = 1 + traverse_impl(arg, ks, order, next_placeholder);
+          order.push_back(f);
+        }
         data.n += 1;
         ks[f] = data;
 
@@ -62,9 +73,24 @@ namespace black_internal::core {
       },
       [&](binary, formula left, formula right) -> size_t {
         K_data_t data = ks.find(f) != ks.end() ? ks[f] : K_data_t{0, 0};
-        if(data.size == 0)
-          data.size = 1 + traverse_impl(left, ks, next_placeholder) 
-                        + traverse_impl(right, ks, next_placeholder);
+        if(data.size == 0) {
+          data.size = 1 + traverse_impl(left, ks, order, next_placeholder) 
+                        + traverse_impl(right, ks, order, next_placeholder);
+          order.push_back(f);
+        }
+        data.n += 1;
+        ks[f] = data;
+
+        return data.size;
+      },
+      [&](nary, auto operands) -> size_t {
+        K_data_t data = ks.find(f) != ks.end() ? ks[f] : K_data_t{0, 0};
+        if(data.size == 0) {
+          data.size = 1;
+          for(formula op : operands)
+            data.size += traverse_impl(op, ks, order, next_placeholder);
+          order.push_back(f);
+        }
         data.n += 1;
         ks[f] = data;
 
@@ -75,65 +101,25 @@ namespace black_internal::core {
     );
   }
 
-  static 
-  std::pair<
-    tsl::hopscotch_map<formula, K_data_t>,
-    size_t
-  >
-  traverse(formula f) {
+  //
+  // Collects the subformulas that are candidates for the replacement with a
+  // placeholder, sorted by decreasing K = size * number of occurrences, so
+  // that the minimization tries to get rid of the biggest ones first. 
+  // Ties are broken by the order of first appearance, to keep the result
+  // deterministic.
+  //
+  static std::pair<std::vector<formula>, size_t> candidates(formula f) {
     tsl::hopscotch_map<formula, K_data_t> ks;
+    std::vector<formula> order;
     size_t next_placeholder = 0;
     
-    traverse_impl(f, ks, next_placeholder);
-    
-    return {ks, next_placeholder};
-  }
-
-  static
-  std::vector<std::vector<formula>>
-  group_by_K(formula f, tsl::hopscotch_map<formula, K_data_t> ks) {
-    std::vector<std::vector<formula>> groups(ks[f].size + 1);
-
-    for(auto [subf, k] : ks) {
-      size_t K = k.size * k.n;
-      black_assert(K < groups.size());
-      groups[K].push_back(subf);
-    }
+    traverse_impl(f, ks, order, next_placeholder);
 
-    std::reverse(begin(groups), end(groups));
-
-    return groups;
-  }
-
-  static size_t increment(std::vector<bool> &v) {
-    size_t pos = 0;
-    
-    while(pos < v.size() && v[pos]) {
-      v[pos] = false;
-      ++pos;
-    }
-    if(pos < v.size())
-      v[pos] = true;
-
-    return pos;
-  }
-
-  static std::vector<std::vector<bool>> build_bitsets(size_t size) {
-    std::vector<std::vector<bool>> result;
-    
-    std::vector<bool> v(size);
-    while(increment(v) != size) {
-      result.push_back(v);
-    }
-
-    std::sort(begin(result), end(result), [](auto const& a, auto const& b) {
-      auto m = std::count_if(begin(a), end(a), [](bool x) { return x; });
-      auto n = std::count_if(begin(b), end(b), [](bool x) { return x; });
-
-      return m > n;
+    std::stable_sort(begin(order), end(order), [&](formula a, formula b) {
+      return ks[a].size * ks[a].n > ks[b].size * ks[b].n;
     });
-
-    return result;
+    
+    return {order, next_placeholder};
   }
 
   static 
@@ -167,86 +153,488 @@ namespace black_internal::core {
           replace_impl(right, dontcares, indexes, next_index)
         );
       },
+      [&](nary n, auto operands) {
+        std::vector<formula> newops;
+        for(formula op : operands)
+          newops.push_back(replace_impl(op, dontcares, indexes, next_index));
+        return nary(n.node_type(), newops);
+      },
       [](otherwise) -> formula { black_unreachable(); } // LCOV_EXCL_LINE
     );
   }
 
-  static
-  tsl::hopscotch_set<formula> build_subset(
-    std::vector<formula> const& universe, std::vector<bool> const&bitset
-  ) {
-    black_assert(universe.size() == bitset.size());
-    tsl::hopscotch_set<formula> subset;
-    for(size_t i = 0; i < bitset.size(); ++i) {
-      if(bitset[i])
-        subset.insert(universe[i]);
-    }
-
-    return subset;
-  }
-
+  //
+  // Replaces the dontcares with placeholders, numbered following the order
+  // of the candidates, so that the biggest subformulas get the lowest indexes
+  //
   static 
   formula replace(
     formula f, tsl::hopscotch_set<formula> const&dontcares,
-    size_t next_index
+    std::vector<formula> const& order, size_t next_index
   ) {
     tsl::hopscotch_map<formula, size_t> indexes;
     
+    // a first pass only finds which dontcares are actually replaced
+    size_t reached = 0;
+    replace_impl(f, dontcares, indexes, reached);
+
+    for(formula c : order)
+      if(indexes.find(c) != indexes.end())
+        indexes[c] = next_index++;
+
     return replace_impl(f, dontcares, indexes, next_index);
   }
 
-  static
-  bool check_replacements_impl(
-    formula f, tsl::hopscotch_map<size_t, formula> &formulas
+  [[maybe_unused]]
+  static 
+  bool check_replacements(formula f) {
+    tsl::hopscotch_map<size_t, formula> formulas;
+    return fold<bool>(f, [&](formula g, auto const& result) {
+      return g.match(
+        [](boolean) { return true; },
+        [&](proposition p) {
+          if(auto l = p.name().to<core_placeholder_t>(); l.has_value()) {
+            if(formulas.find(l->n) != formulas.end() && 
+               formulas.at(l->n) != l->f)
+              return false; // LCOV_EXCL_LINE
+            formulas.insert({l->n, l->f});
+          }
+          return true;
+        },
+        [&](unary, formula arg) {
+          return result(arg);
+        },
+        [&](binary, formula left, formula right) {
+          return result(left) && result(right);
+        },
+        [&](nary, auto operands) {
+          return std::all_of(operands.begin(), operands.end(), result);
+        },
+        [](otherwise) -> bool { black_unreachable(); } // LCOV_EXCL_LINE
+      );
+    });
+  }
+
+  //
+  // A single incremental session of the SAT backend, used to answer all the
+  // satisfiability queries of the core extraction.
+  //
+  // Each query asks whether the formula is still unsatisfiable once a set of
+  // candidates is dropped, i.e. replaced by fresh placeholder propositions.
+  // Each remaining candidate `c` is guarded by an activation proposition 
+  // `a`, i.e. it becomes `(a & c) | (!a & p)`, with `p` again the fresh
+  // placeholder, so that assuming `a` at each step keeps `c`, while leaving
+  // `a` free is the same as dropping it. The main algorithm then runs with
+  // all the activations assumed, and those found in the unsat cores of the
+  // refuting checks tell which candidates have been needed. Assuming the
+  // stepped activations one by one, instead of adding `a -> G a` to the
+  // formula, saves the X-requests that would make the encoding heavier.
+  //
+  // Dropped candidates are replaced for real instead of just being left
+  // unassumed: their X-requests would otherwise be left unconstrained in the
+  // encoding and the PRUNE would need much longer paths to refute the formula.
+  //
+  // The encoding of each query is guarded by its own proposition, so all
+  // the queries share the same backend instance with what it has learnt and
+  // translated so far.
+  //
+  class core_session 
+  {
+  public:
+    core_session(
+      scope const& xi, formula f, std::vector<formula> const& candidates,
+      bool finite
+    ) : _frm{f}, _candidates{candidates.begin(), candidates.end()}, 
+        _sigma{f.sigma()}, _xi{chain(xi)}, _finite{finite},
+        _sat{black::sat::solver::get_solver(BLACK_DEFAULT_BACKEND, _xi)} { }
+
+    ~core_session() {
+      black::sat::solver::recycle(std::move(_sat));
+    }
+
+    //
+    // Tells whether the formula is satisfiable once the given candidates are
+    // dropped, looking for models of up to `k_max` states. If it is not, 
+    // `core` is filled with the remaining candidates that have been used to
+    // refute it.
+    //
+    tribool refute(
+      tsl::hopscotch_set<formula> const& dropped,
+      tsl::hopscotch_set<formula> &core,
+      size_t k_max = std::numeric_limits<size_t>::max()
+    );
+
+    // the bound reached by the last call to refute()
+    size_t last_bound() const { return _last_bound; }
+
+    // stops the current call to refute(), if any, from any thread
+    void interrupt() {
+      _interrupted = true;
+      _sat->interrupt();
+    }
+
+    //
+    // Clears the flag set by interrupt(). It is not cleared by refute()
+    // itself, so that an interrupt that comes before the check starts is 
+    // not lost.
+    //
+    void reset_interrupt() { _interrupted = false; }
+
+    // whether the last call to refute() has been interrupted
+    bool interrupted() const { return _interrupted; }
+
+  private:
+    formula guard(formula f, tsl::hopscotch_set<formula> const& dropped);
+    tribool solve(
+      encoder::encoder &enc, proposition query, 
+      tsl::hopscotch_set<formula> &core, size_t k_max
+    );
+    tribool check(std::vector<formula> const& assumptions);
+    void collect(tsl::hopscotch_set<formula> &core);
+
+    formula _frm;
+    tsl::hopscotch_set<formula> _candidates;
+    alphabet *_sigma;
+    scope _xi;
+    bool _finite;
+    std::unique_ptr<black::sat::solver> _sat;
+
+    // number of queries done so far
+    size_t _queries = 0;
+
+    // value for last_bound()
+    size_t _last_bound = 0;
+
+    // the flag for interrupt()
+    std::atomic<bool> _interrupted = false;
+
+    // candidate guarded by each stepped activation of the current query
+    tsl::hopscotch_map<formula, formula> _activations;
+
+    // activations of the candidates kept in the current query
+    std::vector<std::pair<proposition, formula>> _active;
+
+    // memoized results of guard() for the current query
+    tsl::hopscotch_map<formula, formula> _guarded;
+  };
+
+  formula core_session::guard(
+    formula f, tsl::hopscotch_set<formula> const& dropped
   ) {
-    return f.match(
-      [](boolean) { return true; },
-      [&](proposition p) {
-        if(auto l = p.name().to<core_placeholder_t>(); l.has_value()) {
-          if(formulas.find(l->n) != formulas.end() && formulas.at(l->n) != l->f)
-            return false; // LCOV_EXCL_LINE
-          formulas.insert({l->n, l->f});
-        }
-        return true;
+    using namespace std::literals;
+
+    if(auto it = _guarded.find(f); it != _guarded.end())
+      return it->second;
+
+    auto placeholder = [&]{
+      return _sigma->proposition(std::pair{"_core_dropped"sv, f});
+    };
+
+    if(dropped.find(f) != dropped.end()) {
+      formula p = placeholder();
+      _guarded.insert({f, p});
+      return p;
+    }
+
+    formula result = f.match(
+      [&](boolean) { return f; },
+      [&](proposition) { return f; },
+      [&](unary u, formula arg) {
+        return unary(u.node_type(), guard(arg, dropped));
       },
-      [&](unary, formula arg) {
-        return check_replacements_impl(arg, formulas);
+      [&](binary b, formula left, formula right) {
+        return binary(
+          b.node_type(), guard(left, dropped), guard(right, dropped)
+        );
       },
-      [&](binary, formula left, formula right) {
-        return check_replacements_impl(left, formulas) && 
-               check_replacements_impl(right, formulas);
+      [&](nary n, auto operands) {
+        std::vector<formula> newops;
+        for(formula op : operands)
+          newops.push_back(guard(op, dropped));
+        return nary(n.node_type(), newops);
       },
-      [](otherwise) -> bool { black_unreachable(); } // LCOV_EXCL_LINE
+      [](otherwise) -> formula { black_unreachable(); } // LCOV_EXCL_LINE
     );
+
+    if(_candidates.find(f) != _candidates.end()) {
+      proposition a = _sigma->proposition(std::pair{"_core_activation"sv, f});
+      _active.push_back({a, f});
+      result = (a && result) || (!a && placeholder());
+    }
+
+    _guarded.insert({f, result});
+    return result;
   }
 
-  [[maybe_unused]]
-  static 
-  bool check_replacements(formula f) {
-    tsl::hopscotch_map<size_t, formula> formulas;
-    return check_replacements_impl(f, formulas);
+  void core_session::collect(tsl::hopscotch_set<formula> &core) {
+    for(formula a : _sat->unsat_assumptions())
+      if(auto it = _activations.find(a); it != _activations.end())
+        core.insert(it->second);
   }
 
-  formula unsat_core(scope const& xi, formula f, bool finite) {
-    auto [ks, next_placeholder] = traverse(f);
-    auto groups = group_by_K(f, ks);
+  tribool core_session::refute(
+    tsl::hopscotch_set<formula> const& dropped, 
+    tsl::hopscotch_set<formula> &core, size_t k_max
+  ) {
+    using namespace std::literals;
 
-    for(auto &group : groups) {
-      auto bitsets = build_bitsets(group.size());
+    if(_interrupted)
+      return tribool::undef;
 
-      for(auto &bitset : bitsets) 
-      { 
-        auto subset = build_subset(group, bitset);
-        formula candidate = replace(f, subset, next_placeholder);
+    _activations.clear();
+    _active.clear();
+    _guarded.clear();
+
+    formula guarded = guard(_frm, dropped);
+
+    proposition query = 
+      _sigma->proposition(std::pair{"_core_query"sv, _queries++});
+    
+    encoder::encoder enc{guarded, _xi, _finite};
+    tribool res = solve(enc, query, core, k_max);
 
-        black::solver slv;
-        
-        if(slv.solve(xi, candidate, finite) == false)
-          return unsat_core(xi, candidate, finite);
-      }      
+    // the encoding of this query is not needed anymore
+    _sat->assert_formula(!query);
+
+    return res;
+  }
+
+  //
+  // This is the main algorithm of the solver (see solver.cpp), where the
+  // encoding of each bound is guarded by the proposition of the query, and
+  // EMPTY_k | LOOP_k by one of its own. Only the activations found in the 
+  // unsat cores of the refuting checks are collected: any superset of them
+  // keeps each such check unsatisfiable, so the main algorithm would refute
+  // the formula also when keeping just the collected candidates.
+  //
+  tribool core_session::solve(
+    encoder::encoder &enc, proposition query, 
+    tsl::hopscotch_set<formula> &core, size_t k_max
+  ) {
+    using namespace std::literals;
+
+    core.clear();
+
+    std::vector<formula> assumptions = { query };
+    for(size_t k = 0; k <= k_max && !_interrupted; ++k) {
+      _last_bound = k;
+
+      for(auto [a, c] : _active) {
+        proposition ak = encoder::encoder::stepped(a, k);
+        assumptions.push_back(ak);
+        _activations.insert({ak, c});
+      }
+
+      // the k-unraveling: if it is UNSAT, the formula is UNSAT
+      _sat->assert_formula(implies(query, enc.k_unraveling(k)));
+      tribool res = check(assumptions);
+      if(res == false)
+        collect(core);
+      if(res != true)
+        return res;
+
+      // EMPTY_k or LOOP_k: if they are SAT, the formula is SAT
+      proposition close = 
+        _sigma->proposition(std::tuple{"_core_close"sv, _queries, k});
+      _sat->assert_formula(implies(close, enc.k_empty(k) || enc.k_loop(k)));
+      
+      assumptions.push_back(close);
+      res = check(assumptions);
+      if(res != false)
+        return res;
+      collect(core);
+      assumptions.pop_back();
+
+      // the PRUNE: if it is UNSAT, the formula is UNSAT
+      _sat->assert_formula(implies(query, !enc.prune(k)));
+      res = check(assumptions);
+      if(res == false)
+        collect(core);
+      if(res != true)
+        return res;
+    }
+
+    return tribool::undef;
+  }
+
+  //
+  // A single check of the backend, not even started if the query has been
+  // interrupted in the meantime. The backend answers undef only when the
+  // check is cancelled, possibly by an interrupt() that came too late for 
+  // the previous query (see `sat::solver::interrupt()`), so in that case the
+  // query is marked as interrupted as well, and its candidate is tried again.
+  //
+  tribool core_session::check(std::vector<formula> const& assumptions) {
+    if(_interrupted)
+      return tribool::undef;
+
+    tribool res = _sat->is_sat_assuming(assumptions);
+    if(res == tribool::undef)
+      _interrupted = true;
+
+    return res;
+  }
+
+  //
+  // Deletion-based minimization: starting from the core of the whole
+  // formula, each candidate, from the biggest to the smallest, is dropped if
+  // the formula stays unsatisfiable without it, in which case the core of
+  // the last check replaces the current one. The result keeps only the
+  // candidates that survived, and replaces the others with placeholders.
+  //
+  // The checks always terminate thanks to the PRUNE rule, but dropping a
+  // candidate may leave a formula that needs a much longer unraveling to be
+  // refuted (or to find a model), where the checks of the higher bounds can
+  // get very hard. Hence, if a `bound_factor` is given, each check looks 
+  // only up to that many times the bound needed to refute the whole formula,
+  // and candidates that cannot be dropped within it are kept, which is 
+  // always safe. The result is then minimal only among the cores refuted
+  // within that bound.
+  //
+  // The checks can be spread over multiple threads, each with its own
+  // session, working on the first candidates not yet decided. As soon as one
+  // of them is dropped, the checks still running are interrupted, since 
+  // they refer to a core that is not current anymore. A candidate that
+  // cannot be dropped from a core cannot be dropped from any smaller one
+  // either, so such results are kept even if they come late.
+  //
+  struct minimization_t {
+    minimization_t(
+      std::vector<formula> const& _order, 
+      tsl::hopscotch_set<formula> _core, size_t _k_max, size_t threads
+    ) : order{_order}, core{std::move(_core)}, k_max{_k_max}, 
+        running(threads) { }
+
+    struct check_t {
+      formula candidate;
+      size_t epoch;
+      core_session *session;
+    };
+
+    std::vector<formula> const& order;
+    tsl::hopscotch_set<formula> core;
+    size_t k_max;
+
+    // candidates that cannot be dropped from the current core
+    tsl::hopscotch_set<formula> necessary;
+
+    // the check currently done by each thread, if any
+    std::vector<std::optional<check_t>> running;
+
+    // how many times the core has been updated
+    size_t epoch = 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    std::optional<formula> next() const;
+    void work(size_t thread, core_session &session);
+  };
+
+  std::optional<formula> minimization_t::next() const {
+    for(formula c : order) {
+      if(core.find(c) == core.end() || necessary.find(c) != necessary.end())
+        continue;
+      
+      bool taken = std::any_of(begin(running), end(running), [&](auto r) {
+        return r.has_value() && r->candidate == c;
+      });
+      if(!taken)
+        return c;
+    }
+    return {};
+  }
+
+  void minimization_t::work(size_t thread, core_session &session) {
+    std::unique_lock lock{mutex};
+
+    while(true) {
+      std::optional<formula> c = next();
+      if(!c) {
+        bool idle = std::none_of(begin(running), end(running), [](auto r) {
+          return r.has_value();
+        });
+        if(idle)
+          break;
+        cv.wait(lock);
+        continue;
+      }
+
+      tsl::hopscotch_set<formula> dropped = {*c};
+      for(formula d : order)
+        if(core.find(d) == core.end())
+          dropped.insert(d);
+      
+      size_t started = epoch;
+      session.reset_interrupt();
+      running[thread] = check_t{*c, started, &session};
+      lock.unlock();
+
+      tsl::hopscotch_set<formula> smaller;
+      tribool res = session.refute(dropped, smaller, k_max);
+      
+      lock.lock();
+      running[thread].reset();
+
+      if(res == false) {
+        if(started == epoch) {
+          core = std::move(smaller);
+          epoch++;
+          for(auto r : running)
+            if(r.has_value())
+              r->session->interrupt();
+        }
+      } else if(res == true || !session.interrupted()) {
+        necessary.insert(*c);
+      }
+
+      cv.notify_all();
     }
-    black_assert(check_replacements(f));
-    return f;
+
+    cv.notify_all();
+  }
+
+  formula unsat_core(
+    scope const& xi, formula f, bool finite, size_t threads,
+    std::optional<size_t> bound_factor
+  ) {
+    auto [order, next_placeholder] = candidates(f);
+    
+    core_session session{xi, f, order, finite};
+    
+    tsl::hopscotch_set<formula> core;
+    if(session.refute({}, core) != false)
+      return f;
+
+    threads = std::max<size_t>(threads, 1);
+    if(threads > 1 && !f.sigma()->is_concurrent())
+      f.sigma()->make_concurrent();
+
+    size_t k_max = bound_factor ? 
+      *bound_factor * session.last_bound() : 
+      std::numeric_limits<size_t>::max();
+    minimization_t minimization{order, std::move(core), k_max, threads};
+
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; ++t)
+      workers.emplace_back([&, t]() {
+        core_session own{xi, f, order, finite};
+        minimization.work(t, own);
+      });
+    
+    minimization.work(0, session);
+    for(auto &w : workers)
+      w.join();
+
+    tsl::hopscotch_set<formula> dontcares;
+    for(formula c : order)
+      if(minimization.core.find(c) == minimization.core.end())
+        dontcares.insert(c);
+
+    formula result = replace(f, dontcares, order, next_placeholder);
+    
+    black_assert(check_replacements(result));
+    return result;
   }
 
 }
@@ -37,12 +37,12 @@ namespace black_internal::encoder
   formula encoder::prune(size_t k)
   {
     if(_finite)
-      return big_or(*_sigma, range(0, k), [&](size_t l) {
+      return flat_or(*_sigma, range(0, k), [&](size_t l) {
         return l_to_k_loop(l, k, false);
       });
 
-    return big_or(*_sigma, range(0, k), [&](size_t l) {
-      return big_or(*_sigma, range(l + 1, k), [&](size_t j) {
+    return flat_or(*_sigma, range(0, k), [&](size_t l) {
+      return flat_or(*_sigma, range(l + 1, k), [&](size_t j) {
         return l_to_k_loop(l,j,false) && l_to_k_loop(j,k, false) && 
                l_j_k_prune(l,j,k);
       });
@@ -52,7 +52,7 @@ namespace black_internal::encoder
 
   // Generates the _lPRUNE_j^k encoding
   formula encoder::l_j_k_prune(size_t l, size_t j, size_t k) {
-    return big_and(*_sigma, _requests, [&](req_t req) -> formula 
+    return flat_and(*_sigma, _requests, [&](req_t req) -> formula 
     {
       std::optional<formula> ev = _get_ev(req.target); 
       if(!ev)
@@ -60,13 +60,13 @@ namespace black_internal::encoder
 
       // Creating the encoding
       formula inner_impl = 
-        big_or(*_sigma, range(j + 1, k + 1), [&](size_t i) {
+        flat_or(*_sigma, range(j + 1, k + 1), [&](size_t i) {
           return to_ground_snf(*ev, i, req.signature);
         });
 
       formula first_conj = ground(req, k) && inner_impl;
       formula second_conj = 
-        big_or(*_sigma, range(l + 1, j + 1), [&](size_t i) {
+        flat_or(*_sigma, range(l + 1, j + 1), [&](size_t i) {
           return to_ground_snf(*ev, i, req.signature);
         });
 
@@ -77,7 +77,7 @@ namespace black_internal::encoder
 
   // Generates the encoding for EMPTY_k
   formula encoder::k_empty(size_t k) {
-    return big_and(*_sigma, _requests, [&,this](req_t req) -> formula {
+    return flat_and(*_sigma, _requests, [&,this](req_t req) -> formula {
       if(req.type == req_t::future) {
         if(!_finite || req.strength == req_t::strong)
           return forall(req.signature, !ground(req, k));
@@ -108,14 +108,14 @@ namespace black_internal::encoder
     if(_finite)
       return _sigma->bottom();
 
-    formula axioms = big_and(*_sigma, range(0,k), [&](size_t l) {
+    formula axioms = flat_and(*_sigma, range(0,k), [&](size_t l) {
       proposition lp = loop_prop(_sigma, l, k);
       return iff(lp, l_to_k_loop(l, k, true) && l_to_k_period(l, k));
     });
     
 
     return // LCOV_EXCL_LINE
-      axioms && big_or(*_sigma, range(0, k), [&](size_t l) { // LCOV_EXCL_LINE
+      axioms && flat_or(*_sigma, range(0, k), [&](size_t l) { // LCOV_EXCL_LINE
       return loop_prop(_sigma, l, k);
     });
   }
@@ -123,7 +123,7 @@ namespace black_internal::encoder
   // Generates the encoding for _lP_k
   formula encoder::l_to_k_period(size_t l, size_t k) {
 
-    return big_and(*_sigma, _requests, [&](req_t req) -> formula {
+    return flat_and(*_sigma, _requests, [&](req_t req) -> formula {
       std::optional<formula> ev = _get_ev(req.target);
       if(!ev)
         return _sigma->top();
@@ -131,7 +131,7 @@ namespace black_internal::encoder
       // Creating the encoding
       formula proposition_phi_k = ground(req, k);
       formula body_impl = 
-        big_or(*_sigma, range(l + 1, k + 1), [&](size_t i) {
+        flat_or(*_sigma, range(l + 1, k + 1), [&](size_t i) {
           return to_ground_snf(*ev, i, req.signature);
         });
 
@@ -142,7 +142,7 @@ namespace black_internal::encoder
 
   // Generates the encoding for _lR_k
   formula encoder::l_to_k_loop(size_t l, size_t k, bool close_yesterdays) {
-    return big_and(*_sigma, _requests, [&](req_t req) {
+    return flat_and(*_sigma, _requests, [&](req_t req) {
       formula f = forall(req.signature,
         iff( ground(req, l), ground(req, k) )
       );
@@ -159,7 +159,7 @@ namespace black_internal::encoder
   // Generates the k-unraveling step for the given k.
   formula encoder::k_unraveling(size_t k) {
     if (k == 0) {
-      auto init = big_and(*_sigma, _requests, [&](req_t req) -> formula {
+      auto init = flat_and(*_sigma, _requests, [&](req_t req) -> formula {
         if(req.type == req_t::past) {
           switch(req.strength) {
             case req_t::strong:
@@ -174,7 +174,7 @@ namespace black_internal::encoder
       return to_ground_snf(_frm, k, {}) && !not_first_prop(0) && init;
     }
 
-    auto reqs = big_and(*_sigma, _requests, [&](req_t req) {
+    auto reqs = flat_and(*_sigma, _requests, [&](req_t req) {
       nest_scope_t next{_xi};
 
       for(auto d : req.signature)
@@ -193,12 +193,12 @@ namespace black_internal::encoder
       black_unreachable();
     });
 
-    auto lookaheads = big_and(*_sigma, _lookaheads, [&](lookahead_t lh) {
+    auto lookaheads = flat_and(*_sigma, _lookaheads, [&](lookahead_t lh) {
       switch(lh.type) {
         case req_t::future:
-          return ground(lh, k - 1) == stepped(lh.target, k);
+          return ground(lh, k - 1) == stepped(term{lh.target}, k);
         case req_t::past:
-          return ground(lh, k) == stepped(lh.target, k - 1);
+          return ground(lh, k) == stepped(term{lh.target}, k - 1);
       }
       black_unreachable();
     });
@@ -253,12 +253,22 @@ namespace black_internal::encoder
         return ground(mk_req(y, env), k);
       },
       [&](conjunction c) {
-        return big_and(*f.sigma(), operands(c), [&](auto op) {
+        return flat_and(*f.sigma(), operands(c), [&](auto op) {
           return to_ground_snf(op, k, env);
         });
       },
       [&](disjunction c) {
-        return big_or(*f.sigma(), operands(c), [&](auto op) {
+        return flat_or(*f.sigma(), operands(c), [&](auto op) {
+          return to_ground_snf(op, k, env);
+        });
+      },
+      [&](big_conjunction c) {
+        return flat_and(*f.sigma(), operands(c), [&](auto op) {
+          return to_ground_snf(op, k, env);
+        });
+      },
+      [&](big_disjunction c) {
+        return flat_or(*f.sigma(), operands(c), [&](auto op) {
           return to_ground_snf(op, k, env);
         });
       },
@@ -355,14 +365,20 @@ namespace black_internal::encoder
   {
     return t.match( // LCOV_EXCL_LINE
       [](constant c) { return *c.to<constant>(); },
-      [&](variable x) {
+      [&](variable x) -> term {
+        if(_timed && !_xi.is_rigid(x))
+          return timed(x)(time(k));
         return stepped(x, k);
       },
       [&](application a) {
         std::vector<term> terms;
+        if(_timed && !_xi.is_rigid(a.func()))
+          terms.push_back(time(k));
         for(term ti : a.terms())
           terms.push_back(stepped(ti, k));
         
+        if(_timed && !_xi.is_rigid(a.func()))
+          return application(timed(a.func()), terms);
         return application(stepped(a.func(), k), terms);
       }, // LCOV_EXCL_LINE
       [&](to_integer, auto arg) {
@@ -441,14 +457,57 @@ namespace black_internal::encoder
   }
 
   atom encoder::stepped(atom a, size_t k) {
+    bool timed_rel = _timed && !_xi.is_rigid(a.rel());
+
     std::vector<term> terms;
+    if(timed_rel)
+      terms.push_back(time(k));
     for(term t : a.terms())
       terms.push_back(stepped(t, k));
 
+    if(timed_rel)
+      return atom(timed(a.rel()), terms);
+
     relation stepped_rel = stepped(a.rel(), k);
     return atom(stepped_rel, terms);
   }
 
+  term encoder::time(size_t k) {
+    return constant(_sigma->integer(static_cast<int64_t>(k)));
+  }
+
+  function encoder::timed(variable x) {
+    function tx = _sigma->function(std::pair{"_timed"sv, x});
+    if(_xi.sort(x) && !_xi.signature(tx))
+      _global_xi->declare(
+        tx, *_xi.sort(x), {_sigma->integer_sort()}, scope::rigid
+      );
+
+    return tx;
+  }
+
+  function encoder::timed(function f) {
+    function tf = _sigma->function(std::pair{"_timed"sv, f});
+    if(_xi.signature(f) && _xi.sort(f) && !_xi.signature(tf)) {
+      std::vector<sort> signature = *_xi.signature(f);
+      signature.insert(signature.begin(), _sigma->integer_sort());
+      _global_xi->declare(tf, *_xi.sort(f), signature, scope::rigid);
+    }
+
+    return tf;
+  }
+
+  relation encoder::timed(relation r) {
+    relation tr = _sigma->relation(std::pair{"_timed"sv, r});
+    if(_xi.signature(r) && !_xi.signature(tr)) {
+      std::vector<sort> signature = *_xi.signature(r);
+      signature.insert(signature.begin(), _sigma->integer_sort());
+      _global_xi->declare(tr, signature, scope::rigid);
+    }
+
+    return tr;
+  }
+
   equality encoder::stepped(equality e, size_t k) {
     std::vector<term> stepterms;
     for(auto t : e.terms())
@@ -501,12 +560,22 @@ namespace black_internal::encoder
     return s;
   }
 
-  variable encoder::ground(lookahead_t lh, size_t k) {
+  term encoder::ground(lookahead_t lh, size_t k) {
     std::string_view sv = 
       lh.type == req_t::future ? 
         (lh.strength == req_t::weak ? "__wnext" : "__next") :
         (lh.strength == req_t::weak ? "__wprev" : "__prev");
 
+    if(_timed) {
+      function g = _sigma->function(std::tuple{sv, lh.target});
+      if(_xi.sort(lh.target) && !_xi.signature(g))
+        _global_xi->declare(
+          g, *_xi.sort(lh.target), {_sigma->integer_sort()}, scope::rigid
+        );
+
+      return g(time(k));
+    }
+
     variable g = _sigma->variable(std::tuple{sv, lh.target, k});
     if(_xi.sort(lh.target) && !_xi.sort(g))
       _global_xi->declare(g, *_xi.sort(lh.target), scope::rigid);
@@ -535,7 +604,7 @@ namespace black_internal::encoder
   // Transformation in NNF
   formula encoder::to_nnf(formula f) {
     if(auto it = _nnf_cache.find(f); it != _nnf_cache.end())
-      return it->second;     
+      return it->second.get(_sigma);
 
     formula nnf = f.match( // LCOV_EXCL_LINE
       [](boolean b) { return b; },
@@ -576,12 +645,22 @@ namespace black_internal::encoder
             return to_nnf(!implies(left,right)) || to_nnf(!implies(right,left));
           },
           [&](conjunction c) {
-            return big_or(*f.sigma(), operands(c), [&](auto op) {
+            return flat_or(*f.sigma(), operands(c), [&](auto op) {
               return to_nnf(!op);
             });
           },
           [&](disjunction c) {
-            return big_and(*f.sigma(), operands(c), [&](auto op) {
+            return flat_and(*f.sigma(), operands(c), [&](auto op) {
+              return to_nnf(!op);
+            });
+          },
+          [&](big_conjunction c) {
+            return flat_or(*f.sigma(), operands(c), [&](auto op) {
+              return to_nnf(!op);
+            });
+          },
+          [&](big_disjunction c) {
+            return flat_and(*f.sigma(), operands(c), [&](auto op) {
               return to_nnf(!op);
             });
           },
@@ -604,12 +683,22 @@ namespace black_internal::encoder
 	      return to_nnf(implies(left, right)) && to_nnf(implies(right, left));
       },
       [&](conjunction c) {
-        return big_and(*f.sigma(), operands(c), [&](auto op) {
+        return flat_and(*f.sigma(), operands(c), [&](auto op) {
           return to_nnf(op);
         });
       },
       [&](disjunction c) {
-        return big_or(*f.sigma(), operands(c), [&](auto op) {
+        return flat_or(*f.sigma(), operands(c), [&](auto op) {
+          return to_nnf(op);
+        });
+      },
+      [&](big_conjunction c) {
+        return flat_and(*f.sigma(), operands(c), [&](auto op) {
+          return to_nnf(op);
+        });
+      },
+      [&](big_disjunction c) {
+        return flat_or(*f.sigma(), operands(c), [&](auto op) {
           return to_nnf(op);
         });
       },
@@ -727,6 +816,10 @@ namespace black_internal::encoder
         _collect_requests(left, env);
         _collect_requests(right, env);
       },
+      [&](nary, auto ops) {
+        for(auto op : ops)
+          _collect_requests(op, env);
+      },
       [](otherwise) { }
     );
   }
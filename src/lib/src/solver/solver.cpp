@@ -27,6 +27,7 @@
 #include <black/support/range.hpp>
 #include <black/solver/solver.hpp>
 #include <black/solver/encoding.hpp>
+#include <black/logic/cnf.hpp>
 #include <black/sat/solver.hpp>
 
 #include <numeric>
@@ -63,12 +64,20 @@ namespace black_internal::solver
     // the name of the currently chosen sat backend
     std::string sat_backend = BLACK_DEFAULT_BACKEND; // sensible default
 
+    // whether to use the time-indexed encoding for first-order symbols
+    bool timed_encoding = false;
+
     // the flag for `interrupt()`
     std::atomic<bool> interrupt_flag = false;
 
     // tracer
     std::function<void(trace_t)> tracer = [](trace_t){};
 
+    // gives the SAT solver instance back to the backends pool
+    ~_solver_t() {
+      black::sat::solver::recycle(std::move(sat));
+    }
+
     void trace(size_t k);
     void trace(trace_t::type_t, scope const&, logic::formula);
 
@@ -134,6 +143,14 @@ namespace black_internal::solver
     return _data->sat_backend;
   }
 
+  void solver::set_timed_encoding(bool timed) {
+    _data->timed_encoding = timed;
+  }
+
+  bool solver::timed_encoding() const {
+    return _data->timed_encoding;
+  }
+
   void solver::set_tracer(std::function<void(trace_t)> const&tracer) {
     _data->tracer = tracer;
   }
@@ -213,7 +230,8 @@ namespace black_internal::solver
   ) {
     scope xi = chain(s);
     
-    enc = encoder::encoder{f, xi, finite};
+    enc = encoder::encoder{f, xi, finite, timed_encoding};
+    black::sat::solver::recycle(std::move(sat));
     sat = black::sat::solver::get_solver(sat_backend, xi);
 
     trace(trace_t::nnf, xi, enc->get_formula());
@@ -236,7 +254,7 @@ namespace black_internal::solver
       // If it is UNSAT, then stop with UNSAT
       auto unrav = enc->k_unraveling(k);
       trace(trace_t::unrav, xi, unrav);
-      sat->assert_formula(unrav);
+      sat->assert_formulas(cnf::conjuncts(unrav));
       if(tribool res = sat->is_sat(); !res)
         return res;
 
@@ -270,7 +288,8 @@ namespace black_internal::solver
 
   void solver::_solver_t::interrupt() {
     interrupt_flag = true;
-    sat->interrupt();
+    if(sat)
+      sat->interrupt();
   }
 
   template<hierarchy H, typename F>
@@ -0,0 +1,820 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/solver/tracecheck.hpp>
+#include <black/support/assert.hpp>
+
+#include <tsl/hopscotch_map.h>
+
+#include <algorithm>
+
+namespace black_internal::tracecheck
+{
+  using bits_t = std::vector<uint64_t>;
+
+  static constexpr size_t word_bits = 64;
+
+  static size_t words(size_t n) {
+    return (n + word_bits - 1) / word_bits;
+  }
+
+  static bool get(bits_t const& bits, size_t i) {
+    return (bits[i / word_bits] >> (i % word_bits)) & 1;
+  }
+
+  static void put(bits_t &bits, size_t i, bool value) {
+    uint64_t bit = uint64_t{1} << (i % word_bits);
+    if(value)
+      bits[i / word_bits] |= bit;
+    else
+      bits[i / word_bits] &= ~bit;
+  }
+
+  //
+  // The `len <= 64` bits starting at `pos`
+  //
+  static uint64_t get_bits(bits_t const& bits, size_t pos, size_t len) {
+    size_t w = pos / word_bits;
+    size_t offset = pos % word_bits;
+
+    uint64_t result = bits[w] >> offset;
+    if(offset && w + 1 < bits.size())
+      result |= bits[w + 1] << (word_bits - offset);
+
+    if(len < word_bits)
+      result &= (uint64_t{1} << len) - 1;
+    return result;
+  }
+
+  static void put_bits(bits_t &bits, size_t pos, size_t len, uint64_t value) {
+    for(size_t done = 0; done < len; ) {
+      size_t w = (pos + done) / word_bits;
+      size_t offset = (pos + done) % word_bits;
+      size_t chunk = std::min(len - done, word_bits - offset);
+      
+      uint64_t mask = chunk < word_bits ? 
+        ((uint64_t{1} << chunk) - 1) << offset : ~uint64_t{0};
+      
+      bits[w] = (bits[w] & ~mask) | (((value >> done) << offset) & mask);
+      done += chunk;
+    }
+  }
+
+  static uint64_t reverse(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+    x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0F) | ((x & 0x0F0F0F0F0F0F0F0F) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FF) | ((x & 0x00FF00FF00FF00FF) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFF) | ((x & 0x0000FFFF0000FFFF) << 16);
+    return (x >> 32) | (x << 32);
+  }
+
+  //
+  // The carry chain of `g + p`, which is the least solution of
+  // `c[i] = g[i] | (p[i] & c[i - 1])` with `c[-1] = carry`, provided `g` is
+  // a subset of `p`. The carry out of the word is then `c[63]`.
+  //
+  static uint64_t propagate(uint64_t g, uint64_t p, uint64_t carry) {
+    uint64_t s = g + p + carry;
+    return g | (p & (s ^ g ^ p));
+  }
+
+  trace::trace(size_t propositions, size_t size, std::optional<size_t> loop)
+    : _size{size}, _loop{loop}, 
+      _values(propositions, bits_t(words(size), ~uint64_t{0})) 
+  { 
+    black_assert(!loop || *loop <= size);
+  }
+
+  bool trace::value(size_t proposition, size_t t) const {
+    black_assert(proposition < _values.size());
+    black_assert(t < _size);
+    return get(_values[proposition], t);
+  }
+
+  void trace::set(size_t proposition, size_t t, bool value) {
+    black_assert(proposition < _values.size());
+    black_assert(t < _size);
+    put(_values[proposition], t, value);
+  }
+
+  static uint64_t mask(size_t n) {
+    return n % word_bits ? 
+      (uint64_t{1} << (n % word_bits)) - 1 : ~uint64_t{0};
+  }
+
+  static bits_t negate_bits(bits_t bits, size_t n) {
+    for(uint64_t &w : bits)
+      w = ~w;
+    bits.back() &= mask(n);
+    return bits;
+  }
+
+  //
+  // The values of `x` one state later, where `last` is the one following the
+  // last of the `n` states.
+  //
+  static bits_t next_bits(bits_t const& x, size_t n, bool last) {
+    bits_t result(x.size());
+    for(size_t i = 0; i < x.size(); ++i) {
+      result[i] = x[i] >> 1;
+      if(i + 1 < x.size())
+        result[i] |= x[i + 1] << (word_bits - 1);
+    }
+    put(result, n - 1, last);
+
+    return result;
+  }
+
+  //
+  // The values of `x` one state earlier, where `first` is the one preceding
+  // the first state.
+  //
+  static bits_t prev_bits(bits_t const& x, size_t n, bool first) {
+    bits_t result(x.size());
+    for(size_t i = 0; i < x.size(); ++i) {
+      result[i] = x[i] << 1;
+      if(i > 0)
+        result[i] |= x[i - 1] >> (word_bits - 1);
+    }
+    put(result, 0, first);
+    result.back() &= mask(n);
+
+    return result;
+  }
+
+  //
+  // `l S r` holds at `i` iff `r[i] | (l[i] & (l S r)[i - 1])`, which is the
+  // carry chain of `r + (l | r)` when going from the first state onwards.
+  // `carry` is the value of `l S r` before the first state.
+  //
+  static bits_t since_bits(bits_t const& l, bits_t const& r, bool carry) {
+    bits_t result(l.size());
+    uint64_t c = carry;
+    for(size_t i = 0; i < l.size(); ++i) {
+      result[i] = propagate(r[i], l[i] | r[i], c);
+      c = result[i] >> (word_bits - 1);
+    }
+
+    return result;
+  }
+
+  //
+  // `l U r` is the same as above but backwards, so the words are processed
+  // from the last to the first, with their bits reversed. The bits past the
+  // last state propagate `carry`, which is the value of `l U r` after it.
+  //
+  static bits_t until_bits(
+    bits_t const& l, bits_t const& r, size_t n, bool carry
+  ) {
+    bits_t result(l.size());
+    uint64_t c = carry;
+    for(size_t i = l.size(); i-- > 0; ) {
+      uint64_t g = reverse(r[i]);
+      uint64_t p = reverse(l[i] | r[i]);
+      if(i + 1 == l.size())
+        p |= reverse(~mask(n));
+
+      uint64_t chain = propagate(g, p, c);
+      result[i] = reverse(chain);
+      c = chain >> (word_bits - 1);
+    }
+    result.back() &= mask(n);
+
+    return result;
+  }
+
+  namespace {
+    enum class op_t : uint8_t {
+      top, bottom, proposition, negation, conjunction, disjunction, 
+      implication, iff, tomorrow, w_tomorrow, yesterday, w_yesterday,
+      eventually, always, once, historically, until, release, w_until, 
+      s_release, since, triggered
+    };
+
+    struct instruction_t {
+      op_t op;
+      formula f;
+
+      // indexes of the operands in the program, or of the proposition
+      std::vector<size_t> args;
+    };
+  }
+
+  //
+  // Evaluates the program over all the states at once, where `Domain` gives
+  // the values of propositions and the semantics of the primitive operators
+  // over its `value_t`. The values before the first state are asked to the
+  // domain as those of the instruction of the argument, for yesterday, or
+  // of the instruction itself, for since, which can be negated when it comes
+  // from a dual operator.
+  //
+  template<typename Domain>
+  static std::vector<typename Domain::value_t> evaluate(
+    std::vector<instruction_t> const& program, Domain const& d
+  ) {
+    using value_t = typename Domain::value_t;
+
+    std::vector<value_t> values;
+    values.reserve(program.size());
+    for(size_t i = 0; i < program.size(); ++i) {
+      instruction_t const& instr = program[i];
+      auto arg = [&](size_t j) -> value_t const& {
+        return values[instr.args[j]];
+      };
+
+      value_t result;
+      switch(instr.op) {
+        case op_t::top:
+          result = d.top();
+          break;
+        case op_t::bottom:
+          result = d.negate(d.top());
+          break;
+        case op_t::proposition:
+          result = d.proposition(instr.args[0]);
+          break;
+        case op_t::negation:
+          result = d.negate(arg(0));
+          break;
+        case op_t::conjunction:
+          result = arg(0);
+          for(size_t j = 1; j < instr.args.size(); ++j)
+            result = d.conjunction(result, arg(j));
+          break;
+        case op_t::disjunction:
+          result = arg(0);
+          for(size_t j = 1; j < instr.args.size(); ++j)
+            result = d.disjunction(result, arg(j));
+          break;
+        case op_t::implication:
+          result = d.disjunction(d.negate(arg(0)), arg(1));
+          break;
+        case op_t::iff:
+          result = d.iff(arg(0), arg(1));
+          break;
+        case op_t::tomorrow:
+          result = d.tomorrow(arg(0), false);
+          break;
+        case op_t::w_tomorrow:
+          result = d.tomorrow(arg(0), true);
+          break;
+        case op_t::yesterday:
+          result = d.yesterday(arg(0), false, instr.args[0]);
+          break;
+        case op_t::w_yesterday:
+          result = d.yesterday(arg(0), true, instr.args[0]);
+          break;
+        case op_t::eventually: // F x = True U x
+          result = d.until(d.top(), arg(0));
+          break;
+        case op_t::always: // G x = !F !x
+          result = d.negate(d.until(d.top(), d.negate(arg(0))));
+          break;
+        case op_t::once: // O x = True S x
+          result = d.since(d.top(), arg(0), i, false);
+          break;
+        case op_t::historically: // H x = !O !x
+          result = d.negate(d.since(d.top(), d.negate(arg(0)), i, true));
+          break;
+        case op_t::until:
+          result = d.until(arg(0), arg(1));
+          break;
+        case op_t::release: // l R r = !(!l U !r)
+          result = d.negate(d.until(d.negate(arg(0)), d.negate(arg(1))));
+          break;
+        case op_t::w_until: { // l W r = !(!r U (!l & !r))
+          value_t nr = d.negate(arg(1));
+          result = d.negate(
+            d.until(nr, d.conjunction(d.negate(arg(0)), nr))
+          );
+          break;
+        }
+        case op_t::s_release: // l M r = r U (l & r)
+          result = d.until(arg(1), d.conjunction(arg(0), arg(1)));
+          break;
+        case op_t::since:
+          result = d.since(arg(0), arg(1), i, false);
+          break;
+        case op_t::triggered: // l T r = !(!l S !r)
+          result = d.negate(
+            d.since(d.negate(arg(0)), d.negate(arg(1)), i, true)
+          );
+          break;
+      }
+      values.push_back(std::move(result));
+    }
+
+    return values;
+  }
+
+  struct trace_checker::_checker_t {
+    std::vector<proposition> propositions;
+    std::vector<instruction_t> program;
+
+    // the maximum nesting of past operators
+    size_t past_depth = 0;
+
+    // the program index and past nesting of each compiled subformula
+    tsl::hopscotch_map<formula, std::pair<size_t, size_t>> compiled;
+    tsl::hopscotch_map<proposition, size_t> indexes;
+
+    std::pair<size_t, size_t> compile(formula f);
+    std::pair<size_t, size_t> emit(
+      op_t op, formula f, std::vector<std::pair<size_t, size_t>> args,
+      bool past = false
+    );
+  };
+
+  std::pair<size_t, size_t> trace_checker::_checker_t::emit(
+    op_t op, formula f, std::vector<std::pair<size_t, size_t>> args, 
+    bool past
+  ) {
+    instruction_t instr{op, f, {}};
+    size_t depth = 0;
+    for(auto [index, d] : args) {
+      instr.args.push_back(index);
+      depth = std::max(depth, d);
+    }
+    if(past)
+      depth++;
+
+    past_depth = std::max(past_depth, depth);
+    program.push_back(std::move(instr));
+    
+    return {program.size() - 1, depth};
+  }
+
+  std::pair<size_t, size_t> trace_checker::_checker_t::compile(formula f) {
+    if(auto it = compiled.find(f); it != compiled.end())
+      return it->second;
+
+    auto result = f.match(
+      [&](boolean b) {
+        return emit(b.value() ? op_t::top : op_t::bottom, f, {});
+      },
+      [&](proposition p) {
+        auto it = indexes.find(p);
+        if(it == indexes.end()) {
+          it = indexes.insert({p, propositions.size()}).first;
+          propositions.push_back(p);
+        }
+        
+        auto r = emit(op_t::proposition, f, {});
+        program.back().args.push_back(it->second);
+        return r;
+      },
+      [&](negation, formula arg) {
+        return emit(op_t::negation, f, {compile(arg)});
+      },
+      [&](tomorrow, formula arg) {
+        return emit(op_t::tomorrow, f, {compile(arg)});
+      },
+      [&](w_tomorrow, formula arg) {
+        return emit(op_t::w_tomorrow, f, {compile(arg)});
+      },
+      [&](yesterday, formula arg) {
+        return emit(op_t::yesterday, f, {compile(arg)}, true);
+      },
+      [&](w_yesterday, formula arg) {
+        return emit(op_t::w_yesterday, f, {compile(arg)}, true);
+      },
+      [&](eventually, formula arg) {
+        return emit(op_t::eventually, f, {compile(arg)});
+      },
+      [&](always, formula arg) {
+        return emit(op_t::always, f, {compile(arg)});
+      },
+      [&](once, formula arg) {
+        return emit(op_t::once, f, {compile(arg)}, true);
+      },
+      [&](historically, formula arg) {
+        return emit(op_t::historically, f, {compile(arg)}, true);
+      },
+      [&](conjunction, formula l, formula r) {
+        return emit(op_t::conjunction, f, {compile(l), compile(r)});
+      },
+      [&](disjunction, formula l, formula r) {
+        return emit(op_t::disjunction, f, {compile(l), compile(r)});
+      },
+      [&](implication, formula l, formula r) {
+        return emit(op_t::implication, f, {compile(l), compile(r)});
+      },
+      [&](iff, formula l, formula r) {
+        return emit(op_t::iff, f, {compile(l), compile(r)});
+      },
+      [&](until, formula l, formula r) {
+        return emit(op_t::until, f, {compile(l), compile(r)});
+      },
+      [&](release, formula l, formula r) {
+        return emit(op_t::release, f, {compile(l), compile(r)});
+      },
+      [&](w_until, formula l, formula r) {
+        return emit(op_t::w_until, f, {compile(l), compile(r)});
+      },
+      [&](s_release, formula l, formula r) {
+        return emit(op_t::s_release, f, {compile(l), compile(r)});
+      },
+      [&](since, formula l, formula r) {
+        return emit(op_t::since, f, {compile(l), compile(r)}, true);
+      },
+      [&](triggered, formula l, formula r) {
+        return emit(op_t::triggered, f, {compile(l), compile(r)}, true);
+      },
+      [&](big_conjunction, auto operands) {
+        std::vector<std::pair<size_t, size_t>> args;
+        for(formula op : operands)
+          args.push_back(compile(op));
+        return emit(op_t::conjunction, f, std::move(args));
+      },
+      [&](big_disjunction, auto operands) {
+        std::vector<std::pair<size_t, size_t>> args;
+        for(formula op : operands)
+          args.push_back(compile(op));
+        return emit(op_t::disjunction, f, std::move(args));
+      },
+      [](otherwise) -> std::pair<size_t, size_t> { // LCOV_EXCL_LINE
+        black_unreachable(); // LCOV_EXCL_LINE
+      }
+    );
+
+    compiled.insert({f, result});
+    return result;
+  }
+
+  namespace {
+    //
+    // The domain of `trace_checker::check()`: the trace as seen by the
+    // evaluation has `n` states, where the one following the last is `back`,
+    // if any. The loop of infinite traces is unrolled enough times for all
+    // the subformulas to become periodic.
+    //
+    struct trace_domain {
+      using value_t = bits_t;
+
+      trace const& tr;
+      std::vector<bits_t> const& values;
+      size_t n;
+      std::optional<size_t> back;
+
+      bits_t top() const {
+        bits_t result(words(n), ~uint64_t{0});
+        result.back() &= mask(n);
+        return result;
+      }
+
+      bits_t proposition(size_t p) const;
+
+      bits_t negate(bits_t const& x) const {
+        return negate_bits(x, n);
+      }
+
+      bits_t conjunction(bits_t l, bits_t const& r) const {
+        for(size_t i = 0; i < l.size(); ++i)
+          l[i] &= r[i];
+        return l;
+      }
+
+      bits_t disjunction(bits_t l, bits_t const& r) const {
+        for(size_t i = 0; i < l.size(); ++i)
+          l[i] |= r[i];
+        return l;
+      }
+
+      bits_t iff(bits_t l, bits_t const& r) const {
+        for(size_t i = 0; i < l.size(); ++i)
+          l[i] ^= r[i];
+        return negate(l);
+      }
+
+      bits_t tomorrow(bits_t const& x, bool weak) const {
+        return next_bits(x, n, back ? get(x, *back) : weak);
+      }
+
+      bits_t yesterday(bits_t const& x, bool weak, size_t) const {
+        return prev_bits(x, n, weak);
+      }
+
+      //
+      // The value of `l U r` after the last state is the one at `back`,
+      // which is not known beforehand. Computing it first with a zero carry
+      // is enough to get the right value at `back`: the witness of `r`, if
+      // any, is met before going around the loop again.
+      //
+      bits_t until(bits_t const& l, bits_t const& r) const {
+        bits_t result = until_bits(l, r, n, false);
+        if(back)
+          result = until_bits(l, r, n, get(result, *back));
+        return result;
+      }
+
+      bits_t since(bits_t const& l, bits_t const& r, size_t, bool) const {
+        return since_bits(l, r, false);
+      }
+    };
+  }
+
+  //
+  // The values of proposition `p` over the unrolled trace. The states of
+  // infinite traces without a loop are followed by a state where everything
+  // holds, as done for the states missing from the end of a model.
+  //
+  bits_t trace_domain::proposition(size_t p) const {
+    bits_t result(words(n));
+    
+    size_t size = std::min(tr.size(), n);
+    std::copy(
+      values[p].begin(), values[p].begin() + words(size), result.begin()
+    );
+    result[words(size) - 1] &= mask(size);
+    
+    if(n > tr.size() && tr.loop() == tr.size()) {
+      put(result, size, true);
+      size++;
+    }
+
+    if(!back)
+      return result;
+
+    size_t period = n - *back;
+    for(size_t pos = size; pos < n; ) {
+      size_t len = std::min({word_bits, period, n - pos});
+      put_bits(result, pos, len, get_bits(result, pos - period, len));
+      pos += len;
+    }
+
+    return result;
+  }
+
+  trace_checker::trace_checker(formula f) 
+    : _data{std::make_unique<_checker_t>()} 
+  {
+    _data->compile(f);
+    _data->compiled.clear();
+    _data->indexes.clear();
+  }
+
+  trace_checker::~trace_checker() = default;
+
+  trace_checker::trace_checker(trace_checker &&) = default;
+  trace_checker &trace_checker::operator=(trace_checker &&) = default;
+
+  std::vector<proposition> const& trace_checker::propositions() const {
+    return _data->propositions;
+  }
+
+  //
+  // For infinite traces, the values of a subformula with `d` nested past
+  // operators are periodic from `d` periods after the loop, so the trace is
+  // unrolled up to `past_depth + 1` periods after the loop, where the last
+  // period is the one looping back. States further away are mapped back
+  // into the last period.
+  //
+  bool trace_checker::check(
+    trace const& tr, size_t t, 
+    std::function<void(formula, bool)> const& report
+  ) const {
+    black_assert(tr._values.size() == _data->propositions.size());
+    black_assert(tr.size() > 0);
+    black_assert(tr.loop() || t < tr.size());
+
+    trace_domain domain{tr, tr._values, tr.size(), std::nullopt};
+    size_t pos = t;
+    if(tr.loop()) {
+      size_t loop = *tr.loop();
+      size_t period = std::max(tr.size() - loop, size_t{1});
+
+      domain.n = loop + (_data->past_depth + 1) * period;
+      domain.back = domain.n - period;
+      
+      if(pos >= domain.n)
+        pos = *domain.back + (pos - *domain.back) % period;
+    }
+
+    std::vector<bits_t> values = evaluate(_data->program, domain);
+
+    if(report)
+      for(size_t i = 0; i < _data->program.size(); ++i)
+        report(_data->program[i].f, get(values[i], pos));
+
+    return get(values.back(), pos);
+  }
+
+  namespace {
+    //
+    // The values of a subformula over the states of the window of a
+    // `monitor`, given as those where it surely holds, `lo`, and those where
+    // it possibly holds, `hi`. The states after the window are unknown, so
+    // future operators are approximated from below and from above.
+    //
+    struct interval_t {
+      bits_t lo;
+      bits_t hi;
+    };
+
+    // the value of a subformula at a single state
+    struct verdict_t {
+      bool lo;
+      bool hi;
+
+      verdict_t operator!() const { return {!hi, !lo}; }
+    };
+
+    struct window_domain {
+      using value_t = interval_t;
+
+      std::vector<bits_t> const& states;
+      size_t n;
+
+      // the values at the state before the window, if any
+      std::vector<verdict_t> const* previous;
+
+      // whether the trace ends with the window
+      bool finite;
+
+      interval_t top() const {
+        bits_t result(words(n), ~uint64_t{0});
+        result.back() &= mask(n);
+        return {result, result};
+      }
+
+      interval_t proposition(size_t p) const {
+        bits_t values{states[p].begin(), states[p].begin() + words(n)};
+        return {values, values};
+      }
+
+      interval_t negate(interval_t const& x) const {
+        return {negate_bits(x.hi, n), negate_bits(x.lo, n)};
+      }
+
+      interval_t conjunction(interval_t l, interval_t const& r) const {
+        for(size_t i = 0; i < l.lo.size(); ++i) {
+          l.lo[i] &= r.lo[i];
+          l.hi[i] &= r.hi[i];
+        }
+        return l;
+      }
+
+      interval_t disjunction(interval_t l, interval_t const& r) const {
+        for(size_t i = 0; i < l.lo.size(); ++i) {
+          l.lo[i] |= r.lo[i];
+          l.hi[i] |= r.hi[i];
+        }
+        return l;
+      }
+
+      interval_t iff(interval_t const& l, interval_t const& r) const {
+        return disjunction(
+          conjunction(l, r), conjunction(negate(l), negate(r))
+        );
+      }
+
+      interval_t tomorrow(interval_t const& x, bool weak) const {
+        verdict_t last = {finite && weak, !finite || weak};
+        return {next_bits(x.lo, n, last.lo), next_bits(x.hi, n, last.hi)};
+      }
+
+      interval_t yesterday(interval_t const& x, bool weak, size_t arg) const {
+        verdict_t first = previous ? (*previous)[arg] : verdict_t{weak, weak};
+        return {prev_bits(x.lo, n, first.lo), prev_bits(x.hi, n, first.hi)};
+      }
+
+      interval_t until(interval_t const& l, interval_t const& r) const {
+        return {
+          until_bits(l.lo, r.lo, n, false),
+          until_bits(l.hi, r.hi, n, !finite)
+        };
+      }
+
+      interval_t since(
+        interval_t const& l, interval_t const& r, size_t self, bool negated
+      ) const {
+        verdict_t carry = {false, false};
+        if(previous)
+          carry = negated ? !(*previous)[self] : (*previous)[self];
+        return {
+          since_bits(l.lo, r.lo, carry.lo),
+          since_bits(l.hi, r.hi, carry.hi)
+        };
+      }
+    };
+
+    tribool to_tribool(verdict_t v) {
+      return v.lo ? tribool{true} : !v.hi ? tribool{false} : tribool::undef;
+    }
+  }
+
+  struct monitor::_monitor_t {
+    std::vector<proposition> propositions;
+    std::vector<instruction_t> program;
+    size_t lookahead;
+
+    // the values of each proposition over the states of the window
+    std::vector<bits_t> states;
+    size_t window = 0;
+
+    // the values of each subformula at the state before the window, if any
+    std::optional<std::vector<verdict_t>> previous;
+
+    // whether finish() has been called
+    bool finished = false;
+
+    std::vector<interval_t> evaluate(bool finite) const {
+      window_domain domain{
+        states, window, previous ? &*previous : nullptr, finite
+      };
+      return tracecheck::evaluate(program, domain);
+    }
+  };
+
+  monitor::monitor(formula f, size_t lookahead)
+    : _data{std::make_unique<_monitor_t>()} 
+  { 
+    trace_checker checker{f};
+    _data->propositions = std::move(checker._data->propositions);
+    _data->program = std::move(checker._data->program);
+    _data->lookahead = lookahead;
+    _data->states.resize(
+      _data->propositions.size(), bits_t(words(lookahead + 1))
+    );
+  }
+
+  monitor::~monitor() = default;
+
+  monitor::monitor(monitor &&) = default;
+  monitor &monitor::operator=(monitor &&) = default;
+
+  std::vector<proposition> const& monitor::propositions() const {
+    return _data->propositions;
+  }
+
+  //
+  // When the window is full, the values at its first state are those given
+  // by the states seen so far, and they are kept for the evaluation of past
+  // operators at the next state, so the values of the states leaving the
+  // window are never computed again.
+  //
+  std::optional<tribool> monitor::push(std::vector<bool> const& state) {
+    black_assert(!_data->finished);
+    black_assert(state.size() == _data->states.size());
+
+    for(size_t p = 0; p < state.size(); ++p)
+      put(_data->states[p], _data->window, state[p]);
+    _data->window++;
+
+    if(_data->window <= _data->lookahead)
+      return {};
+
+    std::vector<interval_t> values = _data->evaluate(false);
+
+    std::vector<verdict_t> first;
+    first.reserve(values.size());
+    for(interval_t const& v : values)
+      first.push_back({get(v.lo, 0), get(v.hi, 0)});
+    
+    for(bits_t &s : _data->states)
+      s = next_bits(s, _data->window, false);
+    _data->window--;
+    _data->previous = std::move(first);
+
+    return to_tribool(_data->previous->back());
+  }
+
+  std::vector<tribool> monitor::finish(bool finite) {
+    black_assert(!_data->finished);
+    _data->finished = true;
+
+    if(_data->window == 0)
+      return {};
+
+    std::vector<interval_t> values = _data->evaluate(finite);
+    
+    std::vector<tribool> verdicts;
+    for(size_t t = 0; t < _data->window; ++t)
+      verdicts.push_back(
+        to_tribool({get(values.back().lo, t), get(values.back().hi, t)})
+      );
+    
+    return verdicts;
+  }
+}
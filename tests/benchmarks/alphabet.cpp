@@ -0,0 +1,94 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2023 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/logic/logic.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace black;
+
+//
+// Micro-benchmark of node creation in the alphabet. Each thread builds the
+// same number of nodes, mimicking the unraveling of a formula: half of them
+// are private to the thread (e.g. the stepped propositions of different
+// steps), and half are shared with all the other threads (e.g. the common
+// subformulas), so both insertions and lookups of existing nodes are measured.
+//
+static void work(alphabet &sigma, size_t thread, size_t n) {
+  std::string tag = "t" + std::to_string(thread) + "_";
+  formula acc = sigma.top();
+  for(size_t i = 0; i < n; ++i) {
+    auto own = sigma.proposition(tag + std::to_string(i));
+    auto shared = sigma.proposition(i);
+    acc = (own || X(shared)) && (!own || acc);
+  }
+}
+
+static double run(size_t n_threads, size_t n, bool concurrent) {
+  alphabet sigma;
+  if(concurrent)
+    sigma.make_concurrent();
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for(size_t t = 0; t < n_threads; ++t)
+    threads.emplace_back([&, t]() { work(sigma, t, n); });
+  for(auto &t : threads)
+    t.join();
+
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  size_t n = 200000;
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  try {
+    if(argc > 1)
+      n = std::stoul(argv[1]);
+    if(argc > 2)
+      max_threads = std::stoul(argv[2]);
+  } catch(std::exception const&) {
+    std::cerr << "Usage: " << argv[0] << " [iterations] [max threads]\n";
+    return 1;
+  }
+
+  double base = run(1, n, false);
+  std::cout << "sequential alphabet, 1 thread: " << base << "s\n";
+
+  for(size_t t = 1; t <= max_threads; t *= 2) {
+    double secs = run(t, n, true);
+    std::cout << "concurrent alphabet, " << t << " thread(s): " << secs 
+              << "s, " << (double(t * n) / secs) / (double(n) / base)
+              << "x the sequential throughput\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2023 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/logic/logic.hpp>
+#include <black/logic/parser.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+using namespace black;
+
+//
+// Micro-benchmark of the parser throughput. The input is either the file
+// given on the command line (e.g. the output of one of the generators in
+// `tests/formulas_generators`), or a big synthetic formula made of `n`
+// temporal clauses over a pool of propositions and first-order atoms. The
+// formula is parsed both from an in-memory buffer and from a stream.
+//
+static std::string synthetic(size_t n) {
+  std::string s;
+  for(size_t i = 0; i < n; ++i) {
+    std::string p = "p" + std::to_string(i % 1000);
+    std::string q = "q_" + std::to_string((i * 7) % 1000);
+    if(i > 0)
+      s += " && ";
+    switch(i % 4) {
+      case 0:
+        s += "G(" + p + " -> F(" + q + " || X " + p + "))";
+        break;
+      case 1:
+        s += "(" + p + " U !" + q + ") || wX(" + q + ")";
+        break;
+      case 2:
+        s += "r(x" + std::to_string(i % 10) + ", y + 1) && next(y) >= 2.5";
+        break;
+      case 3:
+        s += "{raw " + q + "} <-> Y " + p;
+        break;
+    }
+  }
+  return s;
+}
+
+template<typename F>
+static double measure(std::string const& name, size_t bytes, F parse) {
+  alphabet sigma;
+  auto start = std::chrono::steady_clock::now();
+  
+  std::optional<formula> f = parse(sigma);
+
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+  if(!f) {
+    std::cerr << name << ": parsing failed\n";
+    return 0;
+  }
+  
+  double mb = double(bytes) / (1024 * 1024);
+  std::cout << name << ": " << elapsed.count() << "s, " 
+            << mb / elapsed.count() << " MB/s\n";
+  return elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  std::string input;
+  
+  try {
+    if(argc > 1 && std::string_view{argv[1]}.find_first_not_of("0123456789") 
+                   != std::string_view::npos) 
+    {
+      std::ifstream file{argv[1]};
+      if(!file) {
+        std::cerr << "Unable to open file " << argv[1] << "\n";
+        return 1;
+      }
+      input.assign(
+        std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}
+      );
+    } else
+      input = synthetic(argc > 1 ? std::stoul(argv[1]) : 200000);
+  } catch(std::exception const&) {
+    std::cerr << "Usage: " << argv[0] << " [clauses | file]\n";
+    return 1;
+  }
+
+  auto error = [](std::string e) { std::cerr << "error: " << e << "\n"; };
+
+  std::cout << "input size: " << input.size() << " bytes\n";
+  
+  measure("buffer", input.size(), [&](alphabet &sigma) {
+    return parse_formula(sigma, std::string_view{input}, error);
+  });
+
+  measure("stream", input.size(), [&](alphabet &sigma) {
+    std::istringstream stream{input};
+    return parse_formula(sigma, stream, error);
+  });
+
+  return 0;
+}
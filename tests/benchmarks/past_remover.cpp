@@ -0,0 +1,151 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2023 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/logic/logic.hpp>
+#include <black/logic/parser.hpp>
+#include <black/logic/past_remover.hpp>
+#include <black/solver/solver.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace black;
+
+//
+// Benchmark of `--remove-past` against the native encoding of past operators.
+// Each formula listed in the given index file (e.g. 
+// `benchmarks/formulas/past.index`, whose paths are relative to the directory
+// of the index) is solved both as it is and after `remove_past()`, with the
+// given bound and timeout (in seconds) for each run. The time taken by the
+// translation itself is reported separately.
+//
+struct run_t {
+  double time = 0;
+  tribool result = tribool::undef;
+};
+
+static run_t solve(scope const& xi, formula f, size_t bound, size_t timeout) {
+  black::solver slv;
+
+  auto start = std::chrono::steady_clock::now();
+  tribool result = slv.solve(
+    xi, f, /*finite=*/false, bound, std::chrono::seconds(timeout), 
+    /*semi_decision=*/false
+  );
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+
+  return {elapsed.count(), result};
+}
+
+static std::string result_string(tribool t) {
+  return t == true ? "SAT" : t == false ? "UNSAT" : "UNKNOWN";
+}
+
+int main(int argc, char **argv) {
+  if(argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <index> [bound] [timeout]\n";
+    return 1;
+  }
+
+  std::filesystem::path index = argv[1];
+  size_t bound = std::numeric_limits<size_t>::max();
+  size_t timeout = 10;
+  
+  try {
+    if(argc > 2)
+      bound = std::stoul(argv[2]);
+    if(argc > 3)
+      timeout = std::stoul(argv[3]);
+  } catch(std::exception const&) {
+    std::cerr << "Usage: " << argv[0] << " <index> [bound] [timeout]\n";
+    return 1;
+  }
+
+  std::ifstream index_file{index};
+  if(!index_file) {
+    std::cerr << "Unable to open file " << index << "\n";
+    return 1;
+  }
+
+  double native_total = 0, removed_total = 0, translation_total = 0;
+  size_t native_solved = 0, removed_solved = 0, mismatches = 0;
+
+  std::string line;
+  while(std::getline(index_file, line)) {
+    if(line.empty())
+      continue;
+
+    std::ifstream file{index.parent_path() / line};
+    if(!file) {
+      std::cerr << "Unable to open file " << line << "\n";
+      continue;
+    }
+
+    alphabet sigma;
+    scope xi{sigma};
+    auto f = parse_formula(sigma, file, [&](std::string error) {
+      std::cerr << line << ": " << error << "\n";
+    });
+    if(!f)
+      continue;
+
+    auto start = std::chrono::steady_clock::now();
+    formula removed = remove_past(*f);
+    std::chrono::duration<double> translation = 
+      std::chrono::steady_clock::now() - start;
+
+    run_t native = solve(xi, *f, bound, timeout);
+    run_t rp = solve(xi, removed, bound, timeout);
+
+    native_total += native.time;
+    removed_total += rp.time + translation.count();
+    translation_total += translation.count();
+    native_solved += native.result != tribool::undef;
+    removed_solved += rp.result != tribool::undef;
+
+    bool mismatch = native.result != tribool::undef && 
+      rp.result != tribool::undef && native.result != rp.result;
+    mismatches += mismatch;
+
+    std::cout << line 
+              << " native: " << native.time << "s " 
+              << result_string(native.result)
+              << " remove-past: " << rp.time << "s " 
+              << result_string(rp.result)
+              << " (translation: " << translation.count() << "s)"
+              << (mismatch ? " MISMATCH" : "") << std::endl;
+  }
+
+  std::cout << "native: " << native_total << "s, " 
+            << native_solved << " solved\n"
+            << "remove-past: " << removed_total << "s (translation: " 
+            << translation_total << "s), " << removed_solved << " solved\n"
+            << "mismatches: " << mismatches << "\n";
+
+  return mismatches > 0;
+}
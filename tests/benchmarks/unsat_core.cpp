@@ -0,0 +1,119 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2023 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <black/logic/logic.hpp>
+#include <black/logic/parser.hpp>
+#include <black/logic/prettyprint.hpp>
+#include <black/solver/solver.hpp>
+#include <black/solver/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace black;
+
+//
+// Benchmark of the parallel extraction of unsat cores. The formula in the
+// given file is checked to be unsatisfiable, and then its core is computed
+// with 1, 2, 4, ... threads, reporting the time taken and the number of
+// subformulas replaced by placeholders. Each run uses a fresh alphabet,
+// because the parallel runs switch it to concurrent mode.
+//
+static size_t placeholders(formula f) {
+  size_t n = 0;
+  fold<size_t>(f, [&](formula g, auto const&) -> size_t {
+    if(auto p = g.to<proposition>(); p && p->name().is<core_placeholder_t>())
+      n++;
+    return 0;
+  });
+  return n;
+}
+
+static std::optional<formula> 
+read(alphabet &sigma, std::string const& path) {
+  std::ifstream file{path};
+  if(!file) {
+    std::cerr << "Unable to open file " << path << "\n";
+    return {};
+  }
+
+  return parse_formula(sigma, file, [&](std::string error) {
+    std::cerr << path << ": " << error << "\n";
+  });
+}
+
+int main(int argc, char **argv) {
+  if(argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <file> [max threads] [finite]\n";
+    return 1;
+  }
+
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  bool finite = false;
+
+  try {
+    if(argc > 2)
+      max_threads = std::stoul(argv[2]);
+    if(argc > 3)
+      finite = std::stoul(argv[3]) != 0;
+  } catch(std::exception const&) {
+    std::cerr << "Usage: " << argv[0] << " <file> [max threads] [finite]\n";
+    return 1;
+  }
+
+  double base = 0;
+  for(size_t t = 1; t <= max_threads; t *= 2) {
+    alphabet sigma;
+    scope xi{sigma};
+    auto f = read(sigma, argv[1]);
+    if(!f)
+      return 1;
+
+    if(t == 1) {
+      black::solver slv;
+      if(slv.solve(xi, *f, finite) != false) {
+        std::cerr << argv[1] << ": the formula is not unsatisfiable\n";
+        return 1;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    formula muc = unsat_core(xi, *f, finite, t);
+    std::chrono::duration<double> elapsed = 
+      std::chrono::steady_clock::now() - start;
+
+    if(t == 1)
+      base = elapsed.count();
+
+    std::cout << t << " thread(s): " << elapsed.count() << "s, " 
+              << base / elapsed.count() << "x, "
+              << placeholders(muc) << " placeholder(s): " 
+              << to_string(muc) << std::endl;
+  }
+
+  return 0;
+}
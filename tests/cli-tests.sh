@@ -38,6 +38,9 @@ trap 'if [[ ! -z "$first_err_command" ]]; then
 ./black solve -c -f 'G((p U (q & w)) & c) & F((r U s) & !c)' | grep UNSAT
 ./black solve -c -f 'G((p U (q & w)) & c) & F((r U True) & False)' --debug uc-replacements | \
   grep 'MUC: {0} & F({1} & False)'
+./black solve -c --unsat-core-bound 2 \
+  -f 'G((p U (q & w)) & c) & F((r U True) & False)' --debug uc-replacements | \
+  grep 'MUC: {0} & F({1} & False)'
 ./black solve -o json -f 'p & !p' | ./black check -t - -f 'p & !p'
 ./black solve -o json -f 'p & q' | ./black check -t - -f 'p & q'
 
@@ -67,6 +70,8 @@ should_fail ./black solve -s -f 'x = 0'
 ./black solve -d Int -f 'r(prev(x))' 2>&1 | grep -- '--semi-decision'
 ./black solve -d Int -f 'r(wprev(x))' 2>&1 | grep -- '--semi-decision'
 
+./black solve --timed-encoding -s -d Int -f 'x = 0 & G(wnext(x) = x + 1) & F(x = 3)' | grep SAT
+
 ./black solve -f 'p & q' --debug print
 ./black solve -f 'X p & X X q & F(q)' --debug trace
 ./black solve -f 'X p & X X q & F(q)' --debug trace-full
@@ -85,6 +90,18 @@ END
 
 rm -f black-trace-*
 
+./black solve --dump-smtlib black-dump -f 'G p & F !p' | grep UNSAT
+grep -q "(check-sat-assuming" black-dump/black.smt2
+./black solve -s -d Int --dump-smtlib black-dump - <<END
+x = 0 & G(wnext(x) = x + 1) & F(x = 3)
+END
+grep -q "(check-sat)" black-dump/black.smt2
+echo 'G(exists (y : Int) . y > x) & F(x < 0)' > black-dump-test.pltl
+./black solve -d Int -k 2 --dump-smtlib black-dump black-dump-test.pltl
+grep -q "(push 1)" black-dump/black-dump-test.smt2
+
+rm -rf black-dump black-dump-test.pltl
+
 should_fail ./black check -t ../tests/test-trace.json
 should_fail ./black check -t - -f 'p' file.pltl
 should_fail ./black check -t - -
@@ -194,4 +211,49 @@ cat <<END | should_fail ./black check -t - -f 'p & !p'
     "k": 1,
     "muc": "p & {0}"
 }
-END
\ No newline at end of file
+END
+should_fail ./black monitor
+should_fail ./black monitor -f p -
+should_fail ./black monitor -f 'x > 0'
+echo '{"p": 1}' | should_fail ./black monitor -f p
+echo '[1]' | should_fail ./black monitor -f p
+
+cat <<END | should_fail ./black monitor -l 1 --finite -f 'req -> X ack' \
+  > black-monitor.txt
+{"req": "true"}
+{"req": false, "ack": true}
+
+{"req": "true", "ack": "undef"}
+END
+grep -q "0: TRUE" black-monitor.txt
+grep -q "1: TRUE" black-monitor.txt
+grep -q "2: FALSE" black-monitor.txt
+rm black-monitor.txt
+
+cat <<END | should_fail ./black monitor -f 'ack -> O req'
+{"req": false}
+{"ack": true}
+END
+
+mkdir -p black-traces
+./black solve -m -o json -f 'p & X q' > black-traces/good.json
+./black solve -m -o json -f '!p' > black-traces/bad.json
+should_fail ./black check -f p
+should_fail ./black check -t black-traces/good.json --traces black-traces -f p
+should_fail ./black check --traces black-traces/missing -f p
+
+./black check --traces black-traces -f 'F q' > black-traces.txt
+grep -q "TRUE .*good.json" black-traces.txt
+grep -q "2 traces (0 failed)" black-traces.txt
+
+echo '{' > black-traces/broken.json
+should_fail ./black check --traces black-traces -f p > black-traces.txt
+grep -q "FALSE .*bad.json" black-traces.txt
+grep -q "ERROR .*broken.json" black-traces.txt
+
+printf 'good.json\n\nmissing.json\n' > black-traces/index
+echo p | should_fail ./black check --traces black-traces/index - \
+  > black-traces.txt
+grep -q "TRUE .*good.json" black-traces.txt
+grep -q "ERROR .*missing.json" black-traces.txt
+rm -rf black-traces black-traces.txt
@@ -24,8 +24,11 @@
 #include <catch.hpp>
 
 #include <black/logic/logic.hpp>
+#include <black/logic/prettyprint.hpp>
 
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <type_traits>
 #include <ranges>
 
@@ -33,6 +36,30 @@ using namespace std::literals;
 using namespace black;
 using black_internal::identifier;
 
+//
+// A label type without a `trace_nodes()` overload, which hides the formula
+// it holds from the garbage collector of the alphabet
+//
+namespace opaque {
+  struct opaque_label {
+    formula f;
+
+    bool operator==(opaque_label const&) const = default;
+  };
+
+  inline std::string to_string(opaque_label const&) {
+    return "opaque";
+  }
+}
+using opaque::opaque_label;
+
+template<>
+struct std::hash<opaque_label> {
+  size_t operator()(opaque_label const& l) const {
+    return std::hash<formula>{}(l.f);
+  }
+};
+
 static_assert(black::hierarchy<formula>);
 static_assert(black::hierarchy<proposition>);
 static_assert(black::hierarchy<unary>);
@@ -533,6 +560,79 @@ TEST_CASE("New API") {
     ));
   }
 
+  SECTION("Node summaries") {
+    using namespace black;
+
+    proposition p = sigma.proposition("p");
+    variable x = sigma.variable("x");
+    formula f = G(p && X(p)) && next(x) > x;
+
+    REQUIRE(tree_size(p) == 1);
+    REQUIRE(tree_depth(p) == 1);
+    REQUIRE(tree_size(f) == 10);
+    REQUIRE(tree_depth(f) == 5);
+
+    REQUIRE(has_future_operators(f));
+    REQUIRE(!has_past_operators(f));
+    REQUIRE(has_next_terms(f));
+    REQUIRE(has_past_operators(Y(f)));
+    REQUIRE(!has_next_terms(G(p)));
+    REQUIRE(!has_any_element_of(f, syntax_element::boolean));
+  }
+
+  SECTION("Folds") {
+    using namespace black;
+
+    proposition p = sigma.proposition("p");
+    proposition q = sigma.proposition("q");
+    formula shared = F(p && q);
+    formula f = G(shared) || (shared && X(shared));
+
+    size_t visits = 0;
+    size_t size = fold<size_t>(f, [&](formula g, auto const& result) {
+      visits++;
+      size_t n = 1;
+      for_each_child(g, overloaded {
+        [&](formula child) { n += result(child); },
+        [](otherwise) { }
+      });
+      return n;
+    });
+
+    REQUIRE(size == tree_size(f));
+    REQUIRE(visits == 8);
+
+    formula swapped = fold<formula>(f, [&](formula g, auto const& result) {
+      return g.match(
+        [&](proposition a) -> formula { return a == p ? q : p; },
+        [&](unary u, formula arg) -> formula { 
+          return unary(u.node_type(), result(arg)); 
+        },
+        [&](binary b, formula l, formula r) -> formula {
+          return binary(b.node_type(), result(l), result(r));
+        },
+        [](otherwise) -> formula { black_unreachable(); }
+      );
+    });
+
+    formula shared2 = F(q && p);
+    REQUIRE(swapped == (G(shared2) || (shared2 && X(shared2))));
+
+    formula deep = p;
+    for(size_t i = 0; i < 100000; ++i)
+      deep = X(deep) && q;
+
+    size_t depth = fold<size_t>(deep, [](formula g, auto const& result) {
+      size_t d = 0;
+      for_each_child(g, overloaded {
+        [&](formula child) { d = std::max(d, result(child)); },
+        [](otherwise) { }
+      });
+      return d + 1;
+    });
+    REQUIRE(depth == tree_depth(deep));
+  }
+
   SECTION("big_and, big_or, etc...") {
     using namespace black;
 
@@ -546,6 +646,155 @@ TEST_CASE("New API") {
       return !p;
     });
 
-    REQUIRE(t == (((!p1 && !p2) && !p3) && !p4));
+    REQUIRE(t == (!p1 && !p2 && !p3 && !p4));
+    REQUIRE(t != big_conjunction(std::vector<formula>{!p1, !p2, !p3, !p4}));
+    REQUIRE(tree_size(t) == 11);
+    REQUIRE(std::ranges::distance(operands(*t.to<conjunction>())) == 4);
+
+    auto n = big_conjunction(std::vector<formula>{!p1, !p2, !p3, !p4});
+    REQUIRE(tree_size(n) == 9);
+    REQUIRE(std::ranges::distance(operands(n)) == 4);
+    REQUIRE(to_string(n) == to_string(t));
+
+    REQUIRE(big_and(sigma, std::vector{p1, p2}) == (p1 && p2));
+    REQUIRE(big_or(sigma, std::vector{p1}) == p1);
+    REQUIRE(big_or(sigma, std::vector<proposition>{}) == sigma.bottom());
+    
+    auto u = big_or(sigma, v, [&](auto p) -> formula {
+      if(p == p2)
+        return sigma.bottom();
+      return X(p);
+    });
+    REQUIRE(u == (X(p1) || X(p3) || X(p4)));
+    REQUIRE(to_string(u) == "X p1 | X p3 | X p4");
+    REQUIRE(to_string(!u && p1) == "!(X p1 | X p3 | X p4) & p1");
+  }
+
+  SECTION("Concurrent alphabet") {
+    using namespace black;
+
+    REQUIRE(!sigma.is_concurrent());
+
+    auto p = sigma.proposition("p");
+    formula before = G(F(p));
+
+    sigma.make_concurrent();
+    REQUIRE(sigma.is_concurrent());
+    REQUIRE(sigma.proposition("p") == p);
+
+    constexpr size_t n_threads = 4;
+    constexpr int n_props = 200;
+
+    std::vector<std::vector<formula>> results(n_threads);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < n_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        for(int i = 0; i < n_props; ++i) {
+          auto q = sigma.proposition("q" + std::to_string(i));
+          results[t].push_back(G(F(p)) && X(q || !q));
+        }
+      });
+    }
+    for(auto &t : threads)
+      t.join();
+
+    for(size_t t = 0; t < n_threads; ++t) {
+      REQUIRE(results[t].size() == n_props);
+      for(int i = 0; i < n_props; ++i) {
+        REQUIRE(results[t][i] == results[0][i]);
+        REQUIRE(results[t][i].to<conjunction>()->left() == before);
+      }
+    }
+  }
+
+  SECTION("Compact handles") {
+    using namespace black;
+
+    static_assert(sizeof(compact<formula>) == sizeof(uint32_t));
+    static_assert(std::is_trivially_copyable_v<compact<formula>>);
+
+    proposition p = sigma.proposition("p");
+    variable x = sigma.variable("x");
+    formula f = G(p && X(x > 0));
+
+    compact<formula> cf = f;
+    compact<formula> cp = p;
+    compact<term> cx = x;
+
+    REQUIRE(cf.get(&sigma) == f);
+    REQUIRE(cp.get(&sigma) == p);
+    REQUIRE(cx.get(&sigma) == x);
+    REQUIRE(cf == compact<formula>{G(p && X(x > 0))});
+    REQUIRE(cf != cp);
+    REQUIRE(compact<formula>{sigma.top()}.get(&sigma) == sigma.top());
+
+    std::unordered_map<compact<formula>, compact<formula>> map;
+    map.insert({f, p});
+    REQUIRE(map.find(f) != map.end());
+    REQUIRE(map.at(f).get(&sigma) == p);
+
+    auto r = sigma.open_region();
+    compact<formula> fresh = F(sigma.proposition("fresh"));
+    sigma.release(r);
+    REQUIRE(fresh.index() > cf.index());
+    REQUIRE(compact<formula>{F(sigma.proposition("fresh"))} != fresh);
+  }
+
+  SECTION("Memory regions") {
+    using namespace black;
+
+    auto count = [&](storage_type storage) -> size_t {
+      for(auto u : sigma.memory_usage())
+        if(u.storage == storage)
+          return u.nodes;
+      return 0;
+    };
+
+    auto p = sigma.proposition("p");
+    formula old = G(p);
+
+    size_t unaries = count(storage_type::unary);
+    size_t props = count(storage_type::proposition);
+
+    auto r = sigma.open_region();
+
+    auto q = sigma.proposition("q");
+    formula f = F(p && q);
+    auto kept = sigma.proposition(std::pair{f, 1000});
+    for(int i = 0; i < 100; ++i)
+      (void)X(sigma.proposition(std::pair{f, i}));
+
+    REQUIRE(count(storage_type::unary) == unaries + 101);
+    REQUIRE(count(storage_type::proposition) == props + 102);
+
+    sigma.release(r, std::vector<formula>{kept});
+
+    // `kept` and its label's formula survive, with their children
+    REQUIRE(count(storage_type::unary) == unaries + 1);
+    REQUIRE(count(storage_type::proposition) == props + 2);
+    REQUIRE(F(p && sigma.proposition("q")) == f);
+    REQUIRE(sigma.proposition(std::pair{f, 1000}) == kept);
+    REQUIRE(G(p) == old);
+
+    // freed slots are reused
+    auto r2 = sigma.open_region();
+    for(int i = 0; i < 100; ++i)
+      (void)X(sigma.proposition(i));
+    REQUIRE(count(storage_type::unary) == unaries + 101);
+    
+    sigma.release(r2);
+    REQUIRE(count(storage_type::unary) == unaries + 1);
+    REQUIRE(count(storage_type::proposition) == props + 2);
+
+    // region ids are reused after release
+    auto r3 = sigma.open_region();
+    REQUIRE(r3 == r2);
+
+    // a label that cannot be traced keeps everything alive
+    formula g = F(sigma.proposition("g"));
+    auto opaque = sigma.proposition(opaque_label{g});
+    sigma.release(r3, opaque);
+    REQUIRE(count(storage_type::unary) == unaries + 2);
+    REQUIRE(opaque.name().to<opaque_label>()->f == F(sigma.proposition("g")));
   }
 }
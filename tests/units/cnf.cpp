@@ -78,7 +78,16 @@ TEST_CASE("CNF Translation")
     REQUIRE(remove_booleans(iff(top, top)) == top);
     REQUIRE(remove_booleans(iff(p, q)) == iff(p, q));
     
-    
+    proposition r = sigma.proposition("r");
+    auto conj = [](std::vector<formula> v) { return big_conjunction(v); };
+    auto disj = [](std::vector<formula> v) { return big_disjunction(v); };
+
+    REQUIRE(remove_booleans(conj({p, top, q})) == (p && q));
+    REQUIRE(remove_booleans(conj({p, bot, q})) == bot);
+    REQUIRE(remove_booleans(conj({p, !!q, r})) == conj({p, q, r}));
+    REQUIRE(remove_booleans(disj({p, bot, q})) == (p || q));
+    REQUIRE(remove_booleans(disj({p, top, q})) == top);
+    REQUIRE(remove_booleans(disj({bot, !top, p})) == p);
   }
 
   SECTION("CNF of random formulas") {
@@ -94,7 +103,11 @@ TEST_CASE("CNF Translation")
 
     std::vector<formula> tests = {
       p && q, p || q, implies(p, q), iff(p, q),
-      !p, !(p && q), !(p || q), !implies(p, q), !iff(p, q)
+      !p, !(p && q), !(p || q), !implies(p, q), !iff(p, q),
+      big_and(sigma, std::vector<formula>{p, q, !p}), 
+      big_or(sigma, std::vector<formula>{p, q, !p}),
+      !big_and(sigma, std::vector<formula>{p, q, !q}), 
+      !big_or(sigma, std::vector<formula>{p, !q, q})
     };
 
     black::solver s;
@@ -110,5 +123,28 @@ TEST_CASE("CNF Translation")
       }      
     }   
   }
-  
+
+  SECTION("CNF of batches of formulas") {
+    proposition p = sigma.proposition("p");
+    proposition q = sigma.proposition("q");
+    proposition r = sigma.proposition("r");
+    proposition s = sigma.proposition("s");
+
+    std::vector<formula> batch = {(p && q) || r, (p && q) || s, !(p && q)};
+    
+    size_t separate = 0;
+    for(formula f : batch)
+      separate += black::to_cnf(f).clauses.size();
+
+    black::cnf c = black::to_cnf(batch);
+    REQUIRE(c.clauses.size() < separate);
+
+    formula fc = to_formula(sigma, c);
+    formula f = big_and(sigma, batch);
+
+    black::solver slv;
+    REQUIRE(!slv.solve(xi, !implies(fc, f)));
+    REQUIRE(black::to_cnf(std::vector<formula>{p, sigma.bottom()})
+              .clauses.back().literals.empty());
+  }
 }
@@ -22,6 +22,7 @@
 // SOFTWARE.
 
 #include <ostream>
+#include <sstream>
 
 #include <black/logic/logic.hpp>
 #include <black/logic/parser.hpp>
@@ -41,7 +42,10 @@ TEST_CASE("Syntax errors") {
     "exists . p", "exists x y z +", "exists x . (x =)", "p(x",
     "x + y * = x", "F(-)", "next x", "next(x x", "wnext x", "wnext(x x",
     "prev x", "wprev(x x", "next(next(x +)) = x", "wnext(next(x +)) = x", 
-    "p 42", "p 0.1", ",", ".", "x +", "x *", "x -", "x /",
+    "p 42", "p 0.1", ",", ".", "x +", "x *", "x -", "x /", "{p", "{p\\",
+    "let", "let a", "let a p in a", "let 1 = p in p", "let a = p", 
+    "let a = p in", "let a = p && in a", "in",
+    "let a = p && q in a + 1 > 0", "let t = x + 1 in t && p",
     "x = 0.0000000000000000000000000000000000000000000000000000000000000000"
     "0000000000000000000000000000000000000000000000000000000000000000000000"
     "0000000000000000000000000000000000000000000000000000000000000000000000"
@@ -96,7 +100,9 @@ TEST_CASE("Roundtrip of parser and pretty-printer")
     (x + y) * z > 0, -x == y,
     W(p, q), M(p, q), x < y, x <= y, 
     x + 0 == x, x * 1 == x,
-    next(prev(x)) == x, next(wprev(x)) == x
+    next(prev(x)) == x, next(wprev(x)) == x,
+    big_and(sigma, std::vector<formula>{p, q, X(p), !q}),
+    big_or(sigma, std::vector<formula>{p, U(p, q), q && p}) && G(q)
   };
 
   for(formula f : tests) {
@@ -113,5 +119,289 @@ TEST_CASE("Roundtrip of parser and pretty-printer")
       CHECK(*result == f);
     }
   }
+
+  //
+  // n-ary nodes are not canonical, so they are printed as the binary chains
+  // with the same operands, which is what they are parsed back to
+  //
+  std::vector<formula> nary_tests = {
+    big_conjunction(std::vector<formula>{p, q || X(p), G(q)}),
+    big_disjunction(std::vector<formula>{p, q && X(p), G(q), !p}),
+    p || big_conjunction(std::vector<formula>{p, q, F(q)})
+  };
+
+  for(formula f : nary_tests) {
+    DYNAMIC_SECTION("Roundtrip for n-ary formula: " << to_string(f)) {
+      auto result = parse_formula(sigma, to_string(f), [](auto error){
+        INFO("parsing error: " << error);
+        REQUIRE(false);
+      });
+      REQUIRE(result.has_value());
+
+      formula canonical = f.match(
+        [&](big_conjunction c) { return big_and(sigma, operands(c)); },
+        [&](big_disjunction c) { return big_or(sigma, operands(c)); },
+        [&](disjunction, formula l, formula r) -> formula {
+          return l || big_and(sigma, operands(*r.to<big_conjunction>()));
+        },
+        [](otherwise) -> formula { black_unreachable(); }
+      );
+
+      CHECK(*result == canonical);
+      CHECK(to_string(*result) == to_string(f));
+    }
+  }
 }
     
+
+TEST_CASE("Deeply nested formulas")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  variable x = sigma.variable("x");
+
+  size_t const depth = 100000;
+
+  auto repeat = [](std::string_view s, size_t n) {
+    std::string result;
+    for(size_t i = 0; i < n; ++i)
+      result += s;
+    return result;
+  };
+
+  auto parse = [&](std::string const& s) {
+    return parse_formula(sigma, s, [](auto error){
+      INFO("parsing error: " << error);
+      REQUIRE(false);
+    });
+  };
+
+  SECTION("Nested unary operators") {
+    formula expected = p;
+    for(size_t i = 0; i < depth; ++i)
+      expected = X(!expected);
+
+    auto result = parse(repeat("X(!", depth) + "p" + repeat(")", depth));
+
+    REQUIRE(result.has_value());
+    CHECK(*result == expected);
+  }
+
+  SECTION("Nested binary operators") {
+    formula expected = p;
+    for(size_t i = 0; i < depth; ++i)
+      expected = p && (p || expected);
+
+    auto result = 
+      parse(repeat("p && (p || (", depth) + "p" + repeat("))", depth));
+
+    REQUIRE(result.has_value());
+    CHECK(*result == expected);
+  }
+
+  SECTION("Nested terms") {
+    term expected = x;
+    for(size_t i = 0; i < depth; ++i)
+      expected = next((expected + 1));
+
+    auto result = 
+      parse("((" + repeat("next((", depth) + "x" + 
+            repeat(" + 1))", depth) + ")) = x");
+
+    REQUIRE(result.has_value());
+    CHECK(*result == (expected == x));
+  }
+
+  SECTION("Printing") {
+    formula f = p;
+    for(size_t i = 0; i < depth; ++i)
+      f = U(f, p);
+
+    std::string str = to_string(f);
+    REQUIRE(str.size() == depth * 6 - 1);
+
+    auto result = parse(str);
+
+    REQUIRE(result.has_value());
+    CHECK(*result == f);
+  }
+}
+
+TEST_CASE("Let bindings")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  proposition q = sigma.proposition("q");
+  variable x = sigma.variable("x");
+  variable y = sigma.variable("y");
+  function g = sigma.function("g");
+  relation r = sigma.relation("r");
+  sort s = sigma.integer_sort();
+
+  auto parse = [&](std::string const& str) {
+    return parse_formula(sigma, str, [](auto error){
+      INFO("parsing error: " << error);
+      REQUIRE(false);
+    });
+  };
+
+  SECTION("Parsing") {
+    std::vector<std::pair<std::string, formula>> tests = {
+      {"let a = p && q in a || X a", (p && q) || X(p && q)},
+      {"let a = p in let b = a U q in b && !b", U(p, q) && !U(p, q)},
+      {"let a = p in (let a = q in a) && a", q && p},
+      {"let t = x + 1 in t > 0 && g(t) = t", (x + 1 > 0) && g(x + 1) == x + 1},
+      {"let t = g(x) in (t) * 2 = y", g(x) * 2 == y},
+      {"let a = r(x) in let x = y in a && x = y", r(x) && y == y},
+      {"let x = y in exists (x : Int) . x = x", exists({x[s]}, x == x)},
+      {"p && let a = q in a || a", p && (q || q)}
+    };
+
+    for(auto [str, f] : tests) {
+      DYNAMIC_SECTION("Formula: " << str) {
+        auto result = parse(str);
+
+        REQUIRE(result.has_value());
+        CHECK(*result == f);
+      }
+    }
+  }
+
+  SECTION("Roundtrip") {
+    std::vector<formula> tests = {
+      p, X(p) && F(X(p)), (x + y > 0) || G(x + y > 0),
+      forall({x[s]}, (g(x) == g(x) + 1) && r(g(x))) && r(g(x)),
+      exists({y[s]}, X(p && q) && (!(p && q) || y == y)),
+    };
+
+    for(formula f : tests) {
+      DYNAMIC_SECTION("Formula: " << to_string(f)) {
+        std::string str = to_string(f, print_sharing::let);
+        INFO("printed: " << str);
+
+        auto result = parse(str);
+
+        REQUIRE(result.has_value());
+        CHECK(*result == f);
+      }
+    }
+  }
+
+  SECTION("Names do not clash with propositions and variables") {
+    formula f = sigma.proposition("_1") && X(p && q) && F(X(p && q));
+    std::string str = to_string(f, print_sharing::let);
+
+    REQUIRE(str.find("let _2 = ") != std::string::npos);
+
+    auto result = parse(str);
+    REQUIRE(result.has_value());
+    CHECK(*result == f);
+  }
+
+  SECTION("Output linear in the size of the DAG") {
+    formula f = p;
+    for(int i = 0; i < 40; ++i)
+      f = U(f, X(f));
+
+    std::string str = to_string(f, print_sharing::let);
+    REQUIRE(str.size() < 2000);
+
+    auto result = parse(str);
+    REQUIRE(result.has_value());
+    CHECK(*result == f);
+  }
+
+  SECTION("Streaming to std::ostream") {
+    formula f = forall({x[s]}, g(x) > 0 && X(g(x) > 0)) || X(g(x) > 0);
+
+    for(auto sharing : {print_sharing::expand, print_sharing::let}) {
+      std::ostringstream str;
+      print(str, f, sharing);
+
+      CHECK(str.str() == to_string(f, sharing));
+    }
+  }
+}
+
+TEST_CASE("SMT-LIB output")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  proposition q = sigma.proposition("q");
+  variable x = sigma.variable("x");
+  variable y = sigma.variable("y");
+  
+  scope xi{sigma};
+  xi.set_default_sort(sigma.integer_sort());
+
+  auto id = [](auto h) {
+    using black_internal::to_underlying;
+    return "|" + std::to_string(to_underlying(h.unique_id())) + "|";
+  };
+
+  SECTION("Equalities") {
+    std::string str = to_smtlib2(equal(std::vector<term>{x, y, x + 1}), xi);
+
+    CHECK(
+      str.find("(= " + id(x) + " " + id(y) + " (+ " + id(x) + " 1))") != 
+        std::string::npos
+    );
+  }
+
+  SECTION("Sharing") {
+    formula f = p;
+    for(int i = 0; i < 40; ++i)
+      f = (f || q) && !(f || q);
+
+    std::string str = to_smtlib2(f, xi, print_sharing::let);
+
+    CHECK(str.find("(let (") != std::string::npos);
+    CHECK(str.size() < 5000);
+  }
+
+  SECTION("Names are not used inside quantifiers") {
+    formula f = 
+      (x > 0 && y > 0) || (x > 0 && q) || 
+      exists({x[sigma.integer_sort()]}, x > 0);
+
+    std::string str = to_smtlib2(f, xi, print_sharing::let);
+    std::string atom = "(> " + id(x) + " 0)";
+
+    size_t first = str.find(atom);
+    REQUIRE(first != std::string::npos);
+    CHECK(str.find("(let ((|_1| " + atom + ")) ") != std::string::npos);
+    CHECK(str.find(atom, first + 1) != std::string::npos);
+    CHECK(str.find("(and |_1| ") != std::string::npos);
+  }
+
+  SECTION("Incremental scripts") {
+    std::ostringstream out;
+    smtlib2_script script{out};
+
+    script.assert_formula(p && x > 0, xi);
+    script.check_sat();
+    script.assert_formula(p || q, xi);
+    script.check_sat_assuming(q, xi);
+    script.check_sat_assuming(p && y > x, xi);
+
+    std::string str = out.str();
+    auto count = [&](std::string const& s) {
+      size_t n = 0;
+      for(size_t i = str.find(s); i != std::string::npos; ++n)
+        i = str.find(s, i + 1);
+      return n;
+    };
+
+    CHECK(count("(declare-const " + id(p) + " Bool)") == 1);
+    CHECK(count("(declare-const " + id(q) + " Bool)") == 1);
+    CHECK(count("(declare-const " + id(x) + " Int)") == 1);
+    CHECK(count("(declare-const " + id(y) + " Int)") == 1);
+    CHECK(str.find("(declare-const " + id(y)) > str.find("(check-sat)"));
+    CHECK(count("(check-sat-assuming (" + id(q) + "))") == 1);
+    CHECK(count("(push 1)") == 1);
+    CHECK(count("(pop 1)") == 1);
+  }
+}
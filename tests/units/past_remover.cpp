@@ -90,18 +90,22 @@ TEST_CASE("Translation for basic past formulas")
   std::vector<test> tests = {
       {Y(p),    p_Y && (!p_Y && G(implies(X(p_Y), p) && implies(p, wX(p_Y))))},
       {Z(p),    p_Z && (p_Z && G(implies(X(p_Z), p) && implies(p, wX(p_Z))))},
-      {S(p,q),  (p_S && (G(iff(p_S, q || (p && p_YS)))
-                && (!p_YS 
-                  && G(implies(X(p_YS), p_S) && implies(p_S, wX(p_YS))))))},
-      {T(p,q),  (!p_T && (G(iff(p_T, !q || (!p && p_YT)))
-                && (!p_YT 
-                  && G(implies(X(p_YT), p_T) && implies(p_T, wX(p_YT))))))},
-      {O(p),    (p_P && (G(iff(p_P, p || (sigma.top() && p_YP)))
-                && (!p_YP 
-                  && G(implies(X(p_YP), p_P) && implies(p_P, wX(p_YP))))))},
-      {H(p),    (!p_H && (G(iff(p_H, !p || (sigma.top() && p_YH)))
-                && (!p_YH 
-                  && G(implies(X(p_YH), p_H) && implies(p_H, wX(p_YH))))))}
+      {S(p,q),  big_and(sigma, std::vector<formula>{
+                  p_S, G(iff(p_S, q || (p && p_YS))),
+                  !p_YS && G(implies(X(p_YS), p_S) && implies(p_S, wX(p_YS)))
+                })},
+      {T(p,q),  big_and(sigma, std::vector<formula>{
+                  !p_T, G(iff(p_T, !q || (!p && p_YT))),
+                  !p_YT && G(implies(X(p_YT), p_T) && implies(p_T, wX(p_YT)))
+                })},
+      {O(p),    big_and(sigma, std::vector<formula>{
+                  p_P, G(iff(p_P, p || (sigma.top() && p_YP))),
+                  !p_YP && G(implies(X(p_YP), p_P) && implies(p_P, wX(p_YP)))
+                })},
+      {H(p),    big_and(sigma, std::vector<formula>{
+                  !p_H, G(iff(p_H, !p || (sigma.top() && p_YH))),
+                  !p_YH && G(implies(X(p_YH), p_H) && implies(p_H, wX(p_YH)))
+                })}
   };
 
   for(test t : tests) {
@@ -124,3 +128,54 @@ TEST_CASE("Translation for basic past formulas")
     }
   }
 }
+
+TEST_CASE("Translation of shared past subformulas")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  proposition p_Y = past_label(Y(p));
+
+  SECTION("Each label gets its semantics once") {
+    std::vector<formula> ops;
+    for(size_t i = 0; i < 100; ++i)
+      ops.push_back(G(implies(Y(p), sigma.proposition(i))));
+    
+    formula f = big_and(sigma, ops);
+    formula result = remove_past(f);
+
+    formula yesterday = 
+      !p_Y && G(implies(X(p_Y), p) && implies(p, wX(p_Y)));
+
+    REQUIRE(result.is<conjunction>());
+    CHECK(result.to<conjunction>()->right() == yesterday);
+    CHECK(!has_any_element_of(
+      result.to<conjunction>()->left(), syntax_element::yesterday
+    ));
+  }
+
+  SECTION("The translation is linear in the size of the DAG") {
+    formula f = p;
+    for(size_t i = 0; i < 40; ++i)
+      f = S(f, Y(f));
+
+    formula result = remove_past(f);
+
+    size_t conjuncts = 1;
+    for(formula g = result; g.is<conjunction>(); ) {
+      conjuncts++;
+      g = g.to<conjunction>()->left();
+    }
+    CHECK(conjuncts == 82);
+  }
+
+  SECTION("Deep formulas do not overflow the stack") {
+    formula f = p;
+    for(size_t i = 0; i < 100000; ++i)
+      f = Y(f);
+
+    formula result = remove_past(f);
+
+    CHECK(!has_any_element_of(result, syntax_element::yesterday));
+  }
+}
@@ -60,3 +60,143 @@ TEST_CASE("SAT backends") {
   }
   
 }
+
+TEST_CASE("Batched assertions") {
+
+  std::vector<std::string> backends = {
+    "z3", "mathsat", "cmsat", "cvc5"
+  };
+
+  black::alphabet sigma;
+  black::scope xi{sigma};
+
+  auto p = sigma.proposition("p");
+  auto q = sigma.proposition("q");
+  auto r = sigma.proposition("r");
+
+  for(auto backend : backends) {
+    DYNAMIC_SECTION("SAT backend: " << backend) {
+      if(black::sat::solver::backend_exists(backend)) {
+        auto slv = black::sat::solver::get_solver(backend, xi);
+
+        std::vector<black::formula> fs = { p || q, !p, implies(q, r) };
+        slv->assert_formulas(fs);
+
+        REQUIRE(slv->is_sat());
+        REQUIRE(slv->value(p) == false);
+        REQUIRE(slv->value(q) == true);
+        REQUIRE(slv->value(r) == true);
+
+        slv->assert_formulas(std::vector<black::formula>{ !r });
+        REQUIRE(!slv->is_sat());
+
+        slv->clear();
+        slv->assert_formulas({});
+        REQUIRE(slv->is_sat());
+      }
+    }
+  }
+
+}
+
+TEST_CASE("Recycled backend instances") {
+
+  std::vector<std::string> backends = {
+    "z3", "mathsat", "cmsat", "cvc5"
+  };
+
+  for(auto backend : backends) {
+    DYNAMIC_SECTION("SAT backend: " << backend) {
+      if(black::sat::solver::backend_exists(backend)) {
+        black::alphabet sigma1;
+        black::scope xi1{sigma1};
+        auto p = sigma1.proposition("p");
+
+        auto slv = black::sat::solver::get_solver(backend, xi1);
+        slv->assert_formula(p && !p);
+        REQUIRE(!slv->is_sat());
+
+        black::sat::solver::recycle(std::move(slv));
+
+        black::alphabet sigma2;
+        black::scope xi2{sigma2};
+        auto q = sigma2.proposition("q");
+
+        slv = black::sat::solver::get_solver(backend, xi2);
+        slv->assert_formula(q);
+        REQUIRE(slv->is_sat());
+        REQUIRE(slv->value(q) == true);
+      }
+    }
+  }
+
+}
+
+TEST_CASE("Unsat assumptions") {
+
+  std::vector<std::string> backends = {
+    "z3", "mathsat", "cmsat", "cvc5"
+  };
+
+  black::alphabet sigma;
+  black::scope xi{sigma};
+
+  auto p = sigma.proposition("p");
+  auto q = sigma.proposition("q");
+  auto r = sigma.proposition("r");
+  auto s = sigma.proposition("s");
+
+  for(auto backend : backends) {
+    DYNAMIC_SECTION("SAT backend: " << backend) {
+      if(black::sat::solver::backend_exists(backend)) {
+        auto slv = black::sat::solver::get_solver(backend, xi);
+
+        slv->assert_formulas(std::vector<black::formula>{
+          implies(p, q), implies(q, r)
+        });
+
+        REQUIRE(slv->is_sat_assuming(std::vector<black::formula>{p, s}));
+        REQUIRE(slv->value(r) == true);
+
+        std::vector<black::formula> assumptions = { s, p, !r };
+        REQUIRE(!slv->is_sat_assuming(assumptions));
+
+        std::vector<black::formula> core = slv->unsat_assumptions();
+        for(black::formula a : core)
+          REQUIRE(
+            std::find(assumptions.begin(), assumptions.end(), a) != 
+            assumptions.end()
+          );
+        REQUIRE(!slv->is_sat_assuming(core));
+
+        REQUIRE(slv->is_sat_assuming({}));
+      }
+    }
+  }
+
+}
+
+TEST_CASE("Pending interrupts") {
+
+  black::alphabet sigma;
+  black::scope xi{sigma};
+
+  auto p = sigma.proposition("p");
+
+  if(black::sat::solver::backend_exists("z3")) {
+    auto slv = black::sat::solver::get_solver("z3", xi);
+    slv->assert_formula(p);
+
+    // an interrupt() made between two checks cancels only the next one
+    slv->interrupt();
+    REQUIRE(slv->is_sat_assuming({}) == black::tribool::undef);
+    REQUIRE(slv->is_sat_assuming({}) == true);
+    REQUIRE(slv->value(p) == true);
+
+    // and it does not survive a clear()
+    slv->interrupt();
+    slv->clear();
+    slv->assert_formula(p && !p);
+    REQUIRE(slv->is_sat() == false);
+  }
+}
@@ -0,0 +1,182 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <catch.hpp>
+
+#include <black/logic/logic.hpp>
+#include <black/logic/prettyprint.hpp>
+#include <black/logic/past_remover.hpp>
+#include <black/logic/serialization.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace black;
+
+static std::string serialized(std::vector<formula> const& formulas) {
+  std::ostringstream out;
+  bool ok = serialize(out, formulas, [](std::string error) {
+    INFO("serialization error: " << error);
+    REQUIRE(false);
+  });
+  REQUIRE(ok);
+  return out.str();
+}
+
+static std::span<std::byte const> bytes(std::string const& s) {
+  return std::as_bytes(std::span{s});
+}
+
+TEST_CASE("Binary serialization")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  proposition q = sigma.proposition("q");
+  variable x = sigma.variable("x");
+  variable y = sigma.variable("y");
+  function g = sigma.function("g");
+  relation r = sigma.relation("r");
+  sort s = sigma.integer_sort();
+  sort t = sigma.named_sort("T");
+
+  std::vector<formula> tests = {
+    p, sigma.top(), !p && sigma.bottom(), X(p), wX(p), Y(p), Z(p), F(p), 
+    G(p), O(p), H(p), U(p, q), R(p, q), W(p, q), M(p, q), S(p, q), T(p, q),
+    implies(p, q), iff(p, q), big_and(sigma, std::vector<formula>{p, q, X(p), F(q)}),
+    big_or(sigma, std::vector<formula>{p, q, Y(p)}), sigma.proposition(42),
+    forall({x[s], y[t]}, r(x, y) && g(x + 1, y) == y),
+    exists({x[s]}, x * 2 > y && next(x) <= wnext(y) && x != y),
+    exists({x[sigma.real_sort()]}, -x < 1.5 && x / 3 >= to_integer(x)),
+    prev(x) - wprev(y) == 0
+  };
+
+  SECTION("Roundtrip in the same alphabet") {
+    std::string data = serialized(tests);
+    auto result = deserialize(sigma, bytes(data), [](auto error) {
+      INFO("deserialization error: " << error);
+      REQUIRE(false);
+    });
+
+    REQUIRE(result.has_value());
+    REQUIRE(result->size() == tests.size());
+    for(size_t i = 0; i < tests.size(); ++i)
+      CHECK(result->at(i) == tests[i]);
+  }
+
+  SECTION("Roundtrip in another alphabet") {
+    std::string data = serialized(tests);
+    
+    alphabet sigma2;
+    auto result = deserialize(sigma2, bytes(data), [](auto) { });
+
+    REQUIRE(result.has_value());
+    REQUIRE(result->size() == tests.size());
+    for(size_t i = 0; i < tests.size(); ++i) {
+      CHECK(result->at(i).sigma() == &sigma2);
+      CHECK(to_string(result->at(i)) == to_string(tests[i]));
+    }
+  }
+
+  SECTION("Sharing is preserved") {
+    formula f = p;
+    for(int i = 0; i < 100; ++i)
+      f = f && X(f);
+    
+    REQUIRE(tree_size(f) == UINT32_MAX);
+
+    std::string data = serialized({f});
+    REQUIRE(data.size() < 5000);
+
+    alphabet sigma2;
+    auto result = deserialize(sigma2, bytes(data), [](auto) { });
+    REQUIRE(result.has_value());
+    REQUIRE(result->size() == 1);
+    REQUIRE(tree_depth(result->front()) == tree_depth(f));
+    REQUIRE(serialized(*result) == data);
+  }
+
+  SECTION("Formulas after past removal") {
+    formula f = G(implies(p, O(q) || Y(S(p, q))));
+    formula nopast = remove_past(f);
+
+    std::string data = serialized({nopast});
+    auto result = deserialize(sigma, bytes(data), [](auto) { });
+    REQUIRE(result.has_value());
+    REQUIRE(result->front() == nopast);
+  }
+
+  SECTION("Unsupported labels") {
+    formula f = p && sigma.proposition(std::pair{1, 2});
+
+    std::ostringstream out;
+    bool error = false;
+    REQUIRE(!serialize(out, f, [&](auto) { error = true; }));
+    REQUIRE(error);
+    REQUIRE(out.str().empty());
+  }
+
+  SECTION("Malformed data") {
+    std::string data = serialized(tests);
+
+    for(size_t size = 0; size < data.size(); size += 4) {
+      bool error = false;
+      auto result = deserialize(
+        sigma, bytes(data).first(size), [&](auto) { error = true; }
+      );
+      REQUIRE(error);
+      REQUIRE(!result.has_value());
+    }
+
+    std::string garbage = data;
+    garbage[0] = 'X';
+    bool error = false;
+    REQUIRE(!deserialize(sigma, bytes(garbage), [&](auto) { error = true; }));
+    REQUIRE(error);
+  }
+
+  SECTION("Loading from files") {
+    std::string data = serialized(tests);
+    std::filesystem::path path = 
+      std::filesystem::temp_directory_path() / "black-serialization-test.bin";
+
+    {
+      std::ofstream out{path, std::ios::binary};
+      out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    auto result = load_formulas(sigma, path.string(), [](auto) { });
+    std::filesystem::remove(path);
+
+    REQUIRE(result.has_value());
+    REQUIRE(*result == tests);
+
+    bool error = false;
+    auto missing = load_formulas(sigma, path.string(), [&](auto) { 
+      error = true; 
+    });
+    REQUIRE(error);
+    REQUIRE(!missing.has_value());
+  }
+}
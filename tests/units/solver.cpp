@@ -27,11 +27,49 @@
 #include <black/logic/logic.hpp>
 #include <black/logic/parser.hpp>
 #include <black/logic/prettyprint.hpp>
+#include <black/logic/cnf.hpp>
 #include <black/solver/solver.hpp>
+#include <black/solver/core.hpp>
 #include <black/sat/solver.hpp>
 
 using namespace black;
 
+//
+// Replaces all the occurrences of `g` inside `f` with `fresh`, and collects
+// the distinct non-atomic subformulas found along the way
+//
+static formula drop(
+  formula f, formula g, formula fresh, std::vector<formula> &subfs
+) {
+  if(f == g)
+    return fresh;
+
+  formula result = f.match(
+    [&](unary u, formula arg) {
+      return unary(u.node_type(), drop(arg, g, fresh, subfs));
+    },
+    [&](binary b, formula left, formula right) {
+      return binary(
+        b.node_type(), 
+        drop(left, g, fresh, subfs), drop(right, g, fresh, subfs)
+      );
+    },
+    [&](nary n, auto operands) {
+      std::vector<formula> newops;
+      for(formula op : operands)
+        newops.push_back(drop(op, g, fresh, subfs));
+      return nary(n.node_type(), newops);
+    },
+    [&](otherwise) { return f; }
+  );
+
+  if(!f.is<proposition>() && !f.is<boolean>() &&
+     std::find(subfs.begin(), subfs.end(), f) == subfs.end())
+    subfs.push_back(f);
+
+  return result;
+}
+
 TEST_CASE("Solver")
 {
   alphabet sigma; // testing move constructor and assignment
@@ -114,6 +152,84 @@ TEST_CASE("Solver")
     }
   }
 
+  SECTION("Batches of the k-unraveling") {
+    auto p = sigma.proposition("p");
+    auto q = sigma.proposition("q");
+    auto r = sigma.proposition("r");
+    auto s = sigma.proposition("s");
+
+    // unsatisfiable, but without the PRUNE the solver goes up to the bound
+    formula f = F(p) && F(q) && G(F(r)) && X(X(G(!r && s)));
+
+    std::vector<size_t> batches;
+    black::solver slv;
+    slv.set_tracer([&](black::solver::trace_t data) {
+      if(data.type != black::solver::trace_t::unrav)
+        return;
+
+      auto batch = black_internal::cnf::conjuncts(
+        std::get<formula>(data.data)
+      );
+      for(formula c : batch)
+        REQUIRE(!c.is<conjunction>());
+      batches.push_back(batch.size());
+    });
+
+    REQUIRE(slv.solve(xi, f, false, 3, {}, true) == tribool::undef);
+    
+    // each unraveling after the first one encodes the requests of the 7
+    // temporal operators separately, while splitting only the top-level
+    // conjunction would give a batch of 4 formulas
+    REQUIRE(batches.size() == 4);
+    for(size_t k = 1; k < batches.size(); ++k)
+      REQUIRE(batches[k] >= 7);
+
+    formula nested = big_and(sigma, std::vector<formula>{p, q && (r && p)});
+    REQUIRE(
+      black_internal::cnf::conjuncts(nested && s) == 
+        std::vector<formula>{p, q, r, s}
+    );
+  }
+
+  SECTION("Time-indexed encoding of first-order symbols") {
+    
+    xi.set_default_sort(sigma.integer_sort());
+
+    auto x = sigma.variable("x");
+    auto rel = sigma.relation("r");
+    auto f = sigma.function("f");
+
+    xi.declare(rel, {sigma.integer_sort()});
+    xi.declare(f, sigma.integer_sort(), {sigma.integer_sort()});
+
+    black::solver slv;
+    REQUIRE(!slv.timed_encoding());
+    slv.set_timed_encoding(true);
+    REQUIRE(slv.timed_encoding());
+
+    std::vector<formula> sat = {
+      G(x > 0), F(x == 1), rel(wnext(x)), X(prev(x) == x), 
+      x == 0 && G(wnext(x) == x + 1) && F(x == 3), F(f(x) != f(wnext(x)))
+    };
+    std::vector<formula> unsat = {
+      x == 0 && x != 0, G(rel(x)) && F(!rel(x)), 
+      G(f(x) == 1) && F(f(x) == 2)
+    };
+
+    for(auto phi : sat) {
+      DYNAMIC_SECTION("Formula: " << to_string(phi)) {
+        REQUIRE(slv.solve(
+          xi, phi, true, std::numeric_limits<size_t>::max(), {}, true
+        ));
+      }
+    }
+    for(auto phi : unsat) {
+      DYNAMIC_SECTION("Formula: " << to_string(phi)) {
+        REQUIRE(!slv.solve(xi, phi, true));
+      }
+    }
+  }
+
   SECTION("Querying the first-order models") {
 
     auto x = sigma.variable("x");
@@ -233,3 +349,105 @@ TEST_CASE("Solver")
   }
 
 }
+
+TEST_CASE("Unsat cores")
+{
+  alphabet sigma;
+  scope xi{sigma};
+
+  auto p = sigma.proposition("p");
+  auto q = sigma.proposition("q");
+  auto r = sigma.proposition("r");
+  auto w = sigma.proposition("w");
+  auto c = sigma.proposition("c");
+
+  SECTION("Replacements") {
+    formula f = G(U(p, q && w) && c) && F(U(r, sigma.top()) && sigma.bottom());
+
+    REQUIRE(to_string(unsat_core(xi, f, false)) == "{0} & F({1} & False)");
+    REQUIRE(
+      to_string(unsat_core(xi, f, false, 4)) == "{0} & F({1} & False)"
+    );
+    REQUIRE(
+      to_string(unsat_core(xi, f, false, 1, 2)) == "{0} & F({1} & False)"
+    );
+  }
+
+  SECTION("Releasing a region with the core as root") {
+    auto region = sigma.open_region();
+
+    formula muc = sigma.top();
+    {
+      scope local{sigma};
+      formula f = 
+        G(U(p, q && w) && c) && F(U(r, sigma.top()) && sigma.bottom());
+      muc = unsat_core(local, f, false);
+    }
+    REQUIRE(to_string(muc) == "{0} & F({1} & False)");
+
+    sigma.release(region, muc);
+
+    // the freed slots are reused by unrelated formulas
+    for(int i = 0; i < 100; ++i)
+      (void)X(F(sigma.proposition(i)) && sigma.proposition(i + 1));
+
+    auto label = [](formula h) {
+      return h.to<proposition>()->name().to<core_placeholder_t>();
+    };
+    
+    auto c0 = label(muc.to<conjunction>()->left());
+    auto c1 = label(
+      muc.to<conjunction>()->right().to<eventually>()->argument()
+        .to<conjunction>()->left()
+    );
+    REQUIRE(c0.has_value());
+    REQUIRE(c1.has_value());
+
+    // the formulas in the placeholders are still alive and hash-consed
+    REQUIRE(c0->f == G(U(p, q && w) && c));
+    REQUIRE(c1->f == U(r, sigma.top()));
+    REQUIRE(
+      unsat_core(
+        xi, G(U(p, q && w) && c) && F(U(r, sigma.top()) && sigma.bottom()), 
+        false
+      ) == muc
+    );
+  }
+
+  SECTION("Minimality") {
+    std::vector<formula> tests = {
+      p && !p, G(p) && F(!p) && X(q), G(implies(p, X(p))) && p && F(!p),
+      X(p && q) && X(!q || r) && G(!r), !p && X(p) && Y(p),
+      F(p && q) && G(implies(q, !p)) && U(r, w), 
+      wX(p) && X(!p) && G(iff(p, q)) && F(w)
+    };
+
+    for(size_t threads : {1, 4}) {
+      for(bool finite : {false, true}) {
+        for(formula f : tests) {
+          DYNAMIC_SECTION(
+            "Formula: " << to_string(f) << (finite ? " (LTLf)" : "") << 
+            ", threads: " << threads
+          ) {
+            black::solver slv;
+            REQUIRE(!slv.solve(xi, f, finite));
+
+            formula muc = unsat_core(xi, f, finite, threads);
+            REQUIRE(!slv.solve(xi, muc, finite));
+
+            // dropping any subformula left in the core makes it satisfiable
+            std::vector<formula> subfs;
+            drop(muc, sigma.top(), sigma.top(), subfs);
+
+            for(formula g : subfs) {
+              auto fresh = sigma.proposition(core_placeholder_t{1000, g});
+              std::vector<formula> ignored;
+              formula weaker = drop(muc, g, fresh, ignored);
+              REQUIRE(slv.solve(xi, weaker, finite));
+            }
+          }
+        }
+      }
+    }
+  }
+}
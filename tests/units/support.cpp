@@ -146,6 +146,33 @@ TEST_CASE("identifier class")
     REQUIRE(h1 == h2);
   }
 
+  SECTION("Equal hashes of different types") {
+    identifier h1{42};
+    identifier h2{42L};
+
+    REQUIRE(h1.hash() == h2.hash());
+    REQUIRE(!(h1 == h2));
+    REQUIRE(h1 == identifier{42});
+  }
+
+  SECTION("Large labels") {
+    using large_t = std::tuple<std::string, std::string, std::string>;
+    large_t t = {"a long enough string to avoid SSO", "b", "c"};
+
+    identifier h1{t};
+    identifier h2 = h1;
+    identifier h3 = std::move(h1);
+
+    REQUIRE(h2 == h3);
+    REQUIRE(h2.hash() == identifier{t}.hash());
+    REQUIRE(h3.to<large_t>() == t);
+    REQUIRE(!h3.is<std::string>());
+
+    h2 = "short";
+    REQUIRE(h2.to<std::string>() == "short");
+    REQUIRE(h3.to<large_t>() == t);
+  }
+
   SECTION("Class types") {
     std::string s1 = "hello";
     std::string s2 = "goodbye";
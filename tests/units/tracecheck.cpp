@@ -0,0 +1,286 @@
+//
+// BLACK - Bounded Ltl sAtisfiability ChecKer
+//
+// (C) 2022 Nicola Gigante
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <catch.hpp>
+
+#include <black/logic/logic.hpp>
+#include <black/logic/prettyprint.hpp>
+#include <black/solver/tracecheck.hpp>
+#include <black/internal/debug/random_formula.hpp>
+
+#include <random>
+
+using namespace black;
+
+//
+// A trace where `p` holds at the times in `ps` and `q` at the times in `qs`,
+// for a checker of a formula with propositions `p` and `q`.
+//
+static black::trace make_trace(
+  trace_checker const& checker, proposition p, proposition q,
+  size_t size, std::optional<size_t> loop,
+  std::vector<size_t> const& ps, std::vector<size_t> const& qs
+) {
+  black::trace tr{checker.propositions().size(), size, loop};
+  for(size_t i = 0; i < checker.propositions().size(); ++i) {
+    proposition a = checker.propositions()[i];
+    for(size_t t = 0; t < size; ++t)
+      tr.set(i, t, false);
+    if(a == p)
+      for(size_t t : ps)
+        tr.set(i, t, true);
+    if(a == q)
+      for(size_t t : qs)
+        tr.set(i, t, true);
+  }
+  return tr;
+}
+
+TEST_CASE("Trace checking")
+{
+  alphabet sigma;
+
+  proposition p = sigma.proposition("p");
+  proposition q = sigma.proposition("q");
+
+  SECTION("Finite traces") {
+    // p at 0 and 2, q at 3
+    struct test {
+      formula f;
+      std::vector<bool> values;
+    };
+    
+    std::vector<test> tests = {
+      {X(p), {false, true, false, false}},
+      {wX(p), {false, true, false, true}},
+      {Y(p), {false, true, false, true}},
+      {Z(p), {true, true, false, true}},
+      {F(q), {true, true, true, true}},
+      {G(!q), {false, false, false, false}},
+      {F(p), {true, true, true, false}},
+      {U(p || !q, q), {true, true, true, true}},
+      {U(p, q), {false, false, true, true}},
+      {R(p, !q), {true, true, true, false}},
+      {W(!q, p), {true, true, true, false}},
+      {M(q, !q), {false, false, false, false}},
+      {S(!q, p), {true, true, true, false}},
+      {T(q, !p), {false, false, false, true}},
+      {O(q), {false, false, false, true}},
+      {H(!q), {true, true, true, false}},
+      {iff(p, Y(Y(p))), {false, true, true, true}},
+      {implies(q, O(p)) && !(p && q), {true, true, true, true}},
+    };
+
+    for(auto [f, values] : tests) {
+      trace_checker checker{f};
+      black::trace tr = 
+        make_trace(checker, p, q, 4, std::nullopt, {0, 2}, {3});
+      
+      for(size_t t = 0; t < values.size(); ++t)
+        DYNAMIC_SECTION("Formula: " << to_string(f) << " at t = " << t) {
+          REQUIRE(checker.check(tr, t) == values[t]);
+        }
+    }
+  }
+
+  SECTION("Infinite traces") {
+    // p at 0, then q and p alternating forever from 1
+    trace_checker fq{F(q)};
+    black::trace tr = make_trace(fq, p, q, 3, 1, {0, 2}, {1});
+    
+    REQUIRE(fq.check(tr, 0));
+    REQUIRE(fq.check(tr, 1000));
+
+    trace_checker gfp{G(F(p)) && !F(G(q))};
+    tr = make_trace(gfp, p, q, 3, 1, {0, 2}, {1});
+    REQUIRE(gfp.check(tr, 0));
+    REQUIRE(gfp.check(tr, 12345));
+
+    trace_checker yp{G(implies(q, Y(p)))};
+    tr = make_trace(yp, p, q, 3, 1, {0, 2}, {1});
+    REQUIRE(yp.check(tr, 0));
+
+    trace_checker ypq{G(implies(q, Y(p) && Y(Y(q))))};
+    tr = make_trace(ypq, p, q, 3, 1, {0, 2}, {1});
+    REQUIRE(!ypq.check(tr, 0));
+    REQUIRE(ypq.check(tr, 3));
+
+    std::vector<std::string> report;
+    trace_checker xp{X(p) || q};
+    tr = make_trace(xp, p, q, 3, 1, {0, 2}, {1});
+    REQUIRE(xp.check(tr, 1, [&](formula f, bool value) {
+      report.push_back(to_string(f) + (value ? " true" : " false"));
+    }));
+    REQUIRE(
+      report == std::vector<std::string>{
+        "p false", "X p true", "q true", "X p | q true"
+      }
+    );
+  }
+
+  SECTION("Unrolled loops") {
+    std::mt19937 gen((std::random_device())());
+    std::uniform_int_distribution<size_t> sizes{1, 100};
+    std::bernoulli_distribution coin;
+
+    std::vector<std::string> symbols = { "p", "q", "r" };
+
+    for(int i = 0; i < 50; ++i) {
+      formula f = random_ltlp_formula(gen, sigma, 12, symbols);
+      trace_checker checker{f};
+      size_t n = checker.propositions().size();
+
+      size_t size = sizes(gen);
+      size_t loop = 
+        std::uniform_int_distribution<size_t>{0, size - 1}(gen);
+      size_t period = size - loop;
+
+      // the same trace, with the loop unrolled twice more
+      black::trace tr{n, size, loop};
+      black::trace unrolled{n, size + 2 * period, loop + 2 * period};
+      for(size_t a = 0; a < n; ++a)
+        for(size_t t = 0; t < size; ++t) {
+          bool value = coin(gen);
+          tr.set(a, t, value);
+          unrolled.set(a, t, value);
+          if(t >= loop) {
+            unrolled.set(a, t + period, value);
+            unrolled.set(a, t + 2 * period, value);
+          }
+        }
+
+      INFO("Formula: " << to_string(f));
+      for(size_t t = 0; t < 3 * size; ++t)
+        REQUIRE(checker.check(tr, t) == checker.check(unrolled, t));
+    }
+  }
+}
+
+TEST_CASE("Monitoring")
+{
+  alphabet sigma;
+
+  std::mt19937 gen((std::random_device())());
+  std::uniform_int_distribution<size_t> sizes{1, 80};
+  std::uniform_int_distribution<size_t> lookaheads{0, 70};
+  std::bernoulli_distribution coin;
+
+  std::vector<std::string> symbols = { "p", "q", "r" };
+
+  SECTION("Finite traces") {
+    for(int i = 0; i < 50; ++i) {
+      formula f = random_ltlp_formula(gen, sigma, 12, symbols);
+      trace_checker checker{f};
+      size_t size = sizes(gen);
+      size_t lookahead = lookaheads(gen);
+      black::monitor mon{f, lookahead};
+      REQUIRE(mon.propositions() == checker.propositions());
+      
+      size_t n = checker.propositions().size();
+      black::trace tr{n, size, std::nullopt};
+
+      std::vector<tribool> verdicts;
+      for(size_t t = 0; t < size; ++t) {
+        std::vector<bool> state(n);
+        for(size_t a = 0; a < n; ++a) {
+          state[a] = coin(gen);
+          tr.set(a, t, state[a]);
+        }
+        if(auto v = mon.push(state); v)
+          verdicts.push_back(*v);
+      }
+      for(tribool v : mon.finish(true))
+        verdicts.push_back(v);
+
+      // verdicts given before the end of the trace can be unknown, but
+      // they are exact if no verdict has been given before the end
+      INFO("Formula: " << to_string(f));
+      REQUIRE(verdicts.size() == size);
+      for(size_t t = 0; t < size; ++t)
+        if(lookahead >= size || verdicts[t] != tribool::undef)
+          REQUIRE(verdicts[t] == checker.check(tr, t));
+    }
+  }
+
+  SECTION("Prefixes of infinite traces") {
+    for(int i = 0; i < 50; ++i) {
+      formula f = random_ltlp_formula(gen, sigma, 12, symbols);
+      trace_checker checker{f};
+      black::monitor mon{f, lookaheads(gen)};
+      
+      size_t n = checker.propositions().size();
+      size_t size = sizes(gen);
+      size_t loop = 
+        std::uniform_int_distribution<size_t>{0, size - 1}(gen);
+      black::trace tr{n, size, loop};
+      for(size_t a = 0; a < n; ++a)
+        for(size_t t = 0; t < size; ++t)
+          tr.set(a, t, coin(gen));
+
+      std::vector<tribool> verdicts;
+      for(size_t t = 0; t < 3 * size; ++t) {
+        size_t s = t < size ? t : loop + (t - loop) % (size - loop);
+        std::vector<bool> state(n);
+        for(size_t a = 0; a < n; ++a)
+          state[a] = tr.value(a, s);
+        if(auto v = mon.push(state); v)
+          verdicts.push_back(*v);
+      }
+      for(tribool v : mon.finish(false))
+        verdicts.push_back(v);
+
+      INFO("Formula: " << to_string(f));
+      REQUIRE(verdicts.size() == 3 * size);
+      for(size_t t = 0; t < verdicts.size(); ++t)
+        if(verdicts[t] != tribool::undef)
+          REQUIRE(verdicts[t] == checker.check(tr, t));
+    }
+  }
+
+  SECTION("Past formulas") {
+    proposition p = sigma.proposition("p");
+    proposition q = sigma.proposition("q");
+
+    // q has been true at every other state since p
+    formula f = implies(q, S(implies(Y(q), !q), p));
+    black::monitor mon{f, 0};
+    
+    std::vector<std::vector<bool>> states = {
+      {true, false}, {false, true}, {false, false}, {false, true},
+      {false, true}
+    };
+    std::vector<bool> expected = {true, true, true, true, false};
+
+    std::vector<bool> values;
+    for(auto state : states) {
+      if(mon.propositions()[0] != p)
+        state = {state[1], state[0]};
+      auto v = mon.push(state);
+      REQUIRE(v.has_value());
+      REQUIRE(*v != tribool::undef);
+      values.push_back(*v == true);
+    }
+    REQUIRE(mon.finish(false).empty());
+    REQUIRE(values == expected);
+  }
+}